@@ -639,14 +639,14 @@ namespace fc::api {
 
       std::vector<CID> result;
 
-      while (static_cast<int64_t>(context.tipset->height()) >= to_height) {
+      auto visitTipset = [&](const TipsetCPtr &ts) -> outcome::result<void> {
         std::set<CID> visited_cid;
 
         auto isDuplicateMessage = [&](const CID &cid) -> bool {
           return !visited_cid.insert(cid).second;
         };
 
-        for (const BlockHeader &block : context.tipset->blks) {
+        for (const BlockHeader &block : ts->blks) {
           OUTCOME_TRY(meta, getCbor<MsgMeta>(ipld, block.messages));
           OUTCOME_TRY(meta.bls_messages.visit(
               [&](auto, auto &cid) -> outcome::result<void> {
@@ -668,6 +668,25 @@ namespace fc::api {
                 return outcome::success();
               }));
         }
+        return outcome::success();
+      };
+
+      // messages of older tipsets are in index, only head is visited
+      if (static_cast<int64_t>(context.tipset->height()) >= to_height) {
+        if (auto indexed{
+                msg_waiter->list(context.tipset, match.from, to_height)}) {
+          OUTCOME_TRY(visitTipset(context.tipset));
+          for (const auto &message : *indexed) {
+            if (message.from == match.from && message.to == match.to) {
+              result.push_back(message.cid);
+            }
+          }
+          return result;
+        }
+      }
+
+      while (static_cast<int64_t>(context.tipset->height()) >= to_height) {
+        OUTCOME_TRY(visitTipset(context.tipset));
 
         if (context.tipset->height() == 0) break;
 
@@ -0,0 +1,71 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "api/rpc/broadcast.hpp"
+
+#include <algorithm>
+
+namespace fc::api::rpc {
+  Broadcast::Broadcast(Permission perm, Initial initial)
+      : perm_{std::move(perm)}, initial_{std::move(initial)} {}
+
+  void Broadcast::writeJson(const SharedJson &json) {
+    std::lock_guard lock{mutex_};
+    // sessions report failed writes asynchronously, remove them here
+    subscribers_.erase(
+        std::remove_if(subscribers_.begin(),
+                       subscribers_.end(),
+                       [](auto &subscriber) { return subscriber->closed; }),
+        subscribers_.end());
+    for (const auto &subscriber : subscribers_) {
+      send(subscriber, json);
+    }
+  }
+
+  size_t Broadcast::size() const {
+    std::lock_guard lock{mutex_};
+    return subscribers_.size();
+  }
+
+  Method Broadcast::method() {
+    return [self{shared_from_this()}](const Value &,
+                                      Respond respond,
+                                      MakeChan make_chan,
+                                      Send send,
+                                      const Permissions &perms) {
+      if (!primitives::jwt::hasPermission(perms, self->perm_)) {
+        return respond(
+            Response::Error{kInvalidParams, "Missing permission to invoke"});
+      }
+      if (!make_chan || !send) {
+        return respond(
+            Response::Error{kInvalidParams, "Channels are not supported"});
+      }
+      auto subscriber{std::make_shared<Subscriber>()};
+      subscriber->chan = make_chan();
+      subscriber->send = std::move(send);
+      respond(codec::json::encode(subscriber->chan));
+      // initial value is sent before values written after it
+      std::lock_guard lock{self->mutex_};
+      if (self->initial_) {
+        if (auto json{self->initial_()}) {
+          self->send(subscriber, json);
+        }
+      }
+      self->subscribers_.push_back(std::move(subscriber));
+    };
+  }
+
+  void Broadcast::send(const std::shared_ptr<Subscriber> &subscriber,
+                       const SharedJson &json) {
+    subscriber->send(kRpcChVal,
+                     SharedChanValue{subscriber->chan, json},
+                     [weak{std::weak_ptr{subscriber}}](bool ok) {
+                       if (auto subscriber{weak.lock()}; subscriber && !ok) {
+                         subscriber->closed = true;
+                       }
+                     });
+  }
+}  // namespace fc::api::rpc
@@ -0,0 +1,67 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "api/rpc/json.hpp"
+#include "api/rpc/rpc.hpp"
+#include "codec/json/json.hpp"
+
+namespace fc::api::rpc {
+  /**
+   * Rpc method returning channel, which values are written to all subscribed
+   * sessions, like ChainNotify.
+   * Each value is encoded to json once, sessions splice the same immutable
+   * buffer into their requests. Subscriber is removed when session fails to
+   * write value, e.g. closed or too slow.
+   */
+  class Broadcast : public std::enable_shared_from_this<Broadcast> {
+   public:
+    using SharedJson = std::shared_ptr<const Bytes>;
+    /** first value for new subscriber, null if none */
+    using Initial = std::function<SharedJson()>;
+
+    explicit Broadcast(Permission perm, Initial initial = {});
+
+    template <typename T>
+    static SharedJson encode(const T &value) {
+      return std::make_shared<const Bytes>(
+          *codec::json::format(codec::json::encode(value)));
+    }
+
+    /** encodes value once and writes it to subscribers */
+    template <typename T>
+    void write(const T &value) {
+      if (size() != 0) {
+        writeJson(encode(value));
+      }
+    }
+
+    void writeJson(const SharedJson &json);
+
+    size_t size() const;
+
+    /** method for rpc, subscribes session */
+    Method method();
+
+   private:
+    struct Subscriber {
+      uint64_t chan{};
+      Send send;
+      std::atomic_bool closed{false};
+    };
+
+    void send(const std::shared_ptr<Subscriber> &subscriber,
+              const SharedJson &json);
+
+    Permission perm_;
+    Initial initial_;
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<Subscriber>> subscribers_;
+  };
+}  // namespace fc::api::rpc
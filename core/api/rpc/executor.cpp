@@ -0,0 +1,221 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "api/rpc/executor.hpp"
+
+#include <algorithm>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <prometheus/counter.h>
+#include <prometheus/gauge.h>
+
+#include "common/prometheus/metrics.hpp"
+
+namespace fc::api::rpc {
+  inline auto &metricQueueDepth() {
+    static auto &x{prometheus::BuildGauge()
+                       .Name("lotus_api_queue_depth")
+                       .Help("API calls waiting for worker")
+                       .Register(prometheusRegistry())
+                       .Add({})};
+    return x;
+  }
+
+  inline auto &metricRejected() {
+    static auto &x{prometheus::BuildCounter()
+                       .Name("lotus_api_rejected")
+                       .Help("API calls rejected because queue is full")
+                       .Register(prometheusRegistry())};
+    return x;
+  }
+
+  /** params are owned by request, which is destroyed after method returns */
+  inline auto copyParams(const Value &value) {
+    auto params{std::make_shared<Document>()};
+    params->CopyFrom(value, params->GetAllocator());
+    return params;
+  }
+
+  const std::set<std::string> &parallelMethods() {
+    static const std::set<std::string> methods{
+        "Filecoin.ChainGetBlock",
+        "Filecoin.ChainGetBlockMessages",
+        "Filecoin.ChainGetMessage",
+        "Filecoin.ChainGetNode",
+        "Filecoin.ChainGetParentMessages",
+        "Filecoin.ChainGetParentReceipts",
+        "Filecoin.ChainGetTipSet",
+        "Filecoin.ChainReadObj",
+        // state of tipset without interpretation
+        "Filecoin.StateAccountKey",
+        "Filecoin.StateListMessages",
+        "Filecoin.StateListMiners",
+        "Filecoin.StateLookupID",
+        "Filecoin.StateMarketBalance",
+        "Filecoin.StateMarketDeals",
+        "Filecoin.StateMarketStorageDeal",
+        "Filecoin.StateMinerActiveSectors",
+        "Filecoin.StateMinerAvailableBalance",
+        "Filecoin.StateMinerDeadlines",
+        "Filecoin.StateMinerFaults",
+        "Filecoin.StateMinerInfo",
+        "Filecoin.StateMinerPartitions",
+        "Filecoin.StateMinerPower",
+        "Filecoin.StateMinerProvingDeadline",
+        "Filecoin.StateMinerSectorAllocated",
+        "Filecoin.StateMinerSectors",
+        "Filecoin.StateNetworkName",
+        "Filecoin.StateNetworkVersion",
+        "Filecoin.StateReadState",
+        "Filecoin.StateSectorExpiration",
+        "Filecoin.StateSectorGetInfo",
+        "Filecoin.StateSectorPartition",
+    };
+    return methods;
+  }
+
+  Executor::Executor(size_t threads,
+                     size_t queue_limit,
+                     std::shared_ptr<io_context> serial)
+      : default_limit_{std::max<size_t>(1, threads / 2)},
+        queue_limit_{queue_limit},
+        serial_{std::move(serial)} {
+    for (size_t i{0}; i < threads; ++i) {
+      threads_.emplace_back([this] { loop(); });
+    }
+  }
+
+  Executor::~Executor() {
+    {
+      std::lock_guard lock{mutex_};
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void Executor::limit(const std::string &method, size_t max) {
+    limits_[method].max = std::max<size_t>(1, max);
+  }
+
+  void Executor::parallel(const std::string &method) {
+    parallel_.insert(method);
+  }
+
+  void Executor::wrap(Rpc &rpc) {
+    for (auto &[name, method] : rpc.ms) {
+      if (method) {
+        method = wrap(name, std::move(method));
+      }
+    }
+  }
+
+  size_t Executor::queued() const {
+    std::lock_guard lock{mutex_};
+    return queue_.size();
+  }
+
+  Method Executor::wrap(const std::string &name, Method method) {
+    if (parallel_.count(name) == 0 || threads_.empty()) {
+      return [serial{serial_}, method{std::move(method)}](
+                 const Value &value,
+                 Respond respond,
+                 MakeChan make_chan,
+                 Send send,
+                 const Permissions &perms) {
+        boost::asio::post(*serial,
+                          [method,
+                           params{copyParams(value)},
+                           respond{std::move(respond)},
+                           make_chan{std::move(make_chan)},
+                           send{std::move(send)},
+                           perms]() mutable {
+                            method(*params,
+                                   std::move(respond),
+                                   std::move(make_chan),
+                                   std::move(send),
+                                   perms);
+                          });
+      };
+    }
+    auto &limit{limits_[name]};
+    if (limit.max == 0) {
+      limit.max = default_limit_;
+    }
+    return [this, name, &limit, method{std::move(method)}](
+               const Value &value,
+               Respond respond,
+               MakeChan make_chan,
+               Send send,
+               const Permissions &perms) {
+      auto pushed{push(limit,
+                       [method,
+                        params{copyParams(value)},
+                        respond,
+                        make_chan{std::move(make_chan)},
+                        send{std::move(send)},
+                        perms]() mutable {
+                         method(*params,
+                                std::move(respond),
+                                std::move(make_chan),
+                                std::move(send),
+                                perms);
+                       })};
+      if (!pushed) {
+        metricRejected().Add({{"endpoint", name}}).Increment();
+        respond(Response::Error{kServerBusy, "Server busy"});
+      }
+    };
+  }
+
+  bool Executor::push(Limit &limit, std::function<void()> &&run) {
+    {
+      std::lock_guard lock{mutex_};
+      if (queue_.size() >= queue_limit_) {
+        return false;
+      }
+      queue_.push_back({&limit, std::move(run)});
+      metricQueueDepth().Set(queue_.size());
+    }
+    cv_.notify_one();
+    return true;
+  }
+
+  void Executor::loop() {
+    std::unique_lock lock{mutex_};
+    while (true) {
+      auto it{queue_.end()};
+      cv_.wait(lock, [&] {
+        if (stop_) {
+          return true;
+        }
+        // first call which method is below limit
+        it = std::find_if(queue_.begin(), queue_.end(), [](auto &call) {
+          return call.limit->running < call.limit->max;
+        });
+        return it != queue_.end();
+      });
+      if (stop_) {
+        return;
+      }
+      auto *limit{it->limit};
+      auto run{std::move(it->run)};
+      queue_.erase(it);
+      metricQueueDepth().Set(queue_.size());
+      ++limit->running;
+      lock.unlock();
+      run();
+      // destroy callbacks before waking other workers
+      run = {};
+      lock.lock();
+      --limit->running;
+      if (!queue_.empty()) {
+        cv_.notify_all();
+      }
+    }
+  }
+}  // namespace fc::api::rpc
@@ -0,0 +1,96 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "api/rpc/rpc.hpp"
+
+namespace boost::asio {
+  class io_context;
+}  // namespace boost::asio
+
+namespace fc::api::rpc {
+  using boost::asio::io_context;
+
+  /// JSON-RPC server error when executor queue is full
+  constexpr auto kServerBusy = INT64_C(-32000);
+
+  /// Calls waiting for worker above which new calls are rejected
+  constexpr size_t kRpcQueueLimit{1000};
+
+  /**
+   * Methods checked to be safe to run in parallel with node io_context.
+   * They only read immutable chain objects from ipld and tipset cache, which
+   * are synchronized.
+   * State methods read state tree of tipset parent state root, without
+   * interpreting tipset. Head is taken under lock of chain store, decoded
+   * hamt and amt nodes are shared through locked cache, message index is
+   * read under lock of waiter.
+   */
+  const std::set<std::string> &parallelMethods();
+
+  /**
+   * Runs bodies of rpc methods outside of io_context serving sockets.
+   * Allowed methods run in parallel on worker threads, each method limited
+   * to half of workers by default, so slow methods don't block fast ones.
+   * Other methods are posted to serial io_context of node and run there one
+   * by one like before.
+   * Calls above method limit wait in bounded queue.
+   */
+  class Executor {
+   public:
+    Executor(size_t threads,
+             size_t queue_limit,
+             std::shared_ptr<io_context> serial);
+    Executor(const Executor &) = delete;
+    Executor(Executor &&) = delete;
+    ~Executor();
+    Executor &operator=(const Executor &) = delete;
+    Executor &operator=(Executor &&) = delete;
+
+    /** limits concurrent calls of method, must be called before wrap */
+    void limit(const std::string &method, size_t max);
+
+    /** allows method to run on workers, must be called before wrap */
+    void parallel(const std::string &method);
+
+    /** wraps methods of rpc to run on executor, executor must outlive rpc */
+    void wrap(Rpc &rpc);
+
+    /** calls waiting in queue */
+    size_t queued() const;
+
+   private:
+    struct Limit {
+      size_t max{};
+      size_t running{};
+    };
+    struct Call {
+      Limit *limit{};
+      std::function<void()> run;
+    };
+
+    Method wrap(const std::string &name, Method method);
+    bool push(Limit &limit, std::function<void()> &&run);
+    void loop();
+
+    size_t default_limit_;
+    size_t queue_limit_;
+    std::shared_ptr<io_context> serial_;
+    std::map<std::string, Limit> limits_;
+    std::set<std::string> parallel_{parallelMethods()};
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Call> queue_;
+    bool stop_{false};
+    std::vector<std::thread> threads_;
+  };
+}  // namespace fc::api::rpc
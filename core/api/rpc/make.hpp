@@ -101,6 +101,7 @@ namespace fc::api {
           auto params =
               std::tuple_cat(std::make_tuple(cb), maybe_params.value());
           std::apply(method, params);
-        });
+        },
+        method.getPerm());
   }
 }  // namespace fc::api
@@ -10,6 +10,7 @@
 #include <rapidjson/document.h>
 #include <boost/variant.hpp>
 
+#include "common/bytes.hpp"
 #include "common/outcome.hpp"
 #include "primitives/jwt/jwt.hpp"
 
@@ -47,10 +48,20 @@ namespace fc::api::rpc {
   using primitives::jwt::Permission;
   using rapidjson::Value;
 
+  /**
+   * Channel value encoded to json once and shared by sessions.
+   * Session splices it into "xrpc.ch.val" request with own channel id.
+   */
+  struct SharedChanValue {
+    uint64_t chan{};
+    std::shared_ptr<const Bytes> json;
+  };
+
   using OkCb = std::function<void(bool)>;
   using Respond =
       std::function<void(boost::variant<Response::Error, Document>)>;
-  using Send = std::function<void(std::string, Document, OkCb)>;
+  using SendParams = boost::variant<Document, SharedChanValue>;
+  using Send = std::function<void(std::string, SendParams, OkCb)>;
   using MakeChan = std::function<uint64_t()>;
   using Permissions = std::vector<Permission>;
   using AuthFunction =
@@ -64,9 +75,14 @@ namespace fc::api::rpc {
     explicit Rpc(AuthFunction &&auth) : auth_{std::move(auth)} {};
 
     std::map<std::string, Method> ms;
+    /** permission required by method, empty if unknown */
+    std::map<std::string, Permission> perms;
 
-    inline void setup(const std::string &name, Method &&method) {
+    inline void setup(const std::string &name,
+                      Method &&method,
+                      Permission perm = {}) {
       ms[name] = std::move(method);
+      perms[name] = std::move(perm);
     }
 
     outcome::result<Permissions> getPermissions(const std::string &token) {
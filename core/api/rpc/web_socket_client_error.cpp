@@ -11,5 +11,8 @@ OUTCOME_CPP_DEFINE_CATEGORY(fc::api::rpc, WebSocketClientError, e) {
   if (e == WebSocketClientError::kRpcErrorResponse) {
     return "RPC error: got error response";
   }
+  if (e == WebSocketClientError::kConnectionClosed) {
+    return "RPC error: all connections are closed";
+  }
   return "unknown error";
 }
@@ -14,6 +14,7 @@ namespace fc::api::rpc {
    */
   enum class WebSocketClientError {
     kRpcErrorResponse = 1,
+    kConnectionClosed,
   };
 
 }  // namespace fc::api::rpc
@@ -5,6 +5,9 @@
 
 #include "api/rpc/ws.hpp"
 
+#include <array>
+#include <atomic>
+#include <mutex>
 #include <queue>
 
 #include <boost/asio/deadline_timer.hpp>
@@ -22,6 +25,7 @@ namespace fc::api {
   namespace websocket = beast::websocket;
   namespace net = boost::asio;
   using primitives::jwt::kDefaultPermission;
+  using rapidjson::Value;
   using rpc::OkCb;
 
   const common::Logger logger = common::createLogger("sector server");
@@ -32,21 +36,26 @@ namespace fc::api {
 
   const auto kChanCloseDelay{boost::posix_time::milliseconds(100)};
 
-  void handleJSONRpcRequest(const Outcome<Document> &j_req,
+  /// Channel values queued for session above which it is closed
+  constexpr size_t kSessionQueueLimit{1000};
+
+  /**
+   * Handles single request.
+   * @return false if request is notification and cb won't be called
+   */
+  bool handleJSONRpcRequest(const Value &j_req,
                             const Rpc &rpc,
                             rpc::MakeChan make_chan,
                             rpc::Send send,
                             const Permissions &perms,
                             std::function<void(const Response &)> cb) {
-    if (!j_req) {
-      return cb(Response{{}, Response::Error{kParseError, "Parse error"}});
-    }
-    auto maybe_req = codec::json::decode<Request>(*j_req);
+    auto maybe_req = codec::json::decode<Request>(j_req);
     if (!maybe_req) {
-      return cb(
-          Response{{}, Response::Error{kInvalidRequest, "Invalid request"}});
+      cb(Response{{}, Response::Error{kInvalidRequest, "Invalid request"}});
+      return true;
     }
     auto &req = maybe_req.value();
+    const auto has_id{req.id.has_value()};
     auto respond = [id{req.id}, cb](auto res) {
       if (id) {
         cb(Response{*id, std::move(res)});
@@ -55,9 +64,28 @@ namespace fc::api {
     auto it = rpc.ms.find(req.method);
     if (it == rpc.ms.end() || !it->second) {
       spdlog::error("rpc method {} not implemented", req.method);
-      return respond(Response::Error{kMethodNotFound, "Method not found"});
+      respond(Response::Error{kMethodNotFound, "Method not found"});
+      return has_id;
     }
     it->second(req.params, std::move(respond), make_chan, send, perms);
+    return has_id;
+  }
+
+  void handleJSONRpcRequest(const Outcome<Document> &j_req,
+                            const Rpc &rpc,
+                            rpc::MakeChan make_chan,
+                            rpc::Send send,
+                            const Permissions &perms,
+                            std::function<void(const Response &)> cb) {
+    if (!j_req) {
+      return cb(Response{{}, Response::Error{kParseError, "Parse error"}});
+    }
+    handleJSONRpcRequest(*j_req,
+                         rpc,
+                         std::move(make_chan),
+                         std::move(send),
+                         perms,
+                         std::move(cb));
   }
 
   struct SocketSession : std::enable_shared_from_this<SocketSession> {
@@ -93,65 +121,175 @@ namespace fc::api {
       auto j_req{codec::json::parse(s_req)};
       buffer.clear();
 
-      handleJSONRpcRequest(
-          j_req,
-          rpc,
-          [&]() { return next_channel++; },
-          [self{shared_from_this()}](auto method, auto params, auto cb) {
-            Request req{self->next_request++, method, std::move(params)};
-            if (method == "xrpc.ch.close") {
-              self->timer.expires_from_now(kChanCloseDelay);
-              self->timer.async_wait(
-                  [self, req{std::move(req)}, cb{std::move(cb)}](auto) {
-                    self->_write(req, std::move(cb));
-                  });
-              return;
-            }
-            self->_write(req, std::move(cb));
-          },
-          perms,
-          [self{shared_from_this()}](const Response &resp) {
-            self->_write(resp, {});
-          });
+      if (j_req && j_req.value().IsArray() && !j_req.value().Empty()) {
+        return onBatch(j_req.value());
+      }
+      handleJSONRpcRequest(j_req,
+                           rpc,
+                           makeChan(),
+                           send(),
+                           perms,
+                           [self{shared_from_this()}](const Response &resp) {
+                             self->_write(resp, {});
+                           });
+    }
+
+    /** json-rpc batch, responses are written as one array */
+    void onBatch(const Value &j_batch) {
+      struct Batch {
+        std::mutex mutex;
+        // one more until all requests are handled
+        size_t remaining{1};
+        Document responses{rapidjson::kArrayType};
+      };
+      auto batch{std::make_shared<Batch>()};
+      const auto done{[self{shared_from_this()}, batch] {
+        std::unique_lock lock{batch->mutex};
+        if (--batch->remaining == 0 && !batch->responses.Empty()) {
+          lock.unlock();
+          self->_push({*codec::json::format(std::move(batch->responses)),
+                       {},
+                       {}},
+                      false);
+        }
+      }};
+      for (const auto &j_req : j_batch.GetArray()) {
+        {
+          std::lock_guard lock{batch->mutex};
+          ++batch->remaining;
+        }
+        const auto responds{handleJSONRpcRequest(
+            j_req,
+            rpc,
+            makeChan(),
+            send(),
+            perms,
+            [batch, done](const Response &resp) {
+              {
+                std::lock_guard lock{batch->mutex};
+                auto &allocator{batch->responses.GetAllocator()};
+                batch->responses.PushBack(encode(resp, allocator), allocator);
+              }
+              done();
+            })};
+        if (!responds) {
+          done();
+        }
+      }
+      done();
     }
 
+    rpc::MakeChan makeChan() {
+      return [self{shared_from_this()}]() { return self->next_channel++; };
+    }
+
+    rpc::Send send() {
+      // methods may respond and send from rpc executor threads
+      return [self{shared_from_this()}](auto method, auto params, auto cb) {
+        const auto id{self->next_request++};
+        if (auto shared{boost::get<rpc::SharedChanValue>(&params)}) {
+          return self->_writeShared(id, *shared, std::move(cb));
+        }
+        Request req{id, method, std::move(boost::get<Document>(params))};
+        if (method == kRpcChClose) {
+          boost::asio::post(
+              self->socket.get_executor(),
+              [self, req{std::move(req)}, cb{std::move(cb)}]() mutable {
+                self->timer.expires_from_now(kChanCloseDelay);
+                self->timer.async_wait(
+                    [self, req{std::move(req)}, cb{std::move(cb)}](auto) {
+                      self->_write(req, std::move(cb));
+                    });
+              });
+          return;
+        }
+        self->_write(req, std::move(cb), method == kRpcChVal);
+      };
+    }
+
+    struct Pending {
+      Bytes buffer;
+      /** channel value shared by sessions, written after buffer */
+      std::shared_ptr<const Bytes> shared;
+      OkCb cb;
+    };
+
     template <typename T>
-    void _write(const T &v, OkCb cb) {
-      boost::asio::post(socket.get_executor(),
-                        [self{shared_from_this()},
-                         buffer{*codec::json::format(encode(v))},
-                         cb{std::move(cb)}]() mutable {
-                          self->pending_writes.emplace(std::move(buffer),
-                                                       std::move(cb));
-                          self->_flush();
-                        });
+    void _write(const T &v, OkCb cb, bool chan_value = false) {
+      _push({*codec::json::format(encode(v)), {}, std::move(cb)}, chan_value);
+    }
+
+    /** splices shared json of channel value into request */
+    void _writeShared(uint64_t id, const rpc::SharedChanValue &value, OkCb cb) {
+      const auto head{fmt::format(
+          R"({{"jsonrpc":"2.0","id":{},"method":"{}","params":[{},)",
+          id,
+          kRpcChVal,
+          value.chan)};
+      _push({copy(common::span::cbytes(head)), value.json, std::move(cb)},
+            true);
+    }
+
+    void _push(Pending &&pending, bool chan_value) {
+      boost::asio::post(
+          socket.get_executor(),
+          [self{shared_from_this()},
+           pending{std::move(pending)},
+           chan_value]() mutable {
+            if (chan_value
+                && self->pending_writes.size() >= kSessionQueueLimit) {
+              // slow subscriber, pending write fails and clears queue
+              logger->warn("closing slow session, {} writes pending",
+                           self->pending_writes.size());
+              boost::system::error_code ec;
+              self->socket.next_layer().close(ec);
+              if (pending.cb) {
+                pending.cb(false);
+              }
+              return;
+            }
+            self->pending_writes.push(std::move(pending));
+            self->_flush();
+          });
     }
 
     void _flush() {
       if (!writing && !pending_writes.empty()) {
-        auto &[buffer, cb] = pending_writes.front();
+        auto &pending{pending_writes.front()};
         writing = true;
-        socket.async_write(
-            net::buffer(buffer.data(), buffer.size()),
-            [self{shared_from_this()}, cb{std::move(cb)}](auto e, auto) {
-              self->writing = false;
-              auto ok = !e;
-              if (!ok) {
-                self->pending_writes = {};
-              } else {
-                self->pending_writes.pop();
-                self->_flush();
-              }
-              if (cb) {
-                cb(ok);
-              }
-            });
+        auto on_write{[self{shared_from_this()}, cb{std::move(pending.cb)}](
+                          auto e, auto) {
+          self->writing = false;
+          auto ok = !e;
+          if (!ok) {
+            self->pending_writes = {};
+          } else {
+            self->pending_writes.pop();
+            self->_flush();
+          }
+          if (cb) {
+            cb(ok);
+          }
+        }};
+        if (pending.shared) {
+          constexpr std::string_view kTail{"]}"};
+          socket.async_write(
+              std::array<net::const_buffer, 3>{
+                  net::buffer(pending.buffer.data(), pending.buffer.size()),
+                  net::buffer(pending.shared->data(), pending.shared->size()),
+                  net::buffer(kTail.data(), kTail.size())},
+              std::move(on_write));
+        } else {
+          socket.async_write(
+              net::buffer(pending.buffer.data(), pending.buffer.size()),
+              std::move(on_write));
+        }
       }
     }
 
-    std::queue<std::pair<Bytes, OkCb>> pending_writes;
+    std::queue<Pending> pending_writes;
     bool writing{false};
-    uint64_t next_channel{}, next_request{};
+    std::atomic_uint64_t next_channel{}, next_request{};
     websocket::stream<tcp::socket> socket;
     net::deadline_timer timer;
     beast::flat_buffer buffer;
@@ -270,8 +408,14 @@ namespace fc::api {
                             [self{shared_from_this()}, fn{route.second}]() {
                               fn(self->request,
                                  [self](WrapperResponse response) {
-                                   self->w_response = std::move(response);
-                                   self->doWrite();
+                                   // may be called from rpc executor thread
+                                   net::post(
+                                       self->stream.get_executor(),
+                                       [self,
+                                        response{std::move(response)}]() mutable {
+                                         self->w_response = std::move(response);
+                                         self->doWrite();
+                                       });
                                  });
                             });
           is_handled = true;
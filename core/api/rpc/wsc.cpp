@@ -5,6 +5,8 @@
 
 #include "api/rpc/wsc.hpp"
 
+#include <algorithm>
+
 #include "api/rpc/json.hpp"
 #include "api/rpc/web_socket_client_error.hpp"
 #include "codec/json/json.hpp"
@@ -14,17 +16,33 @@
 namespace fc::api::rpc {
   using codec::json::decode;
 
-  Client::Client(io_context &io2)
-      : io2{io2},
-        work_guard{io.get_executor()},
-        socket{io},
-        logger_{common::createLogger("WebSocket Client")} {
-    thread = std::thread{[=]() { io.run(); }};
+  Client::Connection::Connection()
+      : work_guard{io.get_executor()}, socket{io} {
+    thread = std::thread{[this]() { io.run(); }};
   }
 
-  Client::~Client() {
+  Client::Connection::~Connection() {
     io.stop();
-    thread.join();
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+
+  Client::Client(io_context &io2, size_t connections)
+      : io2{io2}, logger_{common::createLogger("WebSocket Client")} {
+    for (size_t i{0}; i < std::max<size_t>(1, connections); ++i) {
+      this->connections.push_back(std::make_unique<Connection>());
+    }
+  }
+
+  Client::~Client() {
+    // channel callbacks use connections, stop them after reads
+    for (auto &connection : connections) {
+      connection->io.stop();
+      connection->thread.join();
+    }
+    thread_chan.io->stop();
+    thread_chan.thread.join();
   }
 
   outcome::result<void> Client::connect(const Multiaddress &address,
@@ -39,93 +57,185 @@ namespace fc::api::rpc {
     return connect(ip, port, target, token);
   }
 
-    outcome::result<void> Client::connect(const std::string &host,
-                                          const std::string &port,
-                                          const std::string &target,
-                                          const std::string &token) {
-    boost::system::error_code ec;
-    socket.next_layer().connect({boost::asio::ip::make_address(host),
-                                 boost::lexical_cast<uint16_t>(port)},
-                                ec);
-    if (ec) {
-      return ec;
-    }
-    if (not token.empty()) {
-      socket.set_option(
-          boost::beast::websocket::stream_base::decorator([&](auto &req) {
-            req.set(boost::beast::http::field::authorization,
-                    "Bearer " + token);
-          }));
-    }
-    socket.handshake(host, target, ec);
-    if (ec) {
-      return ec;
-    }
-    _read();
+  outcome::result<void> Client::connect(const std::string &host,
+                                        const std::string &port,
+                                        const std::string &target,
+                                        const std::string &token) {
+    for (auto &connection : connections) {
+      auto &socket{connection->socket};
+      boost::system::error_code ec;
+      socket.next_layer().connect({boost::asio::ip::make_address(host),
+                                   boost::lexical_cast<uint16_t>(port)},
+                                  ec);
+      if (ec) {
+        return ec;
+      }
+      if (not token.empty()) {
+        socket.set_option(
+            boost::beast::websocket::stream_base::decorator([&](auto &req) {
+              req.set(boost::beast::http::field::authorization,
+                      "Bearer " + token);
+            }));
+      }
+      socket.handshake(host, target, ec);
+      if (ec) {
+        return ec;
+      }
+      _read(*connection);
+    }
     return outcome::success();
   }
 
   void Client::call(Request &&req, ResultCb &&cb) {
-    std::lock_guard lock{mutex};
-    req.id = next_req++;
-    write_queue.emplace(*req.id, *codec::json::format(encode(req)));
-    result_queue.emplace(*req.id, std::move(cb));
-    _flush();
+    std::vector<std::pair<Request, ResultCb>> calls;
+    calls.emplace_back(std::move(req), std::move(cb));
+    _sendPool(std::move(calls));
+  }
+
+  void Client::batch(std::vector<std::pair<Request, ResultCb>> &&calls) {
+    if (!calls.empty()) {
+      _sendPool(std::move(calls));
+    }
+  }
+
+  void Client::_callChan(Request &&req, ResultCb &&cb) {
+    std::vector<std::pair<Request, ResultCb>> calls;
+    calls.emplace_back(std::move(req), std::move(cb));
+    if (!_send(*connections[0], calls)) {
+      _fail(calls, WebSocketClientError::kConnectionClosed);
+    }
   }
 
   void Client::_chan(uint64_t id, ChanCb &&cb) {
-    chans.emplace(id, std::move(cb));
+    // called with lock of first connection held
+    connections[0]->chans.emplace(id, std::move(cb));
+  }
+
+  Client::Connection *Client::_pick() {
+    Connection *best{nullptr};
+    size_t best_pending{};
+    for (auto &connection : connections) {
+      std::lock_guard lock{connection->mutex};
+      if (connection->closed) {
+        continue;
+      }
+      const auto pending{connection->result_queue.size()};
+      if (!best || pending < best_pending) {
+        best = connection.get();
+        best_pending = pending;
+      }
+      if (pending == 0) {
+        break;
+      }
+    }
+    return best;
+  }
+
+  void Client::_sendPool(std::vector<std::pair<Request, ResultCb>> &&calls) {
+    // picked connection may close before calls are queued, pick again
+    while (auto connection{_pick()}) {
+      if (_send(*connection, calls)) {
+        return;
+      }
+    }
+    _fail(calls, WebSocketClientError::kConnectionClosed);
   }
 
-  void Client::_error(const std::error_code &error) {
-    write_queue = {};
-    for (auto &[id, cb] : result_queue) {
+  bool Client::_send(Connection &connection,
+                     std::vector<std::pair<Request, ResultCb>> &calls) {
+    for (auto &[req, cb] : calls) {
+      req.id = next_req++;
+    }
+    Bytes buffer;
+    if (calls.size() == 1) {
+      buffer = *codec::json::format(encode(calls[0].first));
+    } else {
+      Document j{rapidjson::kArrayType};
+      for (auto &[req, cb] : calls) {
+        j.PushBack(encode(req, j.GetAllocator()), j.GetAllocator());
+      }
+      buffer = *codec::json::format(std::move(j));
+    }
+    std::lock_guard lock{connection.mutex};
+    if (connection.closed) {
+      return false;
+    }
+    connection.write_queue.push(std::move(buffer));
+    for (auto &[req, cb] : calls) {
+      connection.result_queue.emplace(*req.id, std::move(cb));
+    }
+    _flush(connection);
+    return true;
+  }
+
+  void Client::_fail(std::vector<std::pair<Request, ResultCb>> &calls,
+                     const std::error_code &error) {
+    for (auto &[req, cb] : calls) {
       cb(error);
     }
-    result_queue.clear();
-    for (auto &[id, cb] : chans) {
+  }
+
+  void Client::_error(Connection &connection, const std::error_code &error) {
+    connection.closed = true;
+    connection.write_queue = {};
+    for (auto &[id, cb] : connection.result_queue) {
+      cb(error);
+    }
+    connection.result_queue.clear();
+    for (auto &[id, cb] : connection.chans) {
       if (cb) {
         cb({});
       }
     }
-    chans.clear();
+    connection.chans.clear();
   }
 
-  void Client::_flush() {
-    if (!writing && !write_queue.empty()) {
-      auto &[id, buffer] = write_queue.front();
-      writing = true;
-      socket.async_write(boost::asio::buffer(buffer.data(), buffer.size()),
-                         [=](auto &&ec, auto) {
-                           std::lock_guard lock{mutex};
-                           if (ec) {
-                             return _error(ec);
-                           }
-                           writing = false;
-                           write_queue.pop();
-                           _flush();
-                         });
+  void Client::_flush(Connection &connection) {
+    if (!connection.writing && !connection.write_queue.empty()) {
+      auto &buffer{connection.write_queue.front()};
+      connection.writing = true;
+      connection.socket.async_write(
+          boost::asio::buffer(buffer.data(), buffer.size()),
+          [this, &connection](auto &&ec, auto) {
+            std::lock_guard lock{connection.mutex};
+            if (ec) {
+              return _error(connection, ec);
+            }
+            connection.writing = false;
+            connection.write_queue.pop();
+            _flush(connection);
+          });
     }
   }
 
-  void Client::_read() {
-    socket.async_read(buffer, [=](auto &&ec, auto) {
-      if (ec) {
-        std::lock_guard lock{mutex};
-        return _error(ec);
-      }
-      std::string_view s{static_cast<const char *>(buffer.cdata().data()),
-                         buffer.cdata().size()};
-      if (auto _req{codec::json::parse(s)}) {
-        _onread(_req.value());
-      }
-      buffer.clear();
-      _read();
-    });
+  void Client::_read(Connection &connection) {
+    connection.socket.async_read(
+        connection.buffer, [this, &connection](auto &&ec, auto) {
+          if (ec) {
+            std::lock_guard lock{connection.mutex};
+            return _error(connection, ec);
+          }
+          auto &buffer{connection.buffer};
+          std::string_view s{static_cast<const char *>(buffer.cdata().data()),
+                             buffer.cdata().size()};
+          if (auto _req{codec::json::parse(s)}) {
+            auto &j{_req.value()};
+            if (j.IsArray()) {
+              // batch response
+              for (const auto &item : j.GetArray()) {
+                _onread(connection, item);
+              }
+            } else {
+              _onread(connection, j);
+            }
+          }
+          buffer.clear();
+          _read(connection);
+        });
   }
 
   // NOLINTNEXTLINE(readability-function-cognitive-complexity)
-  void Client::_onread(const Document &j) {
+  void Client::_onread(Connection &connection, const Value &j) {
     if (j.HasMember("method")) {
       if (auto _req{decode<Request>(j)}) {
         auto &req{_req.value()};
@@ -146,8 +256,12 @@ namespace fc::api::rpc {
           if (id) {
             boost::asio::post(
                 *thread_chan.io,
-                [this, close, id{*id}, value{std::move(value)}]() mutable {
-                  std::unique_lock lock{mutex};
+                [&connection,
+                 close,
+                 id{*id},
+                 value{std::move(value)}]() mutable {
+                  std::unique_lock lock{connection.mutex};
+                  auto &chans{connection.chans};
                   auto it{chans.find(id)};
                   if (it != chans.end()) {
                     auto cb{std::move(it->second)};
@@ -171,7 +285,8 @@ namespace fc::api::rpc {
       if (auto _res{decode<Response>(j)}) {
         auto &res{_res.value()};
         if (res.id) {
-          std::lock_guard lock{mutex};
+          std::lock_guard lock{connection.mutex};
+          auto &result_queue{connection.result_queue};
           auto it{result_queue.find(*res.id)};
           if (it != result_queue.end()) {
             if (common::which<Document>(res.result)) {
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <boost/asio/executor_work_guard.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/beast/core.hpp>
@@ -26,11 +27,22 @@ namespace fc::api::rpc {
   using libp2p::multi::Multiaddress;
   using Logger = common::Logger;
 
+  /// Connections of miner to node api, large calls don't block other calls
+  constexpr size_t kNodeApiConnections{4};
+
+  /**
+   * Json-rpc websocket client.
+   * Keeps pool of connections, each pipelines requests without waiting for
+   * responses. Call is sent to open connection with least pending requests,
+   * and fails only when all connections are closed.
+   * Channels are ids of connection, so calls returning channels use first
+   * connection.
+   */
   struct Client {
     using ResultCb = std::function<void(outcome::result<Document>)>;
     using ChanCb = std::function<bool(boost::optional<Document>)>;
 
-    explicit Client(io_context &io2);
+    explicit Client(io_context &io2, size_t connections = 1);
     Client(const Client &) = delete;
     Client(Client &&) = delete;
     ~Client();
@@ -48,30 +60,54 @@ namespace fc::api::rpc {
                                   const std::string &token);
 
     void call(Request &&req, ResultCb &&cb);
+    /** sends requests as one json-rpc batch message */
+    void batch(std::vector<std::pair<Request, ResultCb>> &&calls);
+    /** call returning channel */
+    void _callChan(Request &&req, ResultCb &&cb);
+    /** must be called from result callback of `_callChan` */
     void _chan(uint64_t id, ChanCb &&cb);
-    void _error(const std::error_code &error);
-    void _flush();
-    void _read();
-    void _onread(const Document &j);
     template <typename A>
     void setup(A &api) {
       visit(api, [&](auto &m) { _setup(*this, m); });
     }
 
    private:
-    std::thread thread;
+    struct Connection {
+      Connection();
+      ~Connection();
+
+      io_context io;
+      boost::asio::executor_work_guard<io_context::executor_type> work_guard;
+      std::thread thread;
+      boost::beast::websocket::stream<boost::asio::ip::tcp::socket> socket;
+      boost::beast::flat_buffer buffer;
+      std::mutex mutex;
+      std::map<uint64_t, ResultCb> result_queue;
+      std::map<uint64_t, ChanCb> chans;
+      std::queue<Bytes> write_queue;
+      bool writing{false};
+      /** set on read or write error, connection is not used after that */
+      bool closed{false};
+    };
+
+    /** @return open connection with least pending requests or null */
+    Connection *_pick();
+    /** sends calls to picked connection, fails them if none is open */
+    void _sendPool(std::vector<std::pair<Request, ResultCb>> &&calls);
+    /** @return false and keeps calls if connection is closed */
+    bool _send(Connection &connection,
+               std::vector<std::pair<Request, ResultCb>> &calls);
+    static void _fail(std::vector<std::pair<Request, ResultCb>> &calls,
+                      const std::error_code &error);
+    void _error(Connection &connection, const std::error_code &error);
+    void _flush(Connection &connection);
+    void _read(Connection &connection);
+    void _onread(Connection &connection, const Value &j);
+
     IoThread thread_chan;
-    io_context io;
     io_context &io2;
-    boost::asio::executor_work_guard<io_context::executor_type> work_guard;
-    boost::beast::websocket::stream<boost::asio::ip::tcp::socket> socket;
-    boost::beast::flat_buffer buffer;
-    std::mutex mutex;
-    uint64_t next_req{};
-    std::map<uint64_t, ResultCb> result_queue;
-    std::map<uint64_t, ChanCb> chans;
-    std::queue<std::pair<uint64_t, Bytes>> write_queue;
-    bool writing{false};
+    std::atomic_uint64_t next_req{};
+    std::vector<std::unique_ptr<Connection>> connections;
 
     template <typename M>
     void _setup(Client &c, M &m);
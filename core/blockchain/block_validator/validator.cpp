@@ -21,7 +21,7 @@
 #include "vm/actor/builtin/states/miner/miner_actor_state.hpp"
 #include "vm/actor/builtin/states/storage_power/storage_power_actor_state.hpp"
 #include "vm/interpreter/interpreter.hpp"
-#include "vm/message/impl/message_signer_impl.hpp"
+#include "vm/message/sig_verifier.hpp"
 #include "vm/message/valid.hpp"
 #include "vm/runtime/pricelist.hpp"
 #include "vm/state/impl/state_tree_impl.hpp"
@@ -46,7 +46,13 @@ namespace fc::blockchain::block_validator {
         ipld{envx.ipld},
         ts_load{envx.ts_load},
         interpreter_cache{envx.interpreter_cache},
-        ts_branches_mutex{envx.ts_branches_mutex} {}
+        ts_branches_mutex{envx.ts_branches_mutex},
+        sig_verifier{envx.sig_verifier} {
+    if (!sig_verifier) {
+      sig_verifier = std::make_shared<SigVerifier>(
+          0, vm::message::kSigCacheSize, vm::message::kSigRateLimit);
+    }
+  }
 
   outcome::result<void> BlockValidator::validate(const TsBranchPtr &branch,
                                                  const BlockHeader &block) {
@@ -218,9 +224,6 @@ namespace fc::blockchain::block_validator {
 
   outcome::result<void> BlockValidator::validateMessages(
       const BlockHeader &block, const TipsetCPtr &ts, StateTreeImpl &tree) {
-    // TODO(turuslan): verify bls aggregate
-    // note: lotus workarounds zero bls bug in block
-    // bafy2bzaceapyg2uyzk7vueh3xccxkuwbz3nxewjyguoxvhx77malc2lzn2ybi
     const vm::runtime::Pricelist pricelist{block.height};
     std::map<primitives::address::Address, Nonce> nonces;
     MsgMeta wmeta;
@@ -230,8 +233,10 @@ namespace fc::blockchain::block_validator {
     const auto network{getNetworkVersion(block.height)};
     const auto matcher{vm::toolchain::Toolchain::createAddressMatcher(network)};
     primitives::GasAmount gas_limit{};
-    static const vm::message::MessageSignerImpl signer{
-        storage::keystore::kDefaultKeystore};
+    std::vector<CID> bls_cids;
+    std::vector<crypto::bls::PublicKey> bls_keys;
+    std::vector<SignedMessage> secp_messages;
+    std::vector<SigVerifier::Secp> secp;
     auto check{
         [&](const UnsignedMessage &msg, size_t size) -> outcome::result<void> {
           if (!validForBlockInclusion(
@@ -266,6 +271,13 @@ namespace fc::blockchain::block_validator {
           OUTCOME_TRY(cbor, ipld->get(cid));
           OUTCOME_TRY(msg, codec::cbor::decode<UnsignedMessage>(cbor));
           OUTCOME_TRY(check(msg, cbor.size()));
+          OUTCOME_TRY(key, resolveKey(tree, msg.from));
+          if (!key.isBls()) {
+            return ERROR_TEXT("validateMessages: bls message from not bls");
+          }
+          bls_cids.push_back(cid);
+          bls_keys.push_back(
+              boost::get<primitives::address::BLSPublicKeyHash>(key.data));
           OUTCOME_TRY(wmeta.bls_messages.append(cid));
           return outcome::success();
         }));
@@ -278,7 +290,8 @@ namespace fc::blockchain::block_validator {
           }
           OUTCOME_TRY(check(smsg.message, cbor.size()));
           OUTCOME_TRY(key, resolveKey(tree, smsg.message.from));
-          OUTCOME_TRY(signer.verify(key, smsg));
+          secp.push_back({cid, key, nullptr});
+          secp_messages.push_back(std::move(smsg));
           OUTCOME_TRY(wmeta.secp_messages.append(cid));
           return outcome::success();
         }));
@@ -286,6 +299,25 @@ namespace fc::blockchain::block_validator {
     if (root != block.messages) {
       return ERROR_TEXT("validateMessages: wrong root");
     }
+
+    static auto &metricTime{prometheus::BuildHistogram()
+                                .Name("lotus_block_signatures_ms")
+                                .Help("Duration for Block Message Signatures "
+                                      "Validation in ms")
+                                .Register(prometheusRegistry())
+                                .Add({}, kDefaultPrometheusMsBuckets)};
+    const Since since;
+    for (size_t i{0}; i < secp.size(); ++i) {
+      secp[i].smsg = &secp_messages[i];
+    }
+    OUTCOME_TRY(sig_verifier->verifySecp(secp));
+    // note: lotus workarounds zero bls bug in block
+    // bafy2bzaceapyg2uyzk7vueh3xccxkuwbz3nxewjyguoxvhx77malc2lzn2ybi
+    if (!bls_cids.empty()) {
+      OUTCOME_TRY(
+          sig_verifier->verifyBls(bls_cids, bls_keys, *block.bls_aggregate));
+    }
+    metricTime.Observe(since.ms());
     return outcome::success();
   }
 }  // namespace fc::blockchain::block_validator
@@ -13,6 +13,7 @@ namespace fc::blockchain::block_validator {
   using primitives::block::BlockHeader;
   using primitives::tipset::TipsetCPtr;
   using vm::interpreter::InterpreterCache;
+  using vm::message::SigVerifier;
   using vm::runtime::EnvironmentContext;
   using vm::state::StateTreeImpl;
 
@@ -24,6 +25,7 @@ namespace fc::blockchain::block_validator {
     TsLoadPtr ts_load;
     std::shared_ptr<InterpreterCache> interpreter_cache;
     SharedMutexPtr ts_branches_mutex;
+    std::shared_ptr<SigVerifier> sig_verifier;
 
     BlockValidator(MapPtr kv, const EnvironmentContext &envx);
 
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <memory>
+#include <utility>
 
 #include "cbor_blake/cid.hpp"
 #include "common/bytes_cow.hpp"
@@ -15,6 +16,20 @@ namespace fc {
     virtual ~CbIpld() = default;
     virtual bool get(const CbCid &key, Bytes *value) const = 0;
     virtual void put(const CbCid &key, BytesCow &&value) = 0;
+    /** returns shared immutable value, cached values are not copied */
+    virtual SharedBytes getShared(const CbCid &key) const {
+      auto value{std::make_shared<Bytes>()};
+      if (get(key, value.get())) {
+        return value;
+      }
+      return nullptr;
+    }
+    /** puts blocks, implementations may dedup and write batch at once */
+    virtual void putMany(gsl::span<const std::pair<CbCid, BytesIn>> items) {
+      for (const auto &[key, value] : items) {
+        put(key, BytesCow{value});
+      }
+    }
 
     bool has(const CbCid &key) const {
       return get(key, nullptr);
@@ -28,6 +28,18 @@ namespace fc {
       ipld->put(*cid, std::move(value));
       return outcome::success();
     }
+    outcome::result<void> setMany(
+        std::vector<std::pair<CID, BytesCow>> &&items) override {
+      std::vector<std::pair<CbCid, BytesIn>> blocks;
+      blocks.reserve(items.size());
+      for (const auto &[key, value] : items) {
+        auto cid{asBlake(key)};
+        assert(cid);
+        blocks.emplace_back(*cid, value.span());
+      }
+      ipld->putMany(blocks);
+      return outcome::success();
+    }
     outcome::result<Value> get(const CID &key) const override {
       if (auto cid{asBlake(key)}) {
         Bytes value;
@@ -37,6 +49,14 @@ namespace fc {
       }
       return storage::ipfs::IpfsDatastoreError::kNotFound;
     }
+    outcome::result<SharedBytes> getShared(const CID &key) const override {
+      if (auto cid{asBlake(key)}) {
+        if (auto value{ipld->getShared(*cid)}) {
+          return value;
+        }
+      }
+      return storage::ipfs::IpfsDatastoreError::kNotFound;
+    }
   };
 
   struct AnyAsCbIpld : CbIpld {
@@ -62,8 +82,24 @@ namespace fc {
     bool get(const CbCid &key, Bytes *value) const override {
       return get(ipld, key, value);
     }
+    SharedBytes getShared(const CbCid &key) const override {
+      if (auto r{ipld->getShared(CID{key})}) {
+        return r.value();
+      } else if (r.error() != storage::ipfs::IpfsDatastoreError::kNotFound) {
+        r.value();  // throws
+      }
+      return nullptr;
+    }
     void put(const CbCid &key, BytesCow &&value) override {
       ipld->set(CID{key}, std::move(value)).value();
     }
+    void putMany(gsl::span<const std::pair<CbCid, BytesIn>> items) override {
+      std::vector<std::pair<CID, BytesCow>> blocks;
+      blocks.reserve(items.size());
+      for (const auto &[key, value] : items) {
+        blocks.emplace_back(CID{key}, BytesCow{value});
+      }
+      ipld->setMany(std::move(blocks)).value();
+    }
   };
 }  // namespace fc
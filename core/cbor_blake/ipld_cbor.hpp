@@ -45,8 +45,8 @@ namespace fc::cbor_blake {
   // TODO(turuslan): refactor CID to CbCid
   template <typename T>
   outcome::result<T> getCbor(CbIpldPtrIn ipld, const CID &key) {
-    OUTCOME_TRY(cbor, ipld->get(key));
-    return cbDecodeT<T>(ipld, cbor);
+    OUTCOME_TRY(cbor, ipld->getShared(key));
+    return cbDecodeT<T>(ipld, *cbor);
   }
 
   // TODO(turuslan): refactor CID to CbCid
@@ -20,9 +20,16 @@ namespace fc {
     outcome::result<void> set(const CID &key, BytesCow &&value) override {
       return ipld->set(key, std::move(value));
     }
+    outcome::result<void> setMany(
+        std::vector<std::pair<CID, BytesCow>> &&items) override {
+      return ipld->setMany(std::move(items));
+    }
     outcome::result<Value> get(const CID &key) const override {
       return ipld->get(key);
     }
+    outcome::result<SharedBytes> getShared(const CID &key) const override {
+      return ipld->getShared(key);
+    }
   };
 
   // TODO(turuslan): refactor Ipld to CbIpld
@@ -75,4 +75,20 @@ namespace fc::codec::cbor::light_reader {
     height = *token.asInt();
     return true;
   }
+
+  /** reads parents, height and messages meta cid */
+  inline bool readBlock(BlockParentCbCids &parents,
+                        ChainEpoch &height,
+                        const CbCid *&messages,
+                        BytesIn &input) {
+    BytesIn ticket;
+    if (!readBlock(ticket, parents, height, input)) {
+      return false;
+    }
+    // skip parent state root and parent message receipts
+    if (!skipNested(input, 2)) {
+      return false;
+    }
+    return cbor::readCborBlake(messages, input);
+  }
 }  // namespace fc::codec::cbor::light_reader
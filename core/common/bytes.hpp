@@ -7,6 +7,7 @@
 
 #include <cstdint>
 #include <gsl/span>
+#include <memory>
 #include <vector>
 
 #include "common/cmp.hpp"
@@ -16,6 +17,8 @@ namespace fc {
   using Bytes = std::vector<uint8_t>;
   using BytesIn = gsl::span<const uint8_t>;
   using BytesOut = gsl::span<uint8_t>;
+  /** immutable value shared without copy */
+  using SharedBytes = std::shared_ptr<const Bytes>;
 
   template <size_t N>
   using BytesN = std::array<uint8_t, N>;
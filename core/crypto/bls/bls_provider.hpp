@@ -7,6 +7,7 @@
 
 #include <gsl/span>
 
+#include "common/bytes.hpp"
 #include "crypto/bls/bls_types.hpp"
 
 namespace fc::crypto::bls {
@@ -51,6 +52,18 @@ namespace fc::crypto::bls {
         const Signature &signature,
         const PublicKey &key) const = 0;
 
+    /**
+     * @brief Verify aggregated BLS signature of messages with one pairing
+     * @param messages - signed data, one per public key
+     * @param signature - aggregated BLS signature
+     * @param keys - BLS public keys
+     * @return signature status or error code
+     */
+    virtual outcome::result<bool> verifyAggregateSignature(
+        gsl::span<const BytesIn> messages,
+        const Signature &signature,
+        gsl::span<const PublicKey> keys) const = 0;
+
     /**
      * @brief Aggregate BLS signatures
      * @param signatures - signatures to aggregate
@@ -58,6 +58,31 @@ namespace fc::crypto::bls {
            > 0;
   }
 
+  outcome::result<bool> BlsProviderImpl::verifyAggregateSignature(
+      gsl::span<const BytesIn> messages,
+      const Signature &signature,
+      gsl::span<const PublicKey> keys) const {
+    if (messages.size() != keys.size()) {
+      return Errors::kSignatureVerificationFailed;
+    }
+    Bytes flattened;
+    std::vector<size_t> sizes;
+    sizes.reserve(messages.size());
+    for (const auto &message : messages) {
+      append(flattened, message);
+      sizes.push_back(message.size());
+    }
+    const auto keys_bytes{common::span::cast<const uint8_t>(keys)};
+    return fil_hash_verify(signature.data(),
+                           flattened.data(),
+                           flattened.size(),
+                           sizes.data(),
+                           sizes.size(),
+                           keys_bytes.data(),
+                           keys_bytes.size())
+           > 0;
+  }
+
   outcome::result<Digest> BlsProviderImpl::generateHash(
       gsl::span<const uint8_t> message) {
     auto response{ffi::wrap(fil_hash(message.data(), message.size()),
@@ -22,6 +22,11 @@ namespace fc::crypto::bls {
                                           const Signature &signature,
                                           const PublicKey &key) const override;
 
+    outcome::result<bool> verifyAggregateSignature(
+        gsl::span<const BytesIn> messages,
+        const Signature &signature,
+        gsl::span<const PublicKey> keys) const override;
+
     outcome::result<Signature> aggregateSignatures(
         gsl::span<const Signature> signatures) const override;
 
@@ -125,6 +125,10 @@ namespace fc {
     }    // namespace tipset
   }      // namespace primitives
 
+  namespace proofs {
+    class SealVerifier;
+  }  // namespace proofs
+
   namespace storage {
     namespace blockchain {
       class ChainStore;
@@ -172,6 +176,7 @@ namespace fc {
     }  // namespace interpreter
 
     namespace message {
+      class SigVerifier;
       struct SignedMessage;
       struct UnsignedMessage;
     }  // namespace message
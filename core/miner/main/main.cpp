@@ -379,7 +379,7 @@ namespace fc {
     for (size_t i{0}; i < kApiThreadPoolSize; ++i) {
       pool.emplace_back(std::thread{[&] { io_thread.io->run(); }});
     }
-    api::rpc::Client wsc{*io_thread.io};
+    api::rpc::Client wsc{*io_thread.io, api::rpc::kNodeApiConnections};
     wsc.setup(*napi);
     OUTCOME_TRY(
         wsc.connect(config.node_api.first, "/rpc/v0", config.node_api.second));
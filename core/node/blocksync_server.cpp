@@ -7,12 +7,21 @@
 
 #include <libp2p/host/host.hpp>
 
+#include "codec/cbor/light_reader/amt_walk.hpp"
+#include "codec/cbor/light_reader/block.hpp"
+#include "common/enum.hpp"
 #include "common/logger.hpp"
-#include "common/outcome_fmt.hpp"
-#include "primitives/tipset/load.hpp"
-#include "storage/ipfs/datastore.hpp"
+#include "common/span.hpp"
 
 namespace fc::sync::blocksync {
+  using codec::cbor::CborToken;
+  using codec::cbor::writeInt;
+  using codec::cbor::writeList;
+  using codec::cbor::writeNull;
+  using codec::cbor::writeStr;
+  using codec::cbor::writeUint;
+  using primitives::ChainEpoch;
+  namespace light_reader = codec::cbor::light_reader;
 
   namespace {
     constexpr size_t kBlockSyncMaxRequestLength = 800;
@@ -59,94 +68,196 @@ namespace fc::sync::blocksync {
       return true;
     }
 
-    template <typename T>
-    struct MessageVisitor {
-      outcome::result<void> operator()(size_t, const CID &cid) {
-        auto index{visited.find(cid)};
-        if (index == visited.end()) {
-          index = visited.emplace(cid, messages.size()).first;
-          OUTCOME_TRY(message, getCbor<T>(ipld, cid));
-          messages.push_back(std::move(message));
-        }
-        indices.rbegin()->push_back(index->second);
-        return outcome::success();
+    /// Stored cbor of messages, deduplicated like in TipsetBundle
+    struct RawMessages {
+      std::vector<SharedBytes> messages;
+      MsgIncudes includes;
+      std::map<CbCid, size_t> visited;
+    };
+
+    /** reads values count of amt root node */
+    bool readAmtCount(BytesIn node, uint64_t &count) {
+      CborToken token;
+      if (!read(token, node).listCount()) {
+        return false;
+      }
+      // skip bit width if present
+      if (token.listCount() == 4 && !read(token, node).asUint()) {
+        return false;
+      }
+      // skip height, read count
+      if (!read(token, node).asUint() || !read(token, node).asUint()) {
+        return false;
       }
+      count = *token.asUint();
+      return true;
+    }
 
-      IpldPtr &ipld;
-      std::vector<T> &messages;
-      MsgIncudes &indices;
-      std::map<CID, size_t> visited{};
-    };
+    bool visitMessages(const CbIpldPtr &ipld,
+                       const CbCid &root,
+                       RawMessages &raw) {
+      auto &indices{raw.includes.emplace_back()};
+      light_reader::AmtWalk walk{ipld, root};
+      uint64_t count{};
+      if (!walk.load() || !readAmtCount(walk._node, count)) {
+        return false;
+      }
+      BytesIn value;
+      while (walk.next(value)) {
+        const CbCid *cid{nullptr};
+        if (!codec::cbor::readCborBlake(cid, value)) {
+          return false;
+        }
+        auto index{raw.visited.find(*cid)};
+        if (index == raw.visited.end()) {
+          auto message{ipld->getShared(*cid)};
+          if (!message) {
+            return false;
+          }
+          index = raw.visited.emplace(*cid, raw.messages.size()).first;
+          raw.messages.push_back(std::move(message));
+        }
+        indices.push_back(index->second);
+      }
+      // walk skips missing nodes
+      return walk.empty() && indices.size() == count;
+    }
 
-    void getChain(TsLoadPtr ts_load,
-                  IpldPtr ipld,
-                  const Request &request,
-                  Response &response) {
-      bool partial = false;
-      size_t depth = request.depth;
-      if (request.depth > kBlockSyncMaxRequestLength) {
-        partial = true;
-        depth = kBlockSyncMaxRequestLength;
+    void writeMessages(Bytes &out, const RawMessages &raw) {
+      writeList(out, raw.messages.size());
+      for (const auto &message : raw.messages) {
+        append(out, *message);
+      }
+      writeList(out, raw.includes.size());
+      for (const auto &indices : raw.includes) {
+        writeList(out, indices.size());
+        for (const auto &index : indices) {
+          writeUint(out, index);
+        }
       }
+    }
 
-      auto _result{[&]() -> outcome::result<void> {
-        OUTCOME_TRY(ts, ts_load->load(request.block_cids));
-        while (true) {
-          TipsetBundle packed;
-          if (request.options & kMessagesOnly) {
-            TipsetBundle::Messages msgs;
-            MessageVisitor<UnsignedMessage> bls_visitor{
-                ipld, msgs.bls_msgs, msgs.bls_msg_includes};
-            MessageVisitor<SignedMessage> secp_visitor{
-                ipld, msgs.secp_msgs, msgs.secp_msg_includes};
-            for (auto &block : ts->blks) {
-              OUTCOME_TRY(
-                  meta,
-                  getCbor<primitives::block::MsgMeta>(ipld, block.messages));
-              msgs.bls_msg_includes.emplace_back();
-              OUTCOME_TRY(meta.bls_messages.visit(bls_visitor));
-              msgs.secp_msg_includes.emplace_back();
-              OUTCOME_TRY(meta.secp_messages.visit(secp_visitor));
-            }
-            packed.messages = std::move(msgs);
+    /** appends tipset bundles to chain, returns false if not found */
+    bool getChain(const CbIpldPtr &ipld,
+                  const Request &request,
+                  size_t depth,
+                  Bytes &chain,
+                  size_t &bundles,
+                  bool &genesis) {
+      std::vector<CbCid> tsk{request.block_cids};
+      BlockParentCbCids parents;
+      ChainEpoch height{};
+      std::vector<SharedBytes> blocks;
+      while (true) {
+        blocks.resize(0);
+        RawMessages bls, secp;
+        for (const auto &cid : tsk) {
+          auto block{ipld->getShared(cid)};
+          if (!block) {
+            return false;
           }
-          if (request.options & kBlocksOnly) {
-            packed.blocks = ts->blks;
+          BytesIn input{*block};
+          const CbCid *meta_cid{nullptr};
+          if (!light_reader::readBlock(parents, height, meta_cid, input)) {
+            return false;
           }
-          response.chain.push_back(std::move(packed));
-          if (response.chain.size() >= depth) {
-            break;
+          if (request.options & kMessagesOnly) {
+            Bytes meta;
+            if (!ipld->get(*meta_cid, meta)) {
+              return false;
+            }
+            BytesIn meta_input{meta};
+            CborToken token;
+            const CbCid *bls_root{nullptr};
+            const CbCid *secp_root{nullptr};
+            if (read(token, meta_input).listCount() != 2
+                || !codec::cbor::readCborBlake(bls_root, meta_input)
+                || !codec::cbor::readCborBlake(secp_root, meta_input)) {
+              return false;
+            }
+            if (!visitMessages(ipld, *bls_root, bls)
+                || !visitMessages(ipld, *secp_root, secp)) {
+              return false;
+            }
           }
-          if (ts->height() == 0) {
-            partial = false;
-            break;
+          blocks.push_back(std::move(block));
+        }
+
+        writeList(chain, 2);
+        if (request.options & kBlocksOnly) {
+          writeList(chain, blocks.size());
+          for (const auto &block : blocks) {
+            append(chain, *block);
           }
-          OUTCOME_TRY(parent, ts_load->load(ts->getParents()));
-          ts = std::move(parent);
+        } else {
+          writeList(chain, 0);
         }
-        return outcome::success();
-      }()};
-      if (!_result) {
-        log()->debug("failed filling response: {:#}", _result.error());
-      }
+        if (request.options & kMessagesOnly) {
+          writeList(chain, 4);
+          writeMessages(chain, bls);
+          writeMessages(chain, secp);
+        } else {
+          writeNull(chain);
+        }
+        ++bundles;
 
-      if (response.chain.empty()) {
-        response.status = ResponseStatus::kBlockNotFound;
-        response.message = "not found";
-      } else {
-        response.status = partial ? ResponseStatus::kResponsePartial
-                                  : ResponseStatus::kResponseComplete;
+        if (bundles >= depth) {
+          return true;
+        }
+        if (height == 0) {
+          genesis = true;
+          return true;
+        }
+        tsk.assign(parents.begin(), parents.end());
       }
     }
 
   }  // namespace
 
+  bool encodeResponse(const CbIpldPtr &ipld,
+                      const Request &request,
+                      Bytes &out) {
+    bool partial = false;
+    size_t depth = request.depth;
+    if (request.depth > kBlockSyncMaxRequestLength) {
+      partial = true;
+      depth = kBlockSyncMaxRequestLength;
+    }
+
+    Bytes chain;
+    size_t bundles{};
+    bool genesis{false};
+    const auto found{getChain(ipld, request, depth, chain, bundles, genesis)};
+    if (!found) {
+      log()->debug("failed filling response: not found");
+    }
+    if (genesis) {
+      partial = false;
+    }
+
+    std::string_view message;
+    ResponseStatus status{};
+    if (bundles == 0) {
+      status = ResponseStatus::kBlockNotFound;
+      message = "not found";
+    } else {
+      status = partial ? ResponseStatus::kResponsePartial
+                       : ResponseStatus::kResponseComplete;
+    }
+    out.resize(0);
+    out.reserve(chain.size() + message.size() + 32);
+    writeList(out, 3);
+    writeInt(out, common::to_int(status));
+    writeStr(out, message.size());
+    append(out, common::span::cbytes(message));
+    writeList(out, bundles);
+    append(out, chain);
+    return found;
+  }
+
   BlocksyncServer::BlocksyncServer(std::shared_ptr<libp2p::Host> host,
-                                   TsLoadPtr ts_load,
-                                   IpldPtr ipld)
-      : host_(std::move(host)),
-        ts_load_(std::move(ts_load)),
-        ipld_(std::move(ipld)) {
+                                   CbIpldPtr ipld)
+      : host_(std::move(host)), ipld_(std::move(ipld)) {
     assert(host_);
   }
 
@@ -203,25 +314,43 @@ namespace fc::sync::blocksync {
 
   void BlocksyncServer::onRequest(StreamPtr stream,
                                   outcome::result<Request> request) {
+    const auto on_write{[stream](auto) {
+      log()->debug("response written to {}", peerStr(stream->stream()));
+      stream->close();
+    }};
     Response response;
     if (started_) {
       if (isValidRequest(request)) {
         log()->debug("request from {}: depth={}",
                      peerStr(stream->stream()),
                      request.value().depth);
-        getChain(ts_load_, ipld_, request.value(), response);
-      } else {
-        response.status = ResponseStatus::kBadRequest;
-        response.message = "bad request";
+        return stream->writeRaw(getResponse(request.value()), on_write);
       }
+      response.status = ResponseStatus::kBadRequest;
+      response.message = "bad request";
     } else {
       response.status = ResponseStatus::kGoAway;
       response.message = "blocksync server stopped";
     }
-    stream->write(response, [stream](auto) {
-      log()->debug("response written to {}", peerStr(stream->stream()));
-      stream->close();
-    });
+    stream->write(response, on_write);
+  }
+
+  std::shared_ptr<Bytes> BlocksyncServer::getResponse(const Request &request) {
+    CacheKey key{request.block_cids, request.depth, request.options};
+    {
+      std::lock_guard lock{cache_mutex_};
+      if (auto cached{cache_.get(key)}) {
+        return *cached;
+      }
+    }
+    auto response{std::make_shared<Bytes>()};
+    // chain is immutable, but missing blocks may be fetched later
+    if (encodeResponse(ipld_, request, *response)
+        && response->size() <= kMaxCachedResponseBytes) {
+      std::lock_guard lock{cache_mutex_};
+      cache_.insert(key, response);
+    }
+    return response;
   }
 
 }  // namespace fc::sync::blocksync
@@ -5,6 +5,10 @@
 
 #pragma once
 
+#include <boost/compute/detail/lru_cache.hpp>
+#include <mutex>
+
+#include "cbor_blake/ipld.hpp"
 #include "common/libp2p/cbor_stream.hpp"
 #include "node/blocksync_common.hpp"
 
@@ -13,13 +17,27 @@ namespace libp2p {
 }
 
 namespace fc::sync::blocksync {
+  using boost::compute::detail::lru_cache;
+
+  /// Encoded responses kept for peers requesting same ranges
+  constexpr size_t kResponseCacheSize{32};
+  /// Larger responses are not cached, so cache holds at most 64MB
+  constexpr size_t kMaxCachedResponseBytes{2 << 20};
+
+  /**
+   * Encodes response to request, splicing stored cbor of blocks and messages
+   * without decoding them.
+   * @param[out] out - encoded response
+   * @return false if some of requested tipsets or messages were not found
+   */
+  bool encodeResponse(const CbIpldPtr &ipld,
+                      const Request &request,
+                      Bytes &out);
 
   /// Serves blocksync protocol
   class BlocksyncServer : public std::enable_shared_from_this<BlocksyncServer> {
    public:
-    BlocksyncServer(std::shared_ptr<libp2p::Host> host,
-                    TsLoadPtr ts_load,
-                    IpldPtr ipld);
+    BlocksyncServer(std::shared_ptr<libp2p::Host> host, CbIpldPtr ipld);
 
     void start();
 
@@ -28,12 +46,19 @@ namespace fc::sync::blocksync {
    private:
     using StreamPtr = std::shared_ptr<common::libp2p::CborStream>;
 
+    /// (tipset key, depth, options)
+    using CacheKey = std::tuple<std::vector<CbCid>, uint64_t, RequestOptions>;
+
     void onRequest(StreamPtr stream, outcome::result<Request> request);
 
+    /// Returns cached or encodes response
+    std::shared_ptr<Bytes> getResponse(const Request &request);
+
     std::shared_ptr<libp2p::Host> host_;
-    TsLoadPtr ts_load_;
-    IpldPtr ipld_;
+    CbIpldPtr ipld_;
     bool started_ = false;
+    std::mutex cache_mutex_;
+    lru_cache<CacheKey, std::shared_ptr<Bytes>> cache_{kResponseCacheSize};
   };
 
 }  // namespace fc::sync::blocksync
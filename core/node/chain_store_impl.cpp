@@ -52,6 +52,7 @@ namespace fc::sync {
   }
 
   TipsetCPtr ChainStoreImpl::heaviestTipset() const {
+    std::shared_lock lock{head_mutex_};
     assert(head_);
     return head_;
   }
@@ -59,13 +60,14 @@ namespace fc::sync {
   storage::blockchain::ChainStore::connection_t
   ChainStoreImpl::subscribeHeadChanges(
       const std::function<HeadChangeSignature> &subscriber) {
-    assert(head_);
+    const auto head{heaviestTipset()};
     subscriber({primitives::tipset::HeadChange{
-        primitives::tipset::HeadChangeType::CURRENT, head_}});
+        primitives::tipset::HeadChangeType::CURRENT, head}});
     return head_change_signal_.connect(subscriber);
   }
 
   primitives::BigInt ChainStoreImpl::getHeaviestWeight() const {
+    std::shared_lock lock{head_mutex_};
     return heaviest_weight_;
   }
 
@@ -91,10 +93,14 @@ namespace fc::sync {
     for (auto it{std::next(apply.begin())}; it != apply.end(); ++it) {
       notify(it);
     }
-    head_ = ts_load_->lazyLoad(std::prev(apply.end())->second).value();
-    heaviest_weight_ = weight;
+    auto head{ts_load_->lazyLoad(std::prev(apply.end())->second).value()};
+    {
+      std::unique_lock lock{head_mutex_};
+      head_ = head;
+      heaviest_weight_ = weight;
+    }
     head_change_signal_(events);
-    events_->signalCurrentHead({.tipset = head_, .weight = heaviest_weight_});
+    events_->signalCurrentHead({.tipset = std::move(head), .weight = weight});
   }
 
 }  // namespace fc::sync
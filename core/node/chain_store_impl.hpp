@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <shared_mutex>
+
 #include "node/common.hpp"
 #include "node/head_constructor.hpp"
 #include "primitives/tipset/chain.hpp"
@@ -44,6 +46,8 @@ namespace fc::sync {
 
     std::shared_ptr<events::Events> events_;
 
+    /** head is read by rpc workers */
+    mutable std::shared_mutex head_mutex_;
     TipsetCPtr head_;
     BigInt heaviest_weight_;
 
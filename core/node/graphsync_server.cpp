@@ -5,6 +5,8 @@
 
 #include "node/graphsync_server.hpp"
 
+#include <boost/compute/detail/lru_cache.hpp>
+
 #include "common/hexutil.hpp"
 #include "common/logger.hpp"
 #include "storage/ipfs/graphsync/graphsync.hpp"
@@ -13,6 +15,9 @@
 namespace fc::sync {
 
   namespace gs = storage::ipfs::graphsync;
+  using boost::compute::detail::lru_cache;
+  using storage::ipld::SelectorPtr;
+  using storage::ipld::traverser::Traverser;
 
   namespace {
     auto log() {
@@ -20,36 +25,78 @@ namespace fc::sync {
       return logger.get();
     }
 
-    gs::Response handleRequest(Ipld &ipld, gs::Request request) {
-      gs::Response response;
+    /// Max size of blocks in one response chunk
+    constexpr size_t kResponseChunkBytes{256 << 10};
+    /// Max count of remembered sent blocks, which are not sent again
+    constexpr size_t kSentCacheSize{1024};
+
+    /** Traversal state of request, kept between response chunks */
+    struct ResponseState {
+      ResponseState(IpldPtr ipld,
+                    const CID &root,
+                    SelectorPtr selector,
+                    size_t budget)
+          : ipld{std::move(ipld)},
+            traverser{*this->ipld, root, std::move(selector), false},
+            budget{budget} {}
 
-      log()->debug("got new request with selector: {}",
-                   common::hex_lower(request.selector));
+      IpldPtr ipld;
+      Traverser traverser;
+      lru_cache<CID, bool> sent{kSentCacheSize};
+      bool missing{};
+      /** blocks left to visit */
+      size_t budget{};
+    };
 
-      storage::ipld::traverser::Traverser traverser{
-          ipld, request.root_cid, {request.selector}, true};
-      auto ok{true};
-      if (auto _cids{traverser.traverseAll()}) {
-        for (auto &cid : _cids.value()) {
-          if (auto _data{ipld.get(cid)}) {
-            response.data.push_back({std::move(cid), std::move(_data.value())});
+    /** Traverses up to chunk size of blocks on each call */
+    gs::Responder makeResponder(std::shared_ptr<ResponseState> state) {
+      return [state{std::move(state)}](
+                 bool ok) -> boost::optional<gs::Response> {
+        if (!ok) {
+          return boost::none;
+        }
+        gs::Response response;
+        size_t bytes{};
+        while (!state->traverser.isCompleted() && state->budget != 0
+               && bytes < kResponseChunkBytes) {
+          --state->budget;
+          auto block{state->traverser.advanceBlock()};
+          if (!block) {
+            state->missing = true;
+            continue;
+          }
+          auto &[cid, content]{block.value()};
+          if (state->sent.get(cid)) {
+            continue;
+          }
+          state->sent.insert(cid, true);
+          bytes += content.size();
+          response.data.push_back({std::move(cid), std::move(content)});
+        }
+        if (!state->traverser.isCompleted()) {
+          if (state->budget == 0) {
+            log()->debug("request exceeded visited blocks budget");
+            response.status = gs::RS_REQUEST_FAILED;
           } else {
-            ok = false;
-            break;
+            response.status = gs::RS_PARTIAL_RESPONSE;
           }
+        } else {
+          response.status =
+              state->missing ? gs::RS_PARTIAL_CONTENT : gs::RS_FULL_CONTENT;
         }
-      }
-      response.status = ok ? gs::RS_FULL_CONTENT : gs::RS_INTERNAL_ERROR;
-
-      return response;
+        return response;
+      };
     }
 
   }  // namespace
 
   GraphsyncServer::GraphsyncServer(
       std::shared_ptr<storage::ipfs::graphsync::Graphsync> graphsync,
-      IpldPtr ipld)
-      : graphsync_(std::move(graphsync)), ipld_(std::move(ipld)) {
+      IpldPtr ipld,
+      size_t max_visited_blocks)
+      : graphsync_(std::move(graphsync)),
+        ipld_(std::move(ipld)),
+        max_visited_blocks_(max_visited_blocks) {
     assert(graphsync_);
     assert(ipld_);
   }
@@ -58,10 +105,22 @@ namespace fc::sync {
     if (!started_) {
       graphsync_->setDefaultRequestHandler(
           [this](gs::FullRequestId id, gs::Request request) {
-            gs::Response response = handleRequest(*ipld_, std::move(request));
+            log()->debug("got new request with selector: {}",
+                         common::hex_lower(request.selector));
 
-            // this may be done asynchronously as well!
-            graphsync_->postResponse(id, response);
+            auto selector{storage::ipld::parseSelector(request.selector)};
+            if (!selector) {
+              log()->debug("selector error: {}", selector.error().message());
+              graphsync_->postResponse(id, {gs::RS_REQUEST_FAILED, {}, {}});
+              return;
+            }
+            graphsync_->postBlocks(
+                id,
+                makeResponder(
+                    std::make_shared<ResponseState>(ipld_,
+                                                    request.root_cid,
+                                                    std::move(selector.value()),
+                                                    max_visited_blocks_)));
           });
       graphsync_->start();
       started_ = true;
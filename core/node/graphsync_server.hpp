@@ -14,17 +14,26 @@ namespace fc::sync {
    public:
     using Graphsync = storage::ipfs::graphsync::Graphsync;
 
-    GraphsyncServer(std::shared_ptr<Graphsync> graphsync, IpldPtr ipld);
+    /**
+     * Max blocks visited by one request.
+     * Traverser doesn't skip shared subtrees, so dag with many shared links
+     * could be walked exponentially long.
+     */
+    static constexpr size_t kMaxVisitedBlocks{1 << 20};
+
+    GraphsyncServer(std::shared_ptr<Graphsync> graphsync,
+                    IpldPtr ipld,
+                    size_t max_visited_blocks = kMaxVisitedBlocks);
 
     void start();
 
    private:
     std::shared_ptr<Graphsync> graphsync_;
     IpldPtr ipld_;
+    size_t max_visited_blocks_;
     bool started_ = false;
 
     // TODO (artem):
-    // 0) selectors and true IPLD backend
     // 1) request handling in dedicated thread with separate read-only
     // storage access (and RS_TRY_AGAIN replies if queue overloaded)
     // 2) Response caching (hash(request fields)) -> response
@@ -58,6 +58,8 @@
 #include "node/sync_job.hpp"
 #include "primitives/tipset/chain.hpp"
 #include "primitives/tipset/file.hpp"
+#include "proofs/impl/proof_engine_impl.hpp"
+#include "proofs/seal_verifier.hpp"
 #include "storage/car/car.hpp"
 #include "storage/car/cids_index/util.hpp"
 #include "storage/chain/msg_waiter.hpp"
@@ -71,6 +73,7 @@
 #include "vm/actor/impl/invoker_impl.hpp"
 #include "vm/interpreter/impl/cached_interpreter.hpp"
 #include "vm/interpreter/impl/interpreter_impl.hpp"
+#include "vm/message/sig_verifier.hpp"
 #include "vm/runtime/circulating.hpp"
 #include "vm/runtime/impl/tipset_randomness.hpp"
 #include "vm/state/impl/state_tree_impl.hpp"
@@ -357,13 +360,17 @@ namespace fc::node {
                                            o.kv_store,
                                            writableIpld(config, o),
                                            ts_mutex);
-    o.ipld = std::make_shared<CbAsAnyIpld>(o.compacter);
+    // estimated, 256mb
+    o.block_cache = std::make_shared<storage::ipld::CachedCbIpld>(
+        o.compacter, size_t{256} << 20);
+    o.ipld = std::make_shared<CbAsAnyIpld>(o.block_cache);
 
     // estimated, 80gb
     o.compacter->compact_on_car = uint64_t{80} << 30;
     o.compacter->epochs_full_state = 30;
     o.compacter->epochs_lookback_state = 2400;
     o.compacter->epochs_messages = 60;
+    o.compacter->gc = config.compacter_gc;
 
     o.ts_load_ipld = std::make_shared<primitives::tipset::TsLoadIpld>(o.ipld);
     o.compacter->ts_load = o.ts_load_ipld;
@@ -404,6 +411,15 @@ namespace fc::node {
             std::make_shared<AnyAsCbIpld>(o.ipld));
     OUTCOME_TRYA(o.env_context.circulating,
                  vm::Circulating::make(o.ipld, *config.genesis_cid));
+    o.env_context.sig_verifier =
+        std::make_shared<vm::message::SigVerifier>(config.sig_verify_threads,
+                                                   vm::message::kSigCacheSize,
+                                                   vm::message::kSigRateLimit);
+    o.env_context.seal_verifier = std::make_shared<proofs::SealVerifier>(
+        config.seal_verify_threads,
+        std::make_shared<proofs::ProofEngineImpl>(),
+        std::make_shared<proofs::SealCache>(
+            std::make_shared<storage::MapPrefix>("seal_cache/", o.kv_store)));
 
     auto block_validator{
         std::make_shared<blockchain::block_validator::BlockValidator>(
@@ -416,6 +432,7 @@ namespace fc::node {
 
     o.interpreter = std::make_shared<vm::interpreter::InterpreterImpl>(
         o.env_context, block_validator, weight_calculator);
+    o.interpreter->speculative_threads = config.speculative_threads;
     o.vm_interpreter = std::make_shared<vm::interpreter::CachedInterpreter>(
         o.interpreter, o.env_context.interpreter_cache);
     o.compacter->interpreter->interpreter = o.vm_interpreter;
@@ -495,7 +512,8 @@ namespace fc::node {
           return ByteArray(h.data(), h.data() + h.size());
         });
 
-    o.pubsub_gate = std::make_shared<sync::PubSubGate>(o.gossip);
+    o.pubsub_gate = std::make_shared<sync::PubSubGate>(
+        o.gossip, o.env_context.sig_verifier);
 
     auto id_manager =
         injector.create<std::shared_ptr<libp2p::peer::IdentityManager>>();
@@ -517,7 +535,7 @@ namespace fc::node {
     log()->debug("Creating chain loaders...");
 
     o.blocksync_server = std::make_shared<fc::sync::blocksync::BlocksyncServer>(
-        o.host, o.ts_load_ipld, o.ipld);
+        o.host, o.block_cache);
 
     log()->debug("Creating chain store...");
 
@@ -556,7 +574,11 @@ namespace fc::node {
     createMessagePool(config, o);
 
     auto msg_waiter = storage::blockchain::MsgWaiter::create(
-        o.ts_load, o.ipld, o.io_context, o.chain_store);
+        o.ts_load,
+        o.ipld,
+        o.io_context,
+        o.chain_store,
+        std::make_shared<storage::MapPrefix>("msg_index/", o.kv_store));
 
     o.key_store = std::make_shared<storage::keystore::FileSystemKeyStore>(
         (config.repo_path / "keystore").string(), bls_provider, secp_provider);
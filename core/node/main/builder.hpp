@@ -10,6 +10,7 @@
 
 #include "api/full_node/node_api.hpp"
 #include "api/full_node/node_api_v1_wrapper.hpp"
+#include "api/rpc/executor.hpp"
 #include "api/rpc/json.hpp"
 #include "api/types/key_info.hpp"
 #include "common/outcome.hpp"
@@ -27,6 +28,7 @@
 #include "storage/car/cids_index/cids_index.hpp"
 #include "storage/compacter/compacter.hpp"
 #include "storage/ipfs/impl/datastore_leveldb.hpp"
+#include "storage/ipld/block_cache.hpp"
 #include "storage/ipld/cids_ipld.hpp"
 #include "storage/keystore/keystore.hpp"
 #include "storage/leveldb/leveldb.hpp"
@@ -63,6 +65,7 @@ namespace fc::node {
     std::shared_ptr<storage::ipld::CidsIpld> ipld_cids;
     std::shared_ptr<IoThread> ipld_flush_thread;
     std::shared_ptr<storage::compacter::CompacterIpld> compacter;
+    std::shared_ptr<storage::ipld::CachedCbIpld> block_cache;
     IpldPtr ipld;
     std::shared_ptr<primitives::tipset::TsLoadIpld> ts_load_ipld;
     std::shared_ptr<primitives::tipset::TsLoadCache> ts_load;
@@ -121,6 +124,9 @@ namespace fc::node {
     std::shared_ptr<api::FullNodeApiV1Wrapper> api_v1;
     // Full node API v2.x.x (latest)
     std::shared_ptr<api::FullNodeApi> api;
+    // API sockets and executor of methods
+    std::shared_ptr<IoThread> api_thread;
+    std::shared_ptr<api::rpc::Executor> api_executor;
   };
 
   /**
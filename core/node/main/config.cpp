@@ -71,6 +71,21 @@ namespace fc::node {
            "on first run, imports a default key from a given file. The key "
            "must be a BLS private key.");
     option("mpool_bls_cache_size", po::value(&config.mpool_bls_cache_size));
+    option("compacter-gc",
+           po::value(&config.compacter_gc),
+           "reclaim dead blocks of car in place instead of rewriting it");
+    option("speculative-threads",
+           po::value(&config.speculative_threads),
+           "threads to execute tipset messages speculatively, 0 for serial");
+    option("sig-verify-threads",
+           po::value(&config.sig_verify_threads),
+           "threads to verify message signatures of blocks");
+    option("seal-verify-threads",
+           po::value(&config.seal_verify_threads),
+           "threads to verify seals batched by cron");
+    option("api-threads",
+           po::value(&config.api_threads),
+           "threads to run read-only api methods, 0 for main thread");
 
     po::options_description drand_desc("Drand server options");
     auto drand_option{drand_desc.add_options()};
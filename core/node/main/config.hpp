@@ -50,6 +50,19 @@ namespace fc::node {
 
     size_t mpool_bls_cache_size{1000};
 
+    /** Compact car incrementally in place instead of rewriting it */
+    bool compacter_gc{false};
+
+    /** Threads to execute tipset messages speculatively, 0 for serial */
+    size_t speculative_threads{0};
+
+    /** Threads to verify message signatures of blocks with calling thread */
+    size_t sig_verify_threads{2};
+    size_t seal_verify_threads{4};
+
+    /** Threads to run read-only API methods, 0 to run API on main thread */
+    size_t api_threads{4};
+
     static Config read(int argc, char *argv[]);
 
     std::string join(const std::string &path) const;
@@ -10,6 +10,8 @@
 #include "api/full_node/make.hpp"
 #include "api/full_node/node_api_v1_wrapper.hpp"
 #include "api/network/setup_net.hpp"
+#include "api/rpc/broadcast.hpp"
+#include "api/rpc/executor.hpp"
 #include "api/rpc/info.hpp"
 #include "api/rpc/make.hpp"
 #include "api/rpc/ws.hpp"
@@ -62,6 +64,8 @@ namespace fc {
   using node::Metrics;
   using node::NodeObjects;
   using primitives::jwt::kAllPermission;
+  using primitives::tipset::HeadChange;
+  using primitives::tipset::HeadChangeType;
   using primitives::sector::getPreferredSealProofTypeFromWindowPoStType;
 
   namespace {
@@ -241,6 +245,34 @@ namespace fc {
         *node_objects.api,
         std::bind(node_objects.api->AuthVerify, std::placeholders::_1))};
 
+    // subscription channels shared by sessions are encoded once
+    auto chain_notify{std::make_shared<api::rpc::Broadcast>(
+        o.api->ChainNotify.getPerm(), [chain_store{o.chain_store}] {
+          return api::rpc::Broadcast::encode(std::vector<HeadChange>{
+              {HeadChangeType::CURRENT, chain_store->heaviestTipset()}});
+        })};
+    o.chain_store->subscribeHeadChanges(
+        [chain_notify](auto &changes) { chain_notify->write(changes); });
+    auto mpool_sub{
+        std::make_shared<api::rpc::Broadcast>(o.api->MpoolSub.getPerm())};
+    o.mpool->subscribe(
+        [mpool_sub](auto &update) { mpool_sub->write(update); });
+    for (const auto &_rpc : {rpc_v1, rpc}) {
+      _rpc->setup(o.api->ChainNotify.getName(),
+                  chain_notify->method(),
+                  o.api->ChainNotify.getPerm());
+      _rpc->setup(o.api->MpoolSub.getName(),
+                  mpool_sub->method(),
+                  o.api->MpoolSub.getPerm());
+    }
+
+    if (config.api_threads != 0) {
+      o.api_executor = std::make_shared<api::rpc::Executor>(
+          config.api_threads, api::rpc::kRpcQueueLimit, o.io_context);
+      o.api_executor->wrap(*rpc_v1);
+      o.api_executor->wrap(*rpc);
+      o.api_thread = std::make_shared<IoThread>();
+    }
     metricApiTime(*rpc_v1);
     metricApiTime(*rpc);
 
@@ -250,11 +282,13 @@ namespace fc {
 
     auto routes{std::make_shared<api::Routes>()};
 
-    auto text_route{[](auto f) -> api::RouteHandler {
-      return [f{std::move(f)}](auto &, auto &cb) {
-        api::http::response<api::http::string_body> res;
-        res.body() = f();
-        cb(api::WrapperResponse{std::move(res)});
+    auto text_route{[&](auto f) -> api::RouteHandler {
+      return [io{o.io_context}, f{std::move(f)}](auto &, auto &cb) {
+        io->post([f, cb] {
+          api::http::response<api::http::string_body> res;
+          res.body() = f();
+          cb(api::WrapperResponse{std::move(res)});
+        });
       };
     }};
     routes->emplace("/health",
@@ -262,8 +296,12 @@ namespace fc {
     routes->emplace("/metrics",
                     text_route([&] { return metrics.prometheus(); }));
 
-    api::serve(
-        rpcs, routes, *node_objects.io_context, config.api_ip, config.api_port);
+    // sockets are served on own thread when methods run on executor
+    api::serve(rpcs,
+               routes,
+               o.api_thread ? *o.api_thread->io : *o.io_context,
+               config.api_ip,
+               config.api_port);
     auto api_secret = loadApiSecret(config.join("jwt_secret")).value();
     auto token = generateAuthToken(api_secret, kAllPermission).value();
     api::rpc::saveInfo(config.repo_path, config.api_port, token);
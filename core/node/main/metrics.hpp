@@ -17,6 +17,8 @@
 #include "node/events.hpp"
 #include "node/main/builder.hpp"
 #include "node/sync_job.hpp"
+#include "storage/amt/amt.hpp"
+#include "storage/hamt/hamt.hpp"
 
 namespace fc::node {
   struct Metrics {
@@ -77,20 +79,37 @@ namespace fc::node {
           o.chain_epoch_clock->epochAtTime(o.utc_clock->nowUTC()).value()};
       metric("height_expected", height_expected);
 
-      auto car{[&](auto _size, auto _count, auto _tmp, auto &ipld) {
+      auto car{[&](const std::string &prefix, auto &ipld) {
         if (ipld) {
           std::shared_lock index_lock{ipld->index_mutex};
           std::shared_lock written_lock{ipld->written_mutex};
-          metric(_size, ipld->car_offset);
-          metric(_count, ipld->index->size());
-          metric(_tmp, ipld->written.size());
+          metric(prefix + "_size", ipld->car_offset);
+          metric(prefix + "_count", ipld->indexSize());
+          metric(prefix + "_tmp", ipld->written.size());
+          metric(prefix + "_runs", ipld->runs.size());
+          if (ipld->bloom) {
+            metric(prefix + "_bloom_bytes", ipld->bloom->bytes());
+            metric(prefix + "_bloom_fpr", ipld->bloomFalsePositiveRate());
+          }
         }
       }};
       {
         std::unique_lock ipld_lock{o.compacter->ipld_mutex};
-        car("car_size", "car_count", "car_tmp", o.compacter->old_ipld);
-        car("car2_size", "car2_count", "car2_tmp", o.compacter->new_ipld);
+        car("car", o.compacter->old_ipld);
+        car("car2", o.compacter->new_ipld);
       }
+      metric("compacter_copied_blocks", o.compacter->copied_blocks);
+      metric("compacter_copied_bytes", o.compacter->copied_bytes);
+      metric("compacter_copy_rate", o.compacter->copy_rate);
+      metric("compacter_gc_reclaimed", o.compacter->gc_reclaimed);
+      metric("block_cache_bytes", o.block_cache->bytes());
+      metric("block_cache_hits", o.block_cache->hits);
+      metric("block_cache_misses", o.block_cache->misses);
+      metric("block_cache_hit_rate", o.block_cache->hitRate());
+      metric("hamt_node_cache_hits", storage::hamt::nodeCache().hits);
+      metric("hamt_node_cache_misses", storage::hamt::nodeCache().misses);
+      metric("amt_node_cache_hits", storage::amt::nodeCache().hits);
+      metric("amt_node_cache_misses", storage::amt::nodeCache().misses);
 
       auto &instances{libp2p::metrics::instance::State::get()};
       std::unique_lock instances_lock{instances.mutex};
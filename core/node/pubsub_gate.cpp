@@ -10,6 +10,7 @@
 #include "common/prometheus/metrics.hpp"
 #include "primitives/block/block.hpp"
 #include "primitives/cid/cid_of_cbor.hpp"
+#include "vm/message/sig_verifier.hpp"
 
 namespace fc::sync {
 
@@ -28,8 +29,9 @@ namespace fc::sync {
     }
   }  // namespace
 
-  PubSubGate::PubSubGate(std::shared_ptr<Gossip> gossip)
-      : gossip_(std::move(gossip)) {
+  PubSubGate::PubSubGate(std::shared_ptr<Gossip> gossip,
+                         std::shared_ptr<SigVerifier> verifier)
+      : gossip_(std::move(gossip)), verifier_(std::move(verifier)) {
     assert(gossip_);
   }
 
@@ -112,12 +114,32 @@ namespace fc::sync {
     metric.Increment();
   }
 
+  bool PubSubGate::throttle() const {
+    if (!verifier_ || !verifier_->busy()) {
+      return false;
+    }
+    static auto &metric{prometheus::BuildCounter()
+                            .Name("lotus_pubsub_throttled")
+                            .Help("Counter for gossip messages ignored while "
+                                  "signature verification is busy")
+                            .Register(prometheusRegistry())
+                            .Add({})};
+    metric.Increment();
+    return true;
+  }
+
   bool PubSubGate::onBlock(const PeerId &from, const Bytes &raw) {
     try {
       OUTCOME_EXCEPT(bm, codec::cbor::decode<BlockWithCids>(raw));
       auto cbor{codec::cbor::encode(bm.header).value()};
 
-      // TODO validate
+      // messages are not available here, block validator checks the rest
+      const auto &header{bm.header};
+      if (!header.ticket || !header.block_sig || !header.bls_aggregate
+          || !header.bls_aggregate->isBls() || !header.miner.isId()) {
+        log()->error("pubsub: invalid block from peer {}", from.toBase58());
+        return false;
+      }
 
       static auto &metric{prometheus::BuildCounter()
                               .Name("lotus_block_received")
@@ -144,6 +166,10 @@ namespace fc::sync {
       log()->error("pubsub: empty message from peer {}", from.toBase58());
       return false;
     }
+    if (throttle()) {
+      // ignored, not forwarded and not reported as invalid
+      return false;
+    }
 
     std::error_code e;
 
@@ -152,6 +178,16 @@ namespace fc::sync {
       e = cid_res.error();
     } else {
       auto res = codec::cbor::decode<primitives::block::SignedMessage>(raw);
+      if (res && verifier_) {
+        // messages from id address are verified by mpool
+        const auto &sender{res.value().message.from};
+        if (sender.isKeyType()) {
+          if (auto verified{verifier_->verify(sender, res.value())};
+              !verified) {
+            res = verified.error();
+          }
+        }
+      }
       if (res) {
         static auto &metric{prometheus::BuildCounter()
                                 .Name("lotus_message_received")
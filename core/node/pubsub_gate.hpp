@@ -7,6 +7,7 @@
 
 #include <libp2p/protocol/gossip/gossip.hpp>
 
+#include "fwd.hpp"
 #include "node/events.hpp"
 
 namespace fc::clock {
@@ -16,10 +17,14 @@ namespace fc::clock {
 namespace fc::sync {
 
   using Gossip = libp2p::protocol::gossip::Gossip;
+  using vm::message::SigVerifier;
 
   class PubSubGate : public std::enable_shared_from_this<PubSubGate> {
    public:
-    explicit PubSubGate(std::shared_ptr<Gossip> gossip);
+    /// Verifier checks message signatures and throttles gossip messages
+    /// when busy, blocks are never throttled
+    explicit PubSubGate(std::shared_ptr<Gossip> gossip,
+                        std::shared_ptr<SigVerifier> verifier = nullptr);
 
     void start(const std::string &network_name,
                std::shared_ptr<events::Events> events);
@@ -39,7 +44,11 @@ namespace fc::sync {
     bool onBlock(const PeerId &from, const Bytes &raw);
     bool onMsg(const PeerId &from, const Bytes &raw);
 
+    /// Gossip messages are ignored while verifier is busy
+    bool throttle() const;
+
     std::shared_ptr<Gossip> gossip_;
+    std::shared_ptr<SigVerifier> verifier_;
 
     std::shared_ptr<events::Events> events_;
 
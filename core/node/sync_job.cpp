@@ -5,26 +5,84 @@
 
 #include "node/sync_job.hpp"
 
+#include "cbor_blake/ipld_version.hpp"
 #include "common/error_text.hpp"
 #include "common/logger.hpp"
 #include "common/outcome_fmt.hpp"
+#include "common/prometheus/metrics.hpp"
 #include "node/blocksync_common.hpp"
 #include "node/chain_store_impl.hpp"
 #include "node/events.hpp"
 #include "node/fetch_msg.hpp"
 #include "node/peer_height.hpp"
+#include "vm/actor/builtin/types/miner/policy.hpp"
 #include "vm/interpreter/interpreter.hpp"
+#include "vm/state/impl/state_tree_impl.hpp"
 
 namespace fc::sync {
   using primitives::tipset::chain::stepParent;
 
   constexpr auto kBranchCompactTreshold{200u};
 
+  /// Tipsets after interpreted one to fetch messages for
+  constexpr size_t kInterpretLookahead{8};
+
+  /// Max header requests in flight, at most one per peer
+  constexpr size_t kFetchWindow{8};
+  constexpr size_t kFetchAttempts{3};
+  constexpr uint64_t kFetchDepthMin{10};
+  constexpr uint64_t kFetchDepthInitial{100};
+  /// Blocksync server limit
+  constexpr uint64_t kFetchDepthMax{
+      vm::actor::builtin::types::miner::kChainFinality};
+  /// Depth is adapted to peer throughput to complete in this time
+  constexpr std::chrono::seconds kFetchDuration{5};
+  constexpr uint64_t kFetchTimeoutMs{15000};
+
   namespace {
     auto log() {
       static common::Logger logger = common::createLogger("sync_job");
       return logger.get();
     }
+
+    auto &metricStage(const std::string &stage) {
+      static auto &x{prometheus::BuildHistogram()
+                         .Name("sync_interpret_stage_ms")
+                         .Help("Time spent in tipset interpretation stages")
+                         .Register(prometheusRegistry())};
+      return x.Add({{"stage", stage}}, kDefaultPrometheusMsBuckets);
+    }
+
+    /**
+     * Loads actors touched by tipset messages and their state heads, so
+     * interpreter finds their blocks and nodes in cache.
+     * Parent state of tipset may be not computed yet, so state of previous
+     * tipset is used, most of tree nodes are the same.
+     */
+    void warmState(const IpldPtr &ipld,
+                   const TipsetCPtr &ts,
+                   const CID &state_root) {
+      const auto vipld{withVersion(ipld, ts->height())};
+      vm::state::StateTreeImpl tree{vipld, state_root};
+      std::set<primitives::address::Address> warmed;
+      auto warm{[&](const primitives::address::Address &address) {
+        if (!warmed.insert(address).second) {
+          return;
+        }
+        if (auto _actor{tree.tryGet(address)}) {
+          if (const auto &actor{_actor.value()}) {
+            std::ignore = vipld->get(actor->head);
+          }
+        }
+      }};
+      std::ignore = ts->visitMessages(
+          {vipld, false, true},
+          [&](auto, auto, auto &, auto, auto *msg) -> outcome::result<void> {
+            warm(msg->from);
+            warm(msg->to);
+            return outcome::success();
+          });
+    }
   }  // namespace
 
   outcome::result<TipsetCPtr> stepUp(const TsLoadPtr &ts_load,
@@ -139,7 +197,7 @@ namespace fc::sync {
     if (auto ts{getLocal(e.head)}) {
       onTs(e.source, ts);
     } else if (e.source) {
-      fetch(*e.source, e.head);
+      fetch(*e.source, e.head, e.height);
     }
   }
 
@@ -227,7 +285,7 @@ namespace fc::sync {
             continue;
           }
           if (peer) {
-            fetch(*peer, *branch->parent_key);
+            fetch(*peer, *branch->parent_key, branch->chain.begin()->first);
           }
         }
       }
@@ -364,8 +422,17 @@ namespace fc::sync {
     }
     auto ts{interpret_ts_};
     if (!fetch_msg_->has(ts, true)) {
+      if (!interpret_wait_) {
+        interpret_wait_.emplace();
+      }
+      prefetch(ts);
       return;
     }
+    if (interpret_wait_) {
+      static auto &metric{metricStage("messages")};
+      metric.Observe(interpret_wait_->ms());
+      interpret_wait_.reset();
+    }
     auto branch{find(*ts_branches_, ts).first};
     if (!checkParent(ts)) {
       // TODO(turuslan): detach and ban branches
@@ -373,8 +440,12 @@ namespace fc::sync {
       return;
     }
     interpreting_ = true;
+    prefetch(ts);
     interpret_thread.io->post([=] {
+      static auto &metric{metricStage("interpret")};
+      const Since since;
       auto result{interpreter_->interpret(branch, ts)};
+      metric.Observe(since.ms());
       if (!result) {
         log()->warn("interpret error {:#} {} {}",
                     result.error(),
@@ -405,9 +476,39 @@ namespace fc::sync {
     });
   }
 
-  void SyncJob::fetch(const PeerId &peer, const TipsetKey &tsk) {
+  void SyncJob::prefetch(const TipsetCPtr &ts) {
+    TipsetCPtr warm;
+    auto next{ts};
+    for (size_t i{}; i < kInterpretLookahead; ++i) {
+      auto _next{stepUp(ts_load_, attached_heaviest_.first, next)};
+      if (!_next || !_next.value()) {
+        break;
+      }
+      next = _next.value();
+      if (fetch_msg_->has(next, false) && i == 0) {
+        warm = next;
+      }
+    }
+    if (!warm || warmed_ == warm->key || warming_) {
+      return;
+    }
+    warmed_ = warm->key;
+    warming_ = true;
+    prefetch_thread.io->post(
+        [this, warm, state_root{ts->getParentStateRoot()}] {
+          static auto &metric{metricStage("warm")};
+          const Since since;
+          warmState(ipld_, warm, state_root);
+          metric.Observe(since.ms());
+          warming_ = false;
+        });
+  }
+
+  void SyncJob::fetch(const PeerId &peer,
+                      const TipsetKey &tsk,
+                      ChainEpoch height) {
     std::unique_lock lock{requests_mutex_};
-    requests_.emplace(peer, tsk);
+    requests_.push({peer, tsk, height, 0, {}});
     lock.unlock();
     io_->post([=] { fetchDequeue(); });
   }
@@ -415,52 +516,149 @@ namespace fc::sync {
   void SyncJob::fetchDequeue() {
     std::lock_guard lock{requests_mutex_};
     static size_t hung_blocksync{};
-    if (request_ && Clock::now() >= request_expiry_) {
-      ++hung_blocksync;
-      log()->warn("hung blocksync {}", hung_blocksync);
-      request_.reset();
+    const auto now{Clock::now()};
+    for (auto it{fetching_.begin()}; it != fetching_.end();) {
+      if (now >= it->second.expiry) {
+        ++hung_blocksync;
+        log()->warn("hung blocksync {}", hung_blocksync);
+        auto fetching{std::move(it->second)};
+        it = fetching_.erase(it);
+        fetchDone(std::move(fetching), 0);
+      } else {
+        ++it;
+      }
     }
-    if (request_) {
-      return;
+    while (!requests_.empty() && fetching_.size() < kFetchWindow) {
+      auto &front{requests_.front()};
+      if (fetching_.count(front.tsk) != 0) {
+        requests_.pop();
+        continue;
+      }
+      if (auto ts{getLocal(front.tsk)}) {
+        io_->post([=, peer{front.peer}] { onTs(peer, ts); });
+        requests_.pop();
+        continue;
+      }
+      auto wait{false};
+      auto peer{fetchPeer(front, wait)};
+      if (!peer) {
+        if (wait) {
+          break;
+        }
+        log()->debug("no peers to fetch {}", front.tsk.cidsStr());
+        requests_.pop();
+        continue;
+      }
+      auto fetch{std::move(front)};
+      requests_.pop();
+      auto &stats{peer_stats_[*peer]};
+      if (stats.depth == 0) {
+        stats.depth = kFetchDepthInitial;
+      }
+      stats.busy = true;
+      const auto depth{stats.depth};
+      const auto tsk{fetch.tsk};
+      fetching_.emplace(
+          tsk,
+          Fetching{
+              std::move(fetch),
+              *peer,
+              depth,
+              now,
+              now + std::chrono::seconds{20}
+                  + std::chrono::milliseconds{depth * 100},
+              BlocksyncRequest::newRequest(
+                  *host_,
+                  *scheduler_,
+                  ipld_,
+                  put_block_header_,
+                  *peer,
+                  tsk.cids(),
+                  depth,
+                  blocksync::kBlocksOnly,
+                  kFetchTimeoutMs,
+                  [this, tsk](auto r) {
+                    downloaderCallback(tsk, std::move(r));
+                  }),
+          });
     }
-    if (requests_.empty()) {
+  }
+
+  boost::optional<PeerId> SyncJob::fetchPeer(const Fetch &fetch, bool &wait) {
+    auto idle{[&](const PeerId &peer) {
+      if (fetch.failed.count(peer) != 0) {
+        return false;
+      }
+      const auto it{peer_stats_.find(peer)};
+      if (it != peer_stats_.end() && it->second.busy) {
+        wait = true;
+        return false;
+      }
+      return true;
+    }};
+    if (fetch.peer && idle(*fetch.peer)) {
+      return fetch.peer;
+    }
+    boost::optional<PeerId> best;
+    double best_rate{-1};
+    peers_->visit(fetch.height, [&](const PeerId &peer) {
+      if (idle(peer)) {
+        const auto it{peer_stats_.find(peer)};
+        const auto rate{it != peer_stats_.end() ? it->second.rate : 0};
+        if (rate > best_rate) {
+          best = peer;
+          best_rate = rate;
+        }
+      }
+      return true;
+    });
+    return best;
+  }
+
+  void SyncJob::fetchDone(Fetching &&fetching, size_t tipsets) {
+    if (tipsets != 0) {
+      auto &stats{peer_stats_[fetching.peer]};
+      stats.busy = false;
+      const std::chrono::duration<double> elapsed{Clock::now()
+                                                  - fetching.start};
+      const auto rate{tipsets / std::max(elapsed.count(), 1e-3)};
+      stats.rate = stats.rate == 0 ? rate : (stats.rate + rate) / 2;
+      stats.depth =
+          std::clamp(static_cast<uint64_t>(stats.rate * kFetchDuration.count()),
+                     kFetchDepthMin,
+                     kFetchDepthMax);
       return;
     }
-    auto [peer, tsk]{std::move(requests_.front())};
-    requests_.pop();
-    if (auto ts{getLocal(tsk)}) {
-      io_->post([=, peer{std::move(peer)}] { onTs(peer, ts); });
+    peer_stats_.erase(fetching.peer);
+    peers_->onError(fetching.peer);
+    auto &fetch{fetching.fetch};
+    ++fetch.attempt;
+    if (fetch.attempt >= kFetchAttempts) {
+      log()->debug("fetch failed {}", fetch.tsk.cidsStr());
       return;
     }
-    uint64_t probable_depth = 100;
-    request_expiry_ = Clock::now() + std::chrono::seconds{20};
-    request_ = BlocksyncRequest::newRequest(
-        *host_,
-        *scheduler_,
-        ipld_,
-        put_block_header_,
-        peer,
-        tsk.cids(),
-        probable_depth,
-        blocksync::kBlocksOnly,
-        15000,
-        [this](auto r) { downloaderCallback(std::move(r)); });
+    fetch.failed.emplace(fetching.peer);
+    fetch.peer.reset();
+    requests_.push(std::move(fetch));
   }
 
-  void SyncJob::downloaderCallback(BlocksyncRequest::Result r) {
-    std::unique_lock lock{requests_mutex_};
-    if (request_) {
-      request_.reset();
-    }
-    lock.unlock();
-
+  void SyncJob::downloaderCallback(const TipsetKey &tsk,
+                                   BlocksyncRequest::Result r) {
     TipsetCPtr ts;
     if (auto _ts{ts_load_->load(r.blocks_available)}) {
       ts = _ts.value();
-    } else {
-      peers_->onError(*r.from);
     }
 
+    std::unique_lock lock{requests_mutex_};
+    const auto it{fetching_.find(tsk)};
+    if (it == fetching_.end()) {
+      return;
+    }
+    auto fetching{std::move(it->second)};
+    fetching_.erase(it);
+    fetchDone(std::move(fetching), ts ? 1 + r.parents.size() : 0);
+    lock.unlock();
+
     if (ts) {
       io_->post([this, peer{r.from}, ts] { onTs(peer, ts); });
     }
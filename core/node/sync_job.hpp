@@ -5,10 +5,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <libp2p/basic/scheduler.hpp>
 #include <queue>
+#include <unordered_set>
 
 #include "common/io_thread.hpp"
+#include "common/prometheus/since.hpp"
 #include "node/blocksync_request.hpp"
 #include "primitives/tipset/chain.hpp"
 #include "storage/buffer_map.hpp"
@@ -53,6 +56,37 @@ namespace fc::sync {
     ChainEpoch metricAttachedHeight() const;
 
    private:
+    using Clock = std::chrono::steady_clock;
+
+    /** Header request waiting for a peer. */
+    struct Fetch {
+      /** Peer which announced tipset, preferred if idle. */
+      boost::optional<PeerId> peer;
+      TipsetKey tsk;
+      /** Peers below this height are not expected to have tipset. */
+      ChainEpoch height{};
+      size_t attempt{};
+      std::unordered_set<PeerId> failed;
+    };
+
+    /** Header request in flight. */
+    struct Fetching {
+      Fetch fetch;
+      PeerId peer;
+      uint64_t depth{};
+      Clock::time_point start;
+      Clock::time_point expiry;
+      std::shared_ptr<BlocksyncRequest> request;
+    };
+
+    /** Measured peer throughput, chooses peer and request depth. */
+    struct PeerStats {
+      uint64_t depth{};
+      /** Tipsets per second. */
+      double rate{};
+      bool busy{false};
+    };
+
     void onPossibleHead(const events::PossibleHead &e);
 
     TipsetCPtr getLocal(const TipsetKey &tsk);
@@ -71,11 +105,17 @@ namespace fc::sync {
 
     void interpretDequeue();
 
-    void fetch(const PeerId &peer, const TipsetKey &tsk);
+    void prefetch(const TipsetCPtr &ts);
+
+    void fetch(const PeerId &peer, const TipsetKey &tsk, ChainEpoch height);
 
     void fetchDequeue();
 
-    void downloaderCallback(BlocksyncRequest::Result r);
+    boost::optional<PeerId> fetchPeer(const Fetch &fetch, bool &wait);
+
+    void fetchDone(Fetching &&fetching, size_t tipsets);
+
+    void downloaderCallback(const TipsetKey &tsk, BlocksyncRequest::Result r);
 
     std::shared_ptr<libp2p::Host> host_;
     std::shared_ptr<boost::asio::io_context> io_;
@@ -95,9 +135,17 @@ namespace fc::sync {
     TipsetCPtr interpret_ts_;
     bool interpreting_{false};
     IoThread interpret_thread;
+    /** Since interpret_ts_ waits for its messages. */
+    boost::optional<Since> interpret_wait_;
+    /** Next tipset which state was warmed while current is interpreted. */
+    boost::optional<TipsetKey> warmed_;
+    std::atomic_bool warming_{false};
+    IoThread prefetch_thread;
 
     // TODO(turuslan): FIL-420 check cache memory usage
-    std::queue<std::pair<PeerId, TipsetKey>> requests_;
+    std::queue<Fetch> requests_;
+    std::unordered_map<TipsetKey, Fetching> fetching_;
+    std::unordered_map<PeerId, PeerStats> peer_stats_;
     std::mutex requests_mutex_;
 
     std::shared_ptr<events::Events> events_;
@@ -106,11 +154,6 @@ namespace fc::sync {
     events::Connection block_event_;
     events::Connection possible_head_event_;
 
-    std::shared_ptr<BlocksyncRequest> request_;
-
-    using Clock = std::chrono::steady_clock;
-    Clock::time_point request_expiry_;
-
     std::shared_ptr<PeerHeight> peers_;
     std::shared_ptr<FetchMsg> fetch_msg_;
   };
@@ -0,0 +1,112 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "proofs/seal_cache.hpp"
+
+#include "codec/cbor/cbor_codec.hpp"
+#include "common/logger.hpp"
+#include "crypto/blake2/blake2b160.hpp"
+
+namespace fc::proofs {
+  /// Key of current generation number
+  const Bytes kGenerationKey{'g'};
+  /// Size of result key, generation number and hash
+  constexpr size_t kKeySize{1 + 32};
+
+  SealCache::SealCache(MapPtr map, size_t max_size)
+      : map_{std::move(map)},
+        generation_size_{std::max<size_t>(1, max_size / 2)} {
+    if (auto generation{map_->get(kGenerationKey)};
+        generation && generation.value().size() == 1) {
+      generation_ = generation.value()[0] & 1;
+    }
+    // count current generation, remove keys of other formats
+    auto batch{map_->batch()};
+    auto cursor{map_->cursor()};
+    for (cursor->seekToFirst(); cursor->isValid(); cursor->next()) {
+      const auto _key{cursor->key()};
+      if (_key.size() == kKeySize && _key[0] <= 1) {
+        if (_key[0] == generation_) {
+          ++count_;
+        }
+      } else if (_key != kGenerationKey) {
+        std::ignore = batch->remove(_key);
+      }
+    }
+    if (auto r{batch->commit()}; !r) {
+      spdlog::warn("SealCache: {}", r.error().message());
+    }
+  }
+
+  boost::optional<bool> SealCache::get(const SealVerifyInfo &info) {
+    const auto _hash{hash(info)};
+    std::lock_guard lock{mutex_};
+    for (const auto generation :
+         {generation_, static_cast<uint8_t>(generation_ ^ 1)}) {
+      const auto _key{key(generation, _hash)};
+      if (!map_->contains(_key)) {
+        continue;
+      }
+      if (auto value{map_->get(_key)}; value && value.value().size() == 1) {
+        const auto valid{value.value()[0] != 0};
+        if (generation != generation_) {
+          putHash(_hash, valid);
+        }
+        return valid;
+      }
+    }
+    return boost::none;
+  }
+
+  void SealCache::put(const SealVerifyInfo &info, bool valid) {
+    const auto _hash{hash(info)};
+    std::lock_guard lock{mutex_};
+    putHash(_hash, valid);
+  }
+
+  Bytes SealCache::hash(const SealVerifyInfo &info) {
+    const auto hash{
+        crypto::blake2b::blake2b_256(codec::cbor::encode(info).value())};
+    return {hash.begin(), hash.end()};
+  }
+
+  Bytes SealCache::key(uint8_t generation, BytesIn hash) {
+    Bytes key{generation};
+    append(key, hash);
+    return key;
+  }
+
+  void SealCache::putHash(BytesIn hash, bool valid) {
+    if (count_ >= generation_size_) {
+      rotate();
+    }
+    if (auto r{map_->put(key(generation_, hash),
+                         Bytes{valid ? uint8_t{1} : uint8_t{0}})};
+        !r) {
+      spdlog::warn("SealCache.put: {}", r.error().message());
+      return;
+    }
+    ++count_;
+  }
+
+  void SealCache::rotate() {
+    const auto previous{static_cast<uint8_t>(generation_ ^ 1)};
+    auto batch{map_->batch()};
+    auto cursor{map_->cursor()};
+    for (cursor->seek(Bytes{previous}); cursor->isValid(); cursor->next()) {
+      const auto _key{cursor->key()};
+      if (_key.empty() || _key[0] != previous) {
+        break;
+      }
+      std::ignore = batch->remove(_key);
+    }
+    std::ignore = batch->put(kGenerationKey, Bytes{previous});
+    if (auto r{batch->commit()}; !r) {
+      spdlog::warn("SealCache.rotate: {}", r.error().message());
+    }
+    generation_ = previous;
+    count_ = 0;
+  }
+}  // namespace fc::proofs
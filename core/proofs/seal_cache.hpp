@@ -0,0 +1,48 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <mutex>
+
+#include "primitives/sector/sector.hpp"
+#include "storage/map_prefix/prefix.hpp"
+
+namespace fc::proofs {
+  using primitives::sector::SealVerifyInfo;
+  using storage::MapPtr;
+
+  /// Seal verification results kept by cache
+  constexpr size_t kSealCacheSize{1 << 18};
+
+  /**
+   * Persistent results of seal verification.
+   * Key is hash of seal verify info with proof, so tipset interpreted again
+   * after reorg or restart doesn't verify seals again.
+   * Results are put into current generation. When it holds half of max size,
+   * previous generation is removed and current becomes previous. Results
+   * found in previous generation are moved to current.
+   */
+  class SealCache {
+   public:
+    explicit SealCache(MapPtr map, size_t max_size = kSealCacheSize);
+
+    /** cached result of verification */
+    boost::optional<bool> get(const SealVerifyInfo &info);
+    void put(const SealVerifyInfo &info, bool valid);
+
+   private:
+    static Bytes hash(const SealVerifyInfo &info);
+    static Bytes key(uint8_t generation, BytesIn hash);
+    void putHash(BytesIn hash, bool valid);
+    void rotate();
+
+    MapPtr map_;
+    size_t generation_size_;
+    uint8_t generation_{};
+    size_t count_{};
+    std::mutex mutex_;
+  };
+}  // namespace fc::proofs
@@ -0,0 +1,110 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "proofs/seal_verifier.hpp"
+
+#include <atomic>
+
+namespace fc::proofs {
+  struct SealVerifier::Batch {
+    gsl::span<const SealVerifyInfo> infos;
+    /** indices of seals missing from cache */
+    std::vector<size_t> missing;
+    // not vector<bool>, elements are written by different threads
+    std::vector<uint8_t> valid;
+    std::atomic_size_t next{};
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t done{};
+  };
+
+  SealVerifier::SealVerifier(size_t threads,
+                             std::shared_ptr<ProofEngine> proofs,
+                             std::shared_ptr<SealCache> cache)
+      : proofs_{std::move(proofs)}, cache_{std::move(cache)} {
+    for (size_t i{0}; i < threads; ++i) {
+      threads_.emplace_back([this] { loop(); });
+    }
+  }
+
+  SealVerifier::~SealVerifier() {
+    {
+      std::lock_guard lock{queue_mutex_};
+      stop_ = true;
+    }
+    queue_cv_.notify_all();
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+  }
+
+  std::vector<bool> SealVerifier::verify(
+      gsl::span<const SealVerifyInfo> infos) {
+    auto batch{std::make_shared<Batch>()};
+    batch->infos = infos;
+    batch->valid.resize(infos.size());
+    for (size_t i{0}; i < infos.size(); ++i) {
+      if (cache_) {
+        if (const auto cached{cache_->get(infos[i])}) {
+          batch->valid[i] = *cached;
+          continue;
+        }
+      }
+      batch->missing.push_back(i);
+    }
+    const auto &missing{batch->missing};
+    if (!missing.empty()) {
+      const auto helpers{std::min(threads_.size(), missing.size() - 1)};
+      if (helpers != 0) {
+        {
+          std::lock_guard lock{queue_mutex_};
+          for (size_t i{0}; i < helpers; ++i) {
+            queue_.push_back(batch);
+          }
+        }
+        queue_cv_.notify_all();
+      }
+      work(*batch);
+      std::unique_lock lock{batch->mutex};
+      batch->cv.wait(lock, [&] { return batch->done == missing.size(); });
+    }
+    return {batch->valid.begin(), batch->valid.end()};
+  }
+
+  void SealVerifier::work(Batch &batch) {
+    const auto size{batch.missing.size()};
+    size_t j{};
+    while ((j = batch.next++) < size) {
+      const auto i{batch.missing[j]};
+      const auto &info{batch.infos[i]};
+      const auto r{proofs_->verifySeal(info)};
+      batch.valid[i] = r && r.value();
+      if (r && cache_) {
+        cache_->put(info, r.value());
+      }
+      std::lock_guard lock{batch.mutex};
+      ++batch.done;
+      if (batch.done == size) {
+        batch.cv.notify_all();
+      }
+    }
+  }
+
+  void SealVerifier::loop() {
+    while (true) {
+      std::shared_ptr<Batch> batch;
+      {
+        std::unique_lock lock{queue_mutex_};
+        queue_cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+        if (stop_) {
+          return;
+        }
+        batch = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      work(*batch);
+    }
+  }
+}  // namespace fc::proofs
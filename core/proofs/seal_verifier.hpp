@@ -0,0 +1,50 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "proofs/proof_engine.hpp"
+#include "proofs/seal_cache.hpp"
+
+namespace fc::proofs {
+  /**
+   * Verification of seals batched by cron, like lotus BatchVerifySeals.
+   * Seals missing from cache are verified by fixed worker threads shared by
+   * all tipsets, and calling thread.
+   */
+  class SealVerifier {
+   public:
+    SealVerifier(size_t threads,
+                 std::shared_ptr<ProofEngine> proofs,
+                 std::shared_ptr<SealCache> cache);
+    SealVerifier(const SealVerifier &) = delete;
+    SealVerifier(SealVerifier &&) = delete;
+    ~SealVerifier();
+    SealVerifier &operator=(const SealVerifier &) = delete;
+    SealVerifier &operator=(SealVerifier &&) = delete;
+
+    /** @return result for each seal, seals failed to verify are invalid */
+    std::vector<bool> verify(gsl::span<const SealVerifyInfo> infos);
+
+   private:
+    struct Batch;
+
+    void work(Batch &batch);
+    void loop();
+
+    std::shared_ptr<ProofEngine> proofs_;
+    std::shared_ptr<SealCache> cache_;
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<std::shared_ptr<Batch>> queue_;
+    bool stop_{false};
+    std::vector<std::thread> threads_;
+  };
+}  // namespace fc::proofs
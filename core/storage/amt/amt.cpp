@@ -115,6 +115,12 @@ namespace fc::storage::amt {
     return s << l;
   }
 
+  ipld::NodeCache<Node> &nodeCache() {
+    // estimated, 64k nodes
+    static ipld::NodeCache<Node> cache{size_t{1} << 16};
+    return cache;
+  }
+
   Amt::Amt(std::shared_ptr<ipfs::IpfsDatastore> store, size_t bits)
       : ipld_(std::move(store)), root_{}, bits_{bits} {
     assert(bits);
@@ -165,11 +171,14 @@ namespace fc::storage::amt {
       return AmtError::kNotFound;
     }
     std::reference_wrapper<Node> node = root.node;
+    // keeps loaded node alive, it is not stored in shared parent
+    Node::Ptr holder;
     for (auto height = root.height; height != 0; --height) {
       auto mask = maskAt(height);
-      OUTCOME_TRY(child, loadLink(node, key / mask, false, false));
+      OUTCOME_TRY(child, loadLink(node, key / mask, false));
       key %= mask;
-      node = *child;
+      holder = std::move(child);
+      node = *holder;
     }
     auto &values = boost::get<Node::Values>(node.get().items);
     auto it = values.find(key);
@@ -200,7 +209,7 @@ namespace fc::storage::amt {
       if (links.size() != 1 || links.find(0) == links.end()) {
         break;
       }
-      OUTCOME_TRY(child, loadLink(root.node, 0, false, false));
+      OUTCOME_TRY(child, loadLink(root.node, 0, false, true));
       auto node = std::move(*child);
       root.node = std::move(node);
       --root.height;
@@ -244,7 +253,7 @@ namespace fc::storage::amt {
       return false;
     }
     auto mask = maskAt(height);
-    OUTCOME_TRY(child, loadLink(node, key / mask, true, false));
+    OUTCOME_TRY(child, loadLink(node, key / mask, true, true));
     return set(*child, height - 1, key % mask, std::move(value));
   }
 
@@ -258,7 +267,7 @@ namespace fc::storage::amt {
     }
     auto mask = maskAt(height);
     auto index = key / mask;
-    OUTCOME_TRY(child, loadLink(node, index, false, false));
+    OUTCOME_TRY(child, loadLink(node, index, false, true));
     OUTCOME_TRY(remove(*child, height - 1, key % mask));
     // github.com/filecoin-project/go-amt-ipld/v2 behavior
     auto empty = visit_in_place(
@@ -287,9 +296,11 @@ namespace fc::storage::amt {
       auto &links = boost::get<Node::Links>(node.items);
       for (auto &pair : links) {
         if (which<Node::Ptr>(pair.second)) {
-          auto &child = *boost::get<Node::Ptr>(pair.second);
-          OUTCOME_TRY(flush(child));
-          OUTCOME_TRY(cid, fc::setCbor(ipld_, child));
+          auto child{boost::get<Node::Ptr>(pair.second)};
+          OUTCOME_TRY(flush(*child));
+          OUTCOME_TRY(cid, fc::setCbor(ipld_, *child));
+          // written node is likely to be loaded by next tipset
+          nodeCache().insert(cid, child);
           pair.second = cid;
         }
       }
@@ -319,7 +330,7 @@ namespace fc::storage::amt {
     }
     auto mask = maskAt(height);
     for (auto &it : boost::get<Node::Links>(node.items)) {
-      OUTCOME_TRY(child, loadLink(node, it.first, false, true));
+      OUTCOME_TRY(child, loadLink(node, it.first, false));
       OUTCOME_TRY(visit(*child, height - 1, offset + it.first * mask, visitor));
     }
     return outcome::success();
@@ -343,9 +354,13 @@ namespace fc::storage::amt {
   outcome::result<Node::Ptr> Amt::loadLink(Node &parent,
                                            uint64_t index,
                                            bool create,
-                                           bool visiting) const {
+                                           bool write) const {
     if (which<Node::Values>(parent.items)
         && boost::get<Node::Values>(parent.items).empty()) {
+      if (!create) {
+        // parent may be shared
+        return AmtError::kNotFound;
+      }
       parent.items = Node::Links{};
     }
     auto &links = boost::get<Node::Links>(parent.items);
@@ -361,16 +376,21 @@ namespace fc::storage::amt {
     }
     auto &link = it->second;
     if (which<CID>(link)) {
-      OUTCOME_TRY(node, fc::getCbor<Node>(ipld_, boost::get<CID>(link)));
-      if (node.bits_bytes != bitsBytes()) {
+      OUTCOME_TRY(node, nodeCache().load(ipld_, boost::get<CID>(link)));
+      if (node->bits_bytes != bitsBytes()) {
         return AmtError::kRootBitsWrong;
       }
-      if (visiting) {
-        return std::make_shared<Node>(std::move(node));
+      if (!write) {
+        // parent may be shared by node cache, loaded node is not stored
+        return node;
       }
-      link = std::make_shared<Node>(std::move(node));
+      link = node;
+    }
+    auto &node{boost::get<Node::Ptr>(link)};
+    if (write) {
+      ipld::unshare(node);
     }
-    return boost::get<Node::Ptr>(link);
+    return node;
   }
 
   uint64_t Amt::bits() const {
@@ -13,6 +13,7 @@
 #include "common/which.hpp"
 #include "primitives/cid/cid.hpp"
 #include "storage/ipfs/datastore.hpp"
+#include "storage/ipld/node_cache.hpp"
 
 namespace fc::storage::amt {
   enum class AmtError {
@@ -44,9 +45,14 @@ namespace fc::storage::amt {
 
     Items items;
     size_t bits_bytes{};
+    /** shared by node cache, copied before modification */
+    bool cached{};
   };
   CBOR2_DECODE_ENCODE(Node)
 
+  /** decoded nodes shared by all amts */
+  ipld::NodeCache<Node> &nodeCache();
+
   using OptBitWidth = boost::optional<uint64_t>;
   struct Root {
     OptBitWidth bits;
@@ -117,10 +123,16 @@ namespace fc::storage::amt {
                                 uint64_t height,
                                 uint64_t offset,
                                 const Visitor &visitor) const;
+    /**
+     * Loads child node.
+     * @param create creates missing child
+     * @param write keeps loaded child in parent and returns child not shared
+     * with other trees, otherwise parent is not modified
+     */
     outcome::result<Node::Ptr> loadLink(Node &node,
                                         uint64_t index,
                                         bool create,
-                                        bool visiting) const;
+                                        bool write = false) const;
     uint64_t bits() const;
     uint64_t bitsBytes() const;
     uint64_t maskAt(uint64_t height) const;
@@ -70,10 +70,17 @@ namespace fc::storage::car {
   }
 
   outcome::result<std::vector<CID>> loadCar(Ipld &store, Input input) {
+    // values are views into input, so batch doesn't copy them
+    constexpr size_t kBatch{1024};
     OUTCOME_TRY(reader, CarReader::make(input));
+    std::vector<std::pair<CID, BytesCow>> items;
     while (!reader.end()) {
       OUTCOME_TRY(item, reader.next());
-      OUTCOME_TRY(store.set(item.first, item.second));
+      items.emplace_back(std::move(item.first), item.second);
+      if (items.size() >= kBatch || reader.end()) {
+        OUTCOME_TRY(store.setMany(std::move(items)));
+        items.clear();
+      }
     }
     return std::move(reader.roots);
   }
@@ -0,0 +1,168 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "storage/car/cids_index/bloom.hpp"
+
+#include <boost/endian/conversion.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "common/error_text.hpp"
+
+namespace fc::storage::cids_index {
+  struct BloomHeader {
+    boost::endian::little_uint64_buf_t capacity;
+    boost::endian::little_uint64_buf_t count;
+    /** index info when filter was saved */
+    boost::endian::little_uint64_buf_t index_count;
+    Row index_max_offset;
+  };
+
+  /** block index and bit positions within block */
+  struct BloomBits {
+    size_t block{};
+    std::array<uint16_t, 8> bits{};
+
+    BloomBits(const CbCid &key, size_t blocks) {
+      const auto h1{boost::endian::load_little_u64(key.data())};
+      const auto h2{boost::endian::load_little_u64(key.data() + 8)};
+      const auto h3{boost::endian::load_little_u64(key.data() + 16)};
+      block = static_cast<size_t>(
+          (static_cast<unsigned __int128>(h1) * blocks) >> 64);
+      // 9 bits address 512 bits of block
+      for (size_t i{0}; i < 7; ++i) {
+        bits[i] = (h2 >> (9 * i)) & 511;
+      }
+      bits[7] = h3 & 511;
+    }
+  };
+
+  Bloom::Bloom(size_t capacity)
+      : capacity{std::max<size_t>(capacity, 1)},
+        blocks{ceilDiv(this->capacity * kBitsPerKey, kBlockWords * 64)},
+        words{new std::atomic_uint64_t[blocks * kBlockWords]{}} {}
+
+  void Bloom::insert(const CbCid &key) {
+    const BloomBits bloom_bits{key, blocks};
+    auto block{&words[bloom_bits.block * kBlockWords]};
+    for (const auto bit : bloom_bits.bits) {
+      block[bit / 64].fetch_or(uint64_t{1} << (bit % 64),
+                               std::memory_order_relaxed);
+    }
+    ++count;
+  }
+
+  bool Bloom::has(const CbCid &key) const {
+    const BloomBits bloom_bits{key, blocks};
+    const auto block{&words[bloom_bits.block * kBlockWords]};
+    for (const auto bit : bloom_bits.bits) {
+      if ((block[bit / 64].load(std::memory_order_relaxed)
+           & (uint64_t{1} << (bit % 64)))
+          == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  size_t Bloom::bytes() const {
+    return blocks * kBlockWords * sizeof(uint64_t);
+  }
+
+  std::shared_ptr<Bloom> Bloom::load(const std::string &bloom_path,
+                                     const Index &index) {
+    std::ifstream file{bloom_path, std::ios::binary};
+    BloomHeader header;
+    if (file.good() && common::readStruct(file, header)
+        && header.index_count.value() == index.size()
+        && header.index_max_offset == index.info.max_offset
+        && header.capacity.value() >= index.size()) {
+      auto bloom{std::make_shared<Bloom>(header.capacity.value())};
+      std::vector<uint64_t> words(bloom->blocks * kBlockWords);
+      if (common::read(file, gsl::make_span(words))) {
+        for (size_t i{0}; i < words.size(); ++i) {
+          bloom->words[i] = boost::endian::little_to_native(words[i]);
+        }
+        bloom->count = header.count.value();
+        return bloom;
+      }
+    }
+    return nullptr;
+  }
+
+  outcome::result<std::shared_ptr<Bloom>> Bloom::loadOrCreate(
+      const std::string &bloom_path,
+      const std::string &index_path,
+      const Index &index) {
+    if (auto bloom{load(bloom_path, index)}) {
+      return bloom;
+    }
+    OUTCOME_TRY(bloom, build(index_path, index.size()));
+    OUTCOME_TRY(bloom->save(bloom_path, index));
+    return bloom;
+  }
+
+  outcome::result<std::shared_ptr<Bloom>> Bloom::build(
+      const std::string &index_path, size_t count) {
+    // reserve for keys written until next build
+    auto bloom{std::make_shared<Bloom>(count * 2)};
+    OUTCOME_TRY(bloom->insertIndex(index_path));
+    return bloom;
+  }
+
+  outcome::result<void> Bloom::insertIndex(const std::string &index_path) {
+    std::ifstream file{index_path, std::ios::binary};
+    OUTCOME_TRY(count, checkIndex(file));
+    return insertRows(file, 1, 1 + count);
+  }
+
+  outcome::result<void> Bloom::insertRows(std::istream &file,
+                                          size_t begin,
+                                          size_t end) {
+    file.seekg(begin * sizeof(Row));
+    // estimated, 64kb
+    std::vector<Row> rows(1638);
+    for (auto i{begin}; i < end;) {
+      rows.resize(std::min(rows.size(), end - i));
+      if (!common::read(file, gsl::make_span(rows))) {
+        return ERROR_TEXT("Bloom.insertRows: read error");
+      }
+      for (const auto &row : rows) {
+        insert(row.key);
+      }
+      i += rows.size();
+    }
+    return outcome::success();
+  }
+
+  outcome::result<void> Bloom::save(const std::string &bloom_path,
+                                    const Index &index) const {
+    auto write_error{ERROR_TEXT("Bloom.save: write error")};
+    BloomHeader header;
+    header.capacity = capacity;
+    header.count = count;
+    header.index_count = index.size();
+    header.index_max_offset = index.info.max_offset;
+    std::vector<uint64_t> _words(blocks * kBlockWords);
+    for (size_t i{0}; i < _words.size(); ++i) {
+      _words[i] = boost::endian::native_to_little(
+          words[i].load(std::memory_order_relaxed));
+    }
+    const auto tmp_path{bloom_path + ".tmp"};
+    {
+      std::ofstream file{tmp_path, std::ios::binary | std::ios::trunc};
+      if (!common::writeStruct(file, header)
+          || !common::write(file, gsl::make_span(_words))
+          || !file.flush()) {
+        return write_error;
+      }
+    }
+    boost::system::error_code ec;
+    boost::filesystem::rename(tmp_path, bloom_path, ec);
+    if (ec) {
+      return ec;
+    }
+    return outcome::success();
+  }
+}  // namespace fc::storage::cids_index
@@ -0,0 +1,62 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+
+#include "storage/car/cids_index/cids_index.hpp"
+
+namespace fc::storage::cids_index {
+  /**
+   * Blocked bloom filter of index keys.
+   * Answers "definitely absent" without index lookup.
+   * Each key sets bits in one 64-byte block, so lookup touches one cache
+   * line. Keys are hashes, so bits are taken from key directly.
+   * Insert and lookup are lock-free.
+   */
+  struct Bloom {
+    /** 64 bytes */
+    static constexpr size_t kBlockWords{8};
+    /** estimated, ~1% false positives for 8 bits per block */
+    static constexpr size_t kBitsPerKey{10};
+
+    /** max keys before false positive rate grows */
+    size_t capacity{};
+    size_t blocks{};
+    std::unique_ptr<std::atomic_uint64_t[]> words;
+    std::atomic_size_t count{};
+
+    explicit Bloom(size_t capacity);
+
+    void insert(const CbCid &key);
+    bool has(const CbCid &key) const;
+    size_t bytes() const;
+
+    /** Loads filter saved for index with same info, or returns null */
+    static std::shared_ptr<Bloom> load(const std::string &bloom_path,
+                                       const Index &index);
+    /**
+     * Loads filter saved for index with same info, or builds it from index
+     * file.
+     */
+    static outcome::result<std::shared_ptr<Bloom>> loadOrCreate(
+        const std::string &bloom_path,
+        const std::string &index_path,
+        const Index &index);
+    /** Builds filter from index file */
+    static outcome::result<std::shared_ptr<Bloom>> build(
+        const std::string &index_path, size_t count);
+    /** Inserts keys of index file */
+    outcome::result<void> insertIndex(const std::string &index_path);
+    /** Inserts keys of rows [begin, end) of file */
+    outcome::result<void> insertRows(std::istream &file,
+                                     size_t begin,
+                                     size_t end);
+    /** Saves filter with index info */
+    outcome::result<void> save(const std::string &bloom_path,
+                               const Index &index) const;
+  };
+}  // namespace fc::storage::cids_index
@@ -5,6 +5,15 @@
 
 #include "storage/car/cids_index/cids_index.hpp"
 
+#include <sys/mman.h>
+#include <unistd.h>
+#include <boost/endian/conversion.hpp>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+#include "codec/cbor/light_reader/cid.hpp"
 #include "codec/uvarint.hpp"
 #include "common/error_text.hpp"
 #include "common/file.hpp"
@@ -66,6 +75,39 @@ namespace fc::storage::cids_index {
     return {false, 0};
   }
 
+  bool readCarItem(int car_fd, const Row &row, Bytes &value) {
+    // row.max_size64 limits item size, item may be shorter and end at eof
+    value.resize(maxSize(row.max_size64.value()));
+    size_t size{};
+    while (size < value.size()) {
+      const auto n{pread(car_fd,
+                         value.data() + size,
+                         value.size() - size,
+                         gsl::narrow<off_t>(row.offset.value() + size))};
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      if (n == 0) {
+        break;
+      }
+      size += n;
+    }
+    BytesIn input{value.data(), gsl::narrow<ptrdiff_t>(size)};
+    BytesIn item;
+    const CbCid *key{};
+    if (!codec::uvarint::readBytes(item, input)
+        || !codec::cbor::light_reader::readCborBlake(key, item)
+        || *key != row.key) {
+      return false;
+    }
+    std::copy(item.begin(), item.end(), value.begin());
+    value.resize(item.size());
+    return true;
+  }
+
   RowsInfo &RowsInfo::feed(const Row &row) {
     valid = valid && !row.isMeta();
     if (valid) {
@@ -103,8 +145,13 @@ namespace fc::storage::cids_index {
     ++current;
   }
 
-  outcome::result<void> merge(std::ostream &out,
-                              std::vector<MergeRange> &&ranges) {
+  /**
+   * Merges ranges without header and trailer, skips duplicate rows.
+   * @return number of rows written
+   */
+  inline outcome::result<size_t> mergeRows(std::ostream &out,
+                                           std::vector<MergeRange> &&ranges,
+                                           const MergeFilter &keep = {}) {
     auto read_error{ERROR_TEXT("merge: read error")};
     auto write_error{ERROR_TEXT("merge: write error")};
     std::greater<MergeRange> cmp;
@@ -124,14 +171,20 @@ namespace fc::storage::cids_index {
       }
     }
     std::make_heap(ranges.begin(), ranges.end(), cmp);
-    if (!common::writeStruct(out, kHeaderV0)) {
-      return write_error;
-    }
+    boost::optional<Row> last;
+    size_t count{};
     while (!ranges.empty()) {
       std::pop_heap(ranges.begin(), ranges.end(), cmp);
       auto &range{ranges.back()};
-      if (!common::writeStruct(out, range.front())) {
-        return write_error;
+      // same row may be in several ranges after interrupted compaction
+      if (last != range.front()) {
+        last = range.front();
+        if (!keep || keep(*last)) {
+          if (!common::writeStruct(out, *last)) {
+            return write_error;
+          }
+          ++count;
+        }
       }
       range.pop();
       if (range.empty()) {
@@ -143,6 +196,17 @@ namespace fc::storage::cids_index {
         std::push_heap(ranges.begin(), ranges.end(), cmp);
       }
     }
+    return count;
+  }
+
+  outcome::result<void> merge(std::ostream &out,
+                              std::vector<MergeRange> &&ranges,
+                              const MergeFilter &keep) {
+    auto write_error{ERROR_TEXT("merge: write error")};
+    if (!common::writeStruct(out, kHeaderV0)) {
+      return write_error;
+    }
+    OUTCOME_TRY(mergeRows(out, std::move(ranges), keep));
     if (!common::writeStruct(out, kTrailerV0)) {
       return write_error;
     }
@@ -150,6 +214,146 @@ namespace fc::storage::cids_index {
     return outcome::success();
   }
 
+  /** returns index of first row in [begin, end) with key not less than key */
+  inline outcome::result<size_t> lowerBound(std::istream &file,
+                                            size_t begin,
+                                            size_t end,
+                                            const CbCid &key) {
+    while (begin < end) {
+      const auto mid{begin + (end - begin) / 2};
+      file.seekg(mid * sizeof(Row));
+      Row row;
+      if (!common::readStruct(file, row)) {
+        return ERROR_TEXT("mergeParallel: read error");
+      }
+      if (row < key) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    return begin;
+  }
+
+  outcome::result<void> mergeParallel(const std::string &out_path,
+                                      std::vector<MergeRange> &&ranges,
+                                      size_t threads) {
+    auto write_error{ERROR_TEXT("mergeParallel: write error")};
+    threads = std::max<size_t>(threads, 1);
+    // splits[range][part] is first row of part in range
+    std::vector<std::vector<size_t>> splits;
+    for (auto &range : ranges) {
+      assert(range.file);
+      assert(!range.path.empty());
+      assert(range.rows.empty());
+      auto &split{splits.emplace_back()};
+      split.push_back(range.begin);
+      for (size_t part{1}; part < threads; ++part) {
+        // keys are uniformly distributed hashes
+        CbCid key;
+        boost::endian::store_big_u64(
+            key.data(), std::numeric_limits<uint64_t>::max() / threads * part);
+        OUTCOME_TRY(row, lowerBound(*range.file, split.back(), range.end, key));
+        split.push_back(row);
+      }
+      split.push_back(range.end);
+    }
+    std::vector<size_t> offsets{1};
+    for (size_t part{0}; part < threads; ++part) {
+      auto offset{offsets.back()};
+      for (auto &split : splits) {
+        offset += split[part + 1] - split[part];
+      }
+      offsets.push_back(offset);
+    }
+    {
+      std::ofstream out{out_path, std::ios::binary | std::ios::trunc};
+      if (!common::writeStruct(out, kHeaderV0)) {
+        return write_error;
+      }
+      out.seekp(offsets.back() * sizeof(Row));
+      if (!common::writeStruct(out, kTrailerV0)) {
+        return write_error;
+      }
+    }
+    std::vector<outcome::result<size_t>> results(threads, 0);
+    std::vector<std::thread> workers;
+    for (size_t part{0}; part < threads; ++part) {
+      workers.emplace_back([&, part] {
+        std::vector<std::ifstream> files(ranges.size());
+        std::vector<MergeRange> part_ranges;
+        for (size_t i{0}; i < ranges.size(); ++i) {
+          auto &range{part_ranges.emplace_back()};
+          files[i].open(ranges[i].path, std::ios::binary);
+          range.file = &files[i];
+          range.begin = splits[i][part];
+          range.end = splits[i][part + 1];
+        }
+        std::fstream out{out_path,
+                         std::ios::in | std::ios::out | std::ios::binary};
+        out.seekp(offsets[part] * sizeof(Row));
+        results[part] = mergeRows(out, std::move(part_ranges));
+        if (results[part] && !out.flush()) {
+          results[part] = write_error;
+        }
+      });
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    auto duplicates{false};
+    for (size_t part{0}; part < threads; ++part) {
+      OUTCOME_TRY(count, results[part]);
+      // offsets are counted with duplicates
+      if (count != offsets[part + 1] - offsets[part]) {
+        duplicates = true;
+      }
+    }
+    if (duplicates) {
+      // same rows in several ranges after interrupted compaction, rare
+      std::ofstream out{out_path, std::ios::binary | std::ios::trunc};
+      OUTCOME_TRY(merge(out, std::move(ranges)));
+      if (!out) {
+        return write_error;
+      }
+    }
+    return outcome::success();
+  }
+
+  /**
+   * Adds row for cbor blake item, or puts other item to ipld.
+   * @return true if row was added
+   */
+  inline outcome::result<bool> indexItem(std::vector<Row> &rows,
+                                         uint64_t offset,
+                                         size_t size,
+                                         BytesIn input,
+                                         const IpldPtr &ipld,
+                                         std::mutex *ipld_mutex = nullptr) {
+    if (startsWith(input, kCborBlakePrefix)) {
+      input = input.subspan(kCborBlakePrefix.size());
+      OUTCOME_TRY(key, fromSpan<CbCid>(input, false));
+      auto &row{rows.emplace_back()};
+      row.key = key;
+      row.offset = offset;
+      row.max_size64 = maxSize64(size);
+      return true;
+    }
+    if (!startsWith(input, kMainnetGenesisBlockParent)) {
+      OUTCOME_TRY(cid, CID::read(input));
+      if (ipld) {
+        if (!asIdentity(cid)) {
+          std::unique_lock<std::mutex> lock;
+          if (ipld_mutex) {
+            lock = std::unique_lock{*ipld_mutex};
+          }
+          OUTCOME_TRY(ipld->set(cid, input));
+        }
+      }
+    }
+    return false;
+  }
+
   outcome::result<size_t> readCar(std::istream &car_file,
                                   uint64_t car_min,
                                   uint64_t car_max,
@@ -194,25 +398,10 @@ namespace fc::storage::cids_index {
       if (!varint) {
         break;
       }
-      BytesIn input{item};
       auto size{varint + item.size()};
-      if (startsWith(item, kCborBlakePrefix)) {
-        input = input.subspan(kCborBlakePrefix.size());
-        OUTCOME_TRY(key, fromSpan<CbCid>(input, false));
-        auto &row{rows.emplace_back()};
-        row.key = key;
-        row.offset = offset;
-        row.max_size64 = maxSize64(size);
+      OUTCOME_TRY(added, indexItem(rows, offset, size, item, ipld));
+      if (added) {
         ++total;
-      } else {
-        if (!startsWith(input, kMainnetGenesisBlockParent)) {
-          OUTCOME_TRY(cid, CID::read(input));
-          if (ipld) {
-            if (!asIdentity(cid)) {
-              OUTCOME_TRY(ipld->set(cid, input));
-            }
-          }
-        }
       }
       offset += size;
       if (max_memory && rows.size() == rows.capacity() && !flush()) {
@@ -234,6 +423,211 @@ namespace fc::storage::cids_index {
     return total;
   }
 
+  outcome::result<size_t> readCarParallel(const std::string &car_path,
+                                          uint64_t car_min,
+                                          uint64_t car_max,
+                                          boost::optional<size_t> max_memory,
+                                          IpldPtr ipld,
+                                          Progress *progress,
+                                          std::fstream &rows_file,
+                                          const std::string &rows_path,
+                                          std::vector<MergeRange> &ranges,
+                                          size_t threads) {
+    assert(car_min <= car_max);
+    auto read_error{ERROR_TEXT("readCarParallel: read error")};
+    auto write_error{ERROR_TEXT("readCarParallel: write error")};
+    threads = std::max<size_t>(threads, 1);
+    // estimated, 16mb
+    constexpr size_t kChunk{16 << 20};
+    // max item size, same as readBytes
+    constexpr uint64_t kMaxItem{1 << 30};
+    // rows kept by each thread before writing sorted range
+    auto max_rows{std::numeric_limits<size_t>::max()};
+    if (max_memory) {
+      // estimated, 16mb, 512mb
+      max_rows = std::clamp<size_t>(*max_memory, 16 << 20, 512 << 20)
+                 / sizeof(Row) / threads;
+    }
+    if (!common::writeStruct(rows_file, kHeaderV0)) {
+      return write_error;
+    }
+    const auto ranges_before{ranges.size()};
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    // offset and frames of chunk
+    std::deque<std::pair<uint64_t, Bytes>> chunks;
+    bool done{false};
+    std::error_code error;
+    std::atomic_size_t items{};
+    std::mutex ipld_mutex;
+    std::mutex rows_mutex;
+    size_t total{};
+    auto fail{[&](const std::error_code &_error) {
+      std::unique_lock lock{mutex};
+      if (!error) {
+        error = _error;
+      }
+      cv.notify_all();
+    }};
+    auto flush{[&](std::vector<Row> &rows) -> outcome::result<void> {
+      std::sort(rows.begin(), rows.end());
+      std::unique_lock lock{rows_mutex};
+      auto &range{ranges.emplace_back()};
+      range.begin = 1 + total;
+      range.end = range.begin + rows.size();
+      range.file = &rows_file;
+      range.path = rows_path;
+      total += rows.size();
+      if (!common::write(rows_file, gsl::make_span(rows))) {
+        return write_error;
+      }
+      rows.resize(0);
+      return outcome::success();
+    }};
+    auto work{[&]() -> outcome::result<void> {
+      std::vector<Row> rows;
+      while (true) {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&] { return !chunks.empty() || done || error; });
+        if (error) {
+          return outcome::success();
+        }
+        if (chunks.empty()) {
+          break;
+        }
+        auto [offset, chunk]{std::move(chunks.front())};
+        chunks.pop_front();
+        lock.unlock();
+        cv.notify_all();
+        BytesIn input{chunk};
+        while (!input.empty()) {
+          const auto before{input.size()};
+          BytesIn item;
+          if (!codec::uvarint::readBytes(item, input)) {
+            return read_error;
+          }
+          const auto size{gsl::narrow<size_t>(before - input.size())};
+          OUTCOME_TRY(indexItem(rows, offset, size, item, ipld, &ipld_mutex));
+          offset += size;
+          ++items;
+        }
+        if (rows.size() >= max_rows) {
+          OUTCOME_TRY(flush(rows));
+        }
+      }
+      if (!rows.empty()) {
+        OUTCOME_TRY(flush(rows));
+      }
+      return outcome::success();
+    }};
+    std::vector<std::thread> workers;
+    for (size_t i{0}; i < threads; ++i) {
+      workers.emplace_back([&] {
+        if (auto r{work()}; !r) {
+          fail(r.error());
+        }
+      });
+    }
+    auto read{[&]() -> outcome::result<void> {
+      std::ifstream car_file{car_path, std::ios::binary};
+      car_file.seekg(gsl::narrow<int64_t>(car_min));
+      uint64_t offset{car_min};
+      uint64_t read_offset{car_min};
+      Bytes buffer;
+      while (read_offset < car_max) {
+        const auto size{std::min<uint64_t>(kChunk, car_max - read_offset)};
+        const auto buffer_size{buffer.size()};
+        buffer.resize(buffer_size + size);
+        if (!common::read(car_file,
+                          gsl::make_span(buffer).subspan(buffer_size))) {
+          return read_error;
+        }
+        read_offset += size;
+        // find complete frames, stop on invalid frame like readCar
+        BytesIn input{buffer};
+        auto invalid{false};
+        while (!input.empty()) {
+          codec::uvarint::VarintDecoder varint;
+          for (const auto byte : input) {
+            varint.update(byte);
+            if (varint.overflow || !varint.more) {
+              break;
+            }
+          }
+          if (varint.overflow || varint.value > kMaxItem) {
+            invalid = true;
+            break;
+          }
+          if (varint.more
+              || varint.length + varint.value
+                     > gsl::narrow<uint64_t>(input.size())) {
+            break;
+          }
+          input = input.subspan(
+              gsl::narrow<ptrdiff_t>(varint.length + varint.value));
+        }
+        const auto framed{buffer.size() - input.size()};
+        if (framed != 0) {
+          Bytes rest(buffer.begin() + framed, buffer.end());
+          buffer.resize(framed);
+          std::unique_lock lock{mutex};
+          // limit memory used by chunks
+          cv.wait(lock, [&] { return chunks.size() < threads * 2 || error; });
+          if (error) {
+            return outcome::success();
+          }
+          chunks.emplace_back(offset, std::move(buffer));
+          lock.unlock();
+          cv.notify_all();
+          offset += framed;
+          buffer = std::move(rest);
+        }
+        if (progress) {
+          progress->car_offset.value = offset - car_min;
+          progress->items.value = items;
+          progress->update();
+        }
+        if (invalid) {
+          break;
+        }
+      }
+      return outcome::success();
+    }};
+    auto read_result{read()};
+    {
+      std::unique_lock lock{mutex};
+      done = true;
+    }
+    cv.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    OUTCOME_TRY(read_result);
+    if (error) {
+      return error;
+    }
+    if (progress) {
+      progress->items.value = items;
+      progress->update(true);
+    }
+    if (ranges.size() == ranges_before) {
+      // like readCar, there is always new range
+      auto &range{ranges.emplace_back()};
+      range.begin = range.end = 1;
+      range.file = &rows_file;
+      range.path = rows_path;
+    }
+    if (!common::writeStruct(rows_file, kTrailerV0)) {
+      return write_error;
+    }
+    rows_file.flush();
+    return total;
+  }
+
+  /// Keys of sparse index used when run can't be mapped
+  constexpr size_t kMappedSparseKeys{1 << 16};
+
   inline boost::optional<size_t> sparseSize(
       size_t count, boost::optional<size_t> max_memory) {
     if (max_memory && count * sizeof(Row) > *max_memory) {
@@ -356,6 +750,102 @@ namespace fc::storage::cids_index {
     return index;
   }
 
+  /** first 8 bytes of key as number, preserves order */
+  inline uint64_t keyPrefix(const CbCid &key) {
+    return boost::endian::load_big_u64(key.data());
+  }
+
+  outcome::result<boost::optional<size_t>> MmapIndex::position(
+      const CbCid &key) const {
+    // estimated, rows fitting in few cache lines
+    constexpr ptrdiff_t kLinear{8};
+    ptrdiff_t begin{0};
+    ptrdiff_t end{rows.size()};
+    const auto prefix{keyPrefix(key)};
+    for (auto interpolate{true}; end - begin > kLinear;
+         interpolate = !interpolate) {
+      auto mid{begin + (end - begin) / 2};
+      if (interpolate) {
+        const auto min{keyPrefix(rows[begin].key)};
+        const auto max{keyPrefix(rows[end - 1].key)};
+        if (prefix < min || prefix > max) {
+          return boost::none;
+        }
+        if (min != max) {
+          mid = begin
+                + gsl::narrow<ptrdiff_t>(
+                    static_cast<unsigned __int128>(prefix - min)
+                    * (end - 1 - begin) / (max - min));
+        }
+      }
+      const auto &row{rows[mid]};
+      const auto cmp{memcmp(&row.key, &key, sizeof(CbCid))};
+      if (cmp == 0) {
+        if (row.isMeta()) {
+          return ERROR_TEXT("MmapIndex.find: inconsistent");
+        }
+        return gsl::narrow<size_t>(mid);
+      }
+      if (cmp < 0) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    for (auto i{begin}; i < end; ++i) {
+      const auto &row{rows[i]};
+      if (row.key == key) {
+        if (row.isMeta()) {
+          return ERROR_TEXT("MmapIndex.find: inconsistent");
+        }
+        return gsl::narrow<size_t>(i);
+      }
+    }
+    return boost::none;
+  }
+
+  outcome::result<boost::optional<Row>> MmapIndex::find(
+      const CbCid &key) const {
+    OUTCOME_TRY(i, position(key));
+    if (i) {
+      return rows[gsl::narrow<ptrdiff_t>(*i)];
+    }
+    return boost::none;
+  }
+
+  size_t MmapIndex::size() const {
+    return rows.size();
+  }
+
+  outcome::result<std::shared_ptr<MmapIndex>> MmapIndex::load(
+      const std::string &index_path, size_t count) {
+    auto index{std::make_shared<MmapIndex>()};
+    try {
+      index->file.open(index_path);
+    } catch (const std::ios::failure &) {
+      return ERROR_TEXT("MmapIndex::load: map failed");
+    }
+    if (!index->file.is_open()
+        || index->file.size() != (count + 2) * sizeof(Row)) {
+      return ERROR_TEXT("MmapIndex::load: map failed");
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    index->rows = gsl::make_span(
+        reinterpret_cast<const Row *>(index->file.data()) + 1,
+        gsl::narrow<ptrdiff_t>(count));
+    for (const auto &row : index->rows) {
+      if (!index->info.feed(row).valid) {
+        return ERROR_TEXT("MmapIndex::load: invalid index");
+      }
+    }
+    // lookups are random, readahead is useless
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    madvise(const_cast<char *>(index->file.data()),
+            index->file.size(),
+            MADV_RANDOM);
+    return index;
+  }
+
   outcome::result<std::shared_ptr<Index>> load(
       const std::string &index_path, boost::optional<size_t> max_memory) {
     std::ifstream index_file{index_path, std::ios::binary};
@@ -363,6 +853,10 @@ namespace fc::storage::cids_index {
     index_file.rdbuf()->pubsetbuf(nullptr, 64 << 10);
     OUTCOME_TRY(count, checkIndex(index_file));
     if (auto sparse{sparseSize(count, max_memory)}) {
+      if (auto index{MmapIndex::load(index_path, count)}) {
+        return std::move(index.value());
+      }
+      // fallback, address space may be not enough to map index
       OUTCOME_TRY(index,
                   SparseIndex::load(std::move(index_file), count, *sparse));
       return std::move(index);
@@ -370,4 +864,18 @@ namespace fc::storage::cids_index {
     OUTCOME_TRY(index, MemoryIndex::load(index_file, count));
     return std::move(index);
   }
+
+  outcome::result<std::shared_ptr<Index>> loadMapped(
+      const std::string &index_path) {
+    std::ifstream index_file{index_path, std::ios::binary};
+    index_file.rdbuf()->pubsetbuf(nullptr, 64 << 10);
+    OUTCOME_TRY(count, checkIndex(index_file));
+    if (auto index{MmapIndex::load(index_path, count)}) {
+      return std::move(index.value());
+    }
+    OUTCOME_TRY(
+        index,
+        SparseIndex::load(std::move(index_file), count, kMappedSparseKeys));
+    return std::move(index);
+  }
 }  // namespace fc::storage::cids_index
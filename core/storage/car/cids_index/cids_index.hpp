@@ -7,10 +7,12 @@
 
 #include <boost/endian/buffers.hpp>
 #include <fstream>
+#include <functional>
 #include <mutex>
 
 #include "cbor_blake/cid.hpp"
 #include "common/enum.hpp"
+#include "common/file.hpp"
 #include "storage/ipfs/datastore.hpp"
 
 namespace boost {
@@ -76,6 +78,13 @@ namespace fc::storage::cids_index {
                                       const Row &row,
                                       uint64_t *end);
 
+  /**
+   * Reads car item value with single positional read.
+   * Doesn't change file position, so may be called concurrently.
+   * @return false if item doesn't match row
+   */
+  bool readCarItem(int car_fd, const Row &row, Bytes &value);
+
   struct RowsInfo {
     bool valid{true};
     bool sorted{true};
@@ -88,6 +97,8 @@ namespace fc::storage::cids_index {
 
   struct MergeRange {
     std::istream *file{};
+    /** file path, parallel merge opens own file for each thread */
+    std::string path;
     std::vector<Row> rows;
     size_t current = -1;
     size_t begin{};
@@ -106,8 +117,22 @@ namespace fc::storage::cids_index {
     return r.front() < l.front();
   }
 
+  /** returns false for rows to drop */
+  using MergeFilter = std::function<bool(const Row &)>;
+
   outcome::result<void> merge(std::ostream &out,
-                              std::vector<MergeRange> &&ranges);
+                              std::vector<MergeRange> &&ranges,
+                              const MergeFilter &keep = {});
+
+  /**
+   * Merges file ranges using threads.
+   * Key space is split into parts, each part is merged by own thread and
+   * written at own offset, so output is same as merge.
+   * Falls back to merge if ranges contain duplicate rows.
+   */
+  outcome::result<void> mergeParallel(const std::string &out_path,
+                                      std::vector<MergeRange> &&ranges,
+                                      size_t threads);
 
   outcome::result<size_t> readCar(std::istream &car_file,
                                   uint64_t car_min,
@@ -118,6 +143,23 @@ namespace fc::storage::cids_index {
                                   std::fstream &rows_file,
                                   std::vector<MergeRange> &ranges);
 
+  /**
+   * Parallel version of readCar.
+   * Car is read by frame-aligned chunks, which are parsed and sorted by
+   * threads. Rows file contains same rows as after readCar, but split into
+   * different ranges.
+   */
+  outcome::result<size_t> readCarParallel(const std::string &car_path,
+                                          uint64_t car_min,
+                                          uint64_t car_max,
+                                          boost::optional<size_t> max_memory,
+                                          IpldPtr ipld,
+                                          Progress *progress,
+                                          std::fstream &rows_file,
+                                          const std::string &rows_path,
+                                          std::vector<MergeRange> &ranges,
+                                          size_t threads);
+
   struct Index {
     RowsInfo info;
 
@@ -158,6 +200,33 @@ namespace fc::storage::cids_index {
         std::ifstream &&file, size_t count, size_t max_keys);
   };
 
+  /**
+   * Memory-mapped index.
+   * Keys are uniformly distributed hashes, so rows are searched with
+   * interpolation, alternated with bisection to bound worst case.
+   * Doesn't lock, pages are cached by os.
+   */
+  struct MmapIndex : Index {
+    common::MappedFile file;
+    gsl::span<const Row> rows;
+
+    /** returns position of key in rows */
+    outcome::result<boost::optional<size_t>> position(const CbCid &key) const;
+    outcome::result<boost::optional<Row>> find(const CbCid &key) const override;
+    size_t size() const override;
+
+    static outcome::result<std::shared_ptr<MmapIndex>> load(
+        const std::string &index_path, size_t count);
+  };
+
   outcome::result<std::shared_ptr<Index>> load(
       const std::string &index_path, boost::optional<size_t> max_memory);
+
+  /**
+   * Loads index without reading rows into memory, for run files which are
+   * not counted against max memory.
+   * Index is mapped, or sparse if address space is not enough.
+   */
+  outcome::result<std::shared_ptr<Index>> loadMapped(
+      const std::string &index_path);
 }  // namespace fc::storage::cids_index
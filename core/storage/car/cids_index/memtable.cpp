@@ -0,0 +1,84 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "storage/car/cids_index/memtable.hpp"
+
+namespace fc::storage::cids_index {
+  boost::optional<Row> Memtable::find(const CbCid &key) const {
+    for (const auto &row : tail) {
+      if (row.key == key) {
+        return row;
+      }
+    }
+    for (const auto &run : runs) {
+      const auto it{std::lower_bound(run.begin(), run.end(), key)};
+      if (it != run.end() && it->key == key) {
+        return *it;
+      }
+    }
+    return boost::none;
+  }
+
+  void Memtable::insert(const Row &row) {
+    if (tail.capacity() < kTail) {
+      tail.reserve(kTail);
+    }
+    tail.push_back(row);
+    ++count;
+    if (tail.size() < kTail) {
+      return;
+    }
+    std::vector<Row> run;
+    run.swap(tail);
+    std::sort(run.begin(), run.end());
+    while (!runs.empty() && runs.back().size() <= run.size()) {
+      std::vector<Row> merged;
+      merged.reserve(runs.back().size() + run.size());
+      std::merge(runs.back().begin(),
+                 runs.back().end(),
+                 run.begin(),
+                 run.end(),
+                 std::back_inserter(merged));
+      runs.pop_back();
+      run = std::move(merged);
+    }
+    runs.push_back(std::move(run));
+  }
+
+  std::vector<Row> Memtable::sorted() const {
+    std::vector<Row> rows;
+    rows.reserve(count);
+    for (const auto &run : runs) {
+      rows.insert(rows.end(), run.begin(), run.end());
+    }
+    rows.insert(rows.end(), tail.begin(), tail.end());
+    std::sort(rows.begin(), rows.end());
+    return rows;
+  }
+
+  void Memtable::eraseUntil(uint64_t max_offset) {
+    auto rows{sorted()};
+    rows.erase(std::remove_if(rows.begin(),
+                              rows.end(),
+                              [&](const Row &row) {
+                                return row.offset.value() <= max_offset;
+                              }),
+               rows.end());
+    tail.clear();
+    runs.clear();
+    count = rows.size();
+    if (!rows.empty()) {
+      runs.push_back(std::move(rows));
+    }
+  }
+
+  size_t Memtable::size() const {
+    return count;
+  }
+
+  bool Memtable::empty() const {
+    return count == 0;
+  }
+}  // namespace fc::storage::cids_index
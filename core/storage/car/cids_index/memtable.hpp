@@ -0,0 +1,47 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "storage/car/cids_index/cids_index.hpp"
+
+namespace fc::storage::cids_index {
+  /**
+   * Rows of written, but not flushed items.
+   * Rows are appended to small unsorted tail. Full tail is sorted into run,
+   * runs of same size are merged like binary counter increment. So there are
+   * at most log(size) sorted runs, and no allocation per row.
+   */
+  struct Memtable {
+    /** estimated, tail fits in few kb */
+    static constexpr size_t kTail{64};
+
+    std::vector<Row> tail;
+    /** sorted runs, from largest to smallest */
+    std::vector<std::vector<Row>> runs;
+    size_t count{};
+
+    boost::optional<Row> find(const CbCid &key) const;
+    void insert(const Row &row);
+    /** returns all rows sorted */
+    std::vector<Row> sorted() const;
+    /** removes rows with offset not greater than max_offset */
+    void eraseUntil(uint64_t max_offset);
+    size_t size() const;
+    bool empty() const;
+
+    template <typename F>
+    void forEach(const F &f) const {
+      for (const auto &run : runs) {
+        for (const auto &row : run) {
+          f(row);
+        }
+      }
+      for (const auto &row : tail) {
+        f(row);
+      }
+    }
+  };
+}  // namespace fc::storage::cids_index
@@ -5,7 +5,9 @@
 
 #pragma once
 
+#include <fcntl.h>
 #include <boost/filesystem/operations.hpp>
+#include <thread>
 
 #include "codec/uvarint.hpp"
 #include "common/error_text.hpp"
@@ -13,6 +15,7 @@
 #include "common/logger.hpp"
 #include "common/outcome_fmt.hpp"
 #include "storage/car/car.hpp"
+#include "storage/car/cids_index/bloom.hpp"
 #include "storage/car/cids_index/cids_index.hpp"
 #include "storage/car/cids_index/progress.hpp"
 #include "storage/ipld/cids_ipld.hpp"
@@ -59,16 +62,55 @@ namespace fc::storage::cids_index {
         log->error("index loading error: {:#}", _index.error());
       }
     }
+    // flushed runs are merged into index on load
+    std::vector<ipld::CidsRun> runs;
+    for (const auto &run_path : CidsIpld::listRuns(cids_path)) {
+      if (auto _run{loadMapped(run_path)}; index && _run) {
+        runs.push_back({run_path, _run.value()});
+      } else {
+        log->warn("run invalidated: {}", run_path);
+        boost::system::error_code ec;
+        boost::filesystem::remove(run_path, ec);
+      }
+    }
+    auto removeRuns{[&] {
+      for (const auto &run : runs) {
+        boost::system::error_code ec;
+        boost::filesystem::remove(run.path, ec);
+      }
+      runs.clear();
+    }};
     std::vector<MergeRange> ranges;
     std::ifstream index_file;
-    if (index && (index->size() != 0)) {
-      if (!readCarItem(car_file, index->info.max_offset, &indexed_end).first
-          || indexed_end > car_size) {
+    std::vector<std::ifstream> run_files(runs.size());
+    if (index) {
+      boost::optional<Row> max_row;
+      if (index->size() != 0) {
+        max_row = index->info.max_offset;
+      }
+      for (const auto &run : runs) {
+        if (run.index->size() != 0
+            && (!max_row
+                || run.index->info.max_offset.offset.value()
+                       > max_row->offset.value())) {
+          max_row = run.index->info.max_offset;
+        }
+      }
+      if (max_row
+          && (!readCarItem(car_file, *max_row, &indexed_end).first
+              || indexed_end > car_size)) {
         log->warn("index invalidated: {}", cids_path);
         index = nullptr;
         indexed_end = header_end;
+        removeRuns();
       }
     }
+    // saved for index before runs and car tail are merged
+    const auto bloom_path{cids_path + ".bloom"};
+    std::shared_ptr<Bloom> bloom;
+    if (index) {
+      bloom = Bloom::load(bloom_path, *index);
+    }
     if (index && indexed_end < car_size) {
       car_file.seekg(gsl::narrow<int64_t>(indexed_end));
       codec::uvarint::VarintDecoder varint;
@@ -76,15 +118,27 @@ namespace fc::storage::cids_index {
           || indexed_end + varint.length + varint.value > car_size) {
         car_size = indexed_end;
         boost::filesystem::resize_file(car_path, car_size);
-      } else if (index->size() != 0) {
+      }
+    }
+    if (index && (indexed_end < car_size || !runs.empty())) {
+      if (index->size() != 0) {
         auto &range{ranges.emplace_back()};
         range.begin = 1;
         range.end = 1 + index->size();
         index_file.open(cids_path, std::ios::binary);
         range.file = &index_file;
+        range.path = cids_path;
+      }
+      for (size_t i{0}; i < runs.size(); ++i) {
+        auto &range{ranges.emplace_back()};
+        range.begin = 1;
+        range.end = 1 + runs[i].index->size();
+        run_files[i].open(runs[i].path, std::ios::binary);
+        range.file = &run_files[i];
+        range.path = runs[i].path;
       }
     }
-    if (!index || indexed_end < car_size) {
+    if (!index || indexed_end < car_size || !runs.empty()) {
       log->info("generating index");
       Progress progress;
       if (Progress::isTty()) {
@@ -105,21 +159,49 @@ namespace fc::storage::cids_index {
         std::fstream rows_file{
             rows_path,
             std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc};
-        OUTCOME_TRY(readCar(car_file,
-                            indexed_end,
-                            car_size,
-                            max_memory,
-                            ipld,
-                            &progress,
-                            rows_file,
-                            ranges));
+        const auto threads{std::thread::hardware_concurrency()};
+        if (threads > 1) {
+          OUTCOME_TRY(readCarParallel(car_path,
+                                      indexed_end,
+                                      car_size,
+                                      max_memory,
+                                      ipld,
+                                      &progress,
+                                      rows_file,
+                                      rows_path,
+                                      ranges,
+                                      threads));
+        } else {
+          OUTCOME_TRY(readCar(car_file,
+                              indexed_end,
+                              car_size,
+                              max_memory,
+                              ipld,
+                              &progress,
+                              rows_file,
+                              ranges));
+        }
+        if (bloom) {
+          // recovers bloom from runs and car tail without reading index
+          for (auto &range : ranges) {
+            if (range.file != &index_file) {
+              OUTCOME_TRY(
+                  bloom->insertRows(*range.file, range.begin, range.end));
+            }
+          }
+        }
         auto tmp_cids_path{cids_path + ".tmp"};
         if (ranges.size() == 1) {
           tmp_cids_path = rows_path;
         } else {
           progress.sort();
-          std::ofstream index_file{tmp_cids_path, std::ios::binary};
-          OUTCOME_TRY(merge(index_file, std::move(ranges)));
+          if (threads > 1) {
+            OUTCOME_TRY(
+                mergeParallel(tmp_cids_path, std::move(ranges), threads));
+          } else {
+            std::ofstream index_file{tmp_cids_path, std::ios::binary};
+            OUTCOME_TRY(merge(index_file, std::move(ranges)));
+          }
           boost::system::error_code ec;
           boost::filesystem::remove(rows_path, ec);
         }
@@ -132,7 +214,14 @@ namespace fc::storage::cids_index {
       }()};
       if (_index) {
         index = _index.value();
+        removeRuns();
         log->info("index generated: {}", cids_path);
+        if (bloom) {
+          if (auto _saved{bloom->save(bloom_path, *index)}; !_saved) {
+            log->error("bloom saving error: {:#}", _saved.error());
+            return _saved.error();
+          }
+        }
       } else {
         log->error("index generation error: {:#}", _index.error());
         return _index.error();
@@ -153,9 +242,23 @@ namespace fc::storage::cids_index {
         }
       }
     }
+    if (!bloom) {
+      auto _bloom{Bloom::loadOrCreate(bloom_path, cids_path, *index)};
+      if (!_bloom) {
+        log->error("bloom loading error: {:#}", _bloom.error());
+        return _bloom.error();
+      }
+      bloom = _bloom.value();
+    }
     auto _ipld{std::make_shared<CidsIpld>()};
-    _ipld->car_file.open(car_path, std::ios::in | std::ios::binary);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+    _ipld->car_fd = open(car_path.c_str(), O_RDONLY);
+    if (_ipld->car_fd == -1) {
+      log->error("open car failed: {}", car_path);
+      return ERROR_TEXT("loadOrCreateWithProgress: open car failed");
+    }
     _ipld->index = index;
+    _ipld->bloom = bloom;
     _ipld->ipld = ipld;
     if (writable) {
       _ipld->writable = {fopen(car_path.c_str(), "ab"), fclose};
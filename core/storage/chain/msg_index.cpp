@@ -0,0 +1,260 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "storage/chain/msg_index.hpp"
+
+#include "adt/array.hpp"
+#include "common/endian.hpp"
+#include "common/error_text.hpp"
+#include "primitives/address/address_codec.hpp"
+#include "primitives/tipset/load.hpp"
+
+namespace fc::storage::blockchain {
+  /** value of message key */
+  struct MsgIndexEntry {
+    std::vector<CID> tsk;
+    ChainEpoch height{};
+    uint64_t index{};
+    MessageReceipt receipt;
+  };
+  CBOR_TUPLE(MsgIndexEntry, tsk, height, index, receipt)
+
+  /** value of address key */
+  struct MsgIndexParties {
+    Address from;
+    Address to;
+  };
+  CBOR_TUPLE(MsgIndexParties, from, to)
+
+  constexpr uint8_t kMessagePrefix{'m'};
+  constexpr uint8_t kAddressPrefix{'a'};
+
+  inline Bytes messageKey(const CID &cid) {
+    Bytes key{kMessagePrefix};
+    append(key, cid.toBytes().value());
+    return key;
+  }
+
+  /** address encoding is prefix-free, so address keys don't overlap */
+  inline Bytes addressPrefix(const Address &address) {
+    Bytes key{kAddressPrefix};
+    append(key, primitives::address::encode(address));
+    return key;
+  }
+
+  /** address keys are sorted by inclusion height and message index */
+  inline Bytes addressKey(const Address &address,
+                          ChainEpoch height,
+                          uint64_t index,
+                          const CID &cid) {
+    auto key{addressPrefix(address)};
+    common::putUint64BigEndian(key, height);
+    common::putUint64BigEndian(key, index);
+    append(key, cid.toBytes().value());
+    return key;
+  }
+
+  inline std::vector<CID> tskCids(const TipsetKey &tsk) {
+    std::vector<CID> cids;
+    cids.reserve(tsk.cids().size());
+    for (const auto &cid : tsk.cids()) {
+      cids.emplace_back(cid);
+    }
+    return cids;
+  }
+
+  inline outcome::result<TipsetKey> cidsTsk(const std::vector<CID> &cids) {
+    if (auto tsk{TipsetKey::make(cids)}) {
+      return std::move(*tsk);
+    }
+    return ERROR_TEXT("MsgIndex: invalid tipset key");
+  }
+
+  MsgIndex::MsgIndex(MapPtr map, TsLoadPtr ts_load, IpldPtr ipld)
+      : map{map},
+        ts_load{std::move(ts_load)},
+        ipld{std::move(ipld)},
+        head_key{"head", map},
+        bottom_key{"bottom", map} {}
+
+  outcome::result<boost::optional<MsgIndex::Found>> MsgIndex::find(
+      const CID &cid) const {
+    const auto key{messageKey(cid)};
+    if (!map->contains(key)) {
+      return boost::none;
+    }
+    OUTCOME_TRY(raw, map->get(key));
+    OUTCOME_TRY(entry, codec::cbor::decode<MsgIndexEntry>(raw));
+    OUTCOME_TRY(tsk, cidsTsk(entry.tsk));
+    return Found{std::move(tsk), entry.height, entry.index, entry.receipt};
+  }
+
+  outcome::result<std::vector<MsgIndex::Listed>> MsgIndex::list(
+      const Address &address, ChainEpoch min_height) const {
+    std::vector<Listed> listed;
+    const auto prefix{addressPrefix(address)};
+    auto begin{prefix};
+    common::putUint64BigEndian(begin, std::max<ChainEpoch>(min_height, 0));
+    auto cursor{map->cursor()};
+    for (cursor->seek(begin); cursor->isValid(); cursor->next()) {
+      const auto key{cursor->key()};
+      if (!startsWith(key, prefix)) {
+        break;
+      }
+      const auto suffix{BytesIn{key}.subspan(prefix.size())};
+      if (suffix.size() < 2 * sizeof(uint64_t)) {
+        return ERROR_TEXT("MsgIndex.list: invalid key");
+      }
+      auto &item{listed.emplace_back()};
+      item.height = boost::endian::load_big_u64(suffix.data());
+      OUTCOME_TRYA(item.cid,
+                   CID::fromBytes(suffix.subspan(2 * sizeof(uint64_t))));
+      OUTCOME_TRY(parties,
+                  codec::cbor::decode<MsgIndexParties>(cursor->value()));
+      item.from = parties.from;
+      item.to = parties.to;
+    }
+    return listed;
+  }
+
+  outcome::result<void> MsgIndex::apply(const TipsetCPtr &ts) {
+    OUTCOME_TRY(visit(ts, true));
+    setHead(ts);
+    return outcome::success();
+  }
+
+  outcome::result<void> MsgIndex::revert(const TipsetCPtr &ts) {
+    OUTCOME_TRY(visit(ts, false));
+    OUTCOME_TRY(parent, ts_load->load(ts->getParents()));
+    if (ts->epoch() <= bottom_->epoch()) {
+      setBottom(parent);
+    }
+    setHead(parent);
+    return outcome::success();
+  }
+
+  outcome::result<void> MsgIndex::update(const TipsetCPtr &head) {
+    if (!head_key.has() || !bottom_key.has()) {
+      // empty index, backfill indexes tipsets below head
+      setHead(head);
+      setBottom(head);
+      return outcome::success();
+    }
+    OUTCOME_TRY(head_cids,
+                codec::cbor::decode<std::vector<CID>>(head_key.get()));
+    OUTCOME_TRY(head_tsk, cidsTsk(head_cids));
+    OUTCOME_TRYA(head_, ts_load->load(head_tsk));
+    OUTCOME_TRY(bottom_cids,
+                codec::cbor::decode<std::vector<CID>>(bottom_key.get()));
+    OUTCOME_TRY(bottom_tsk, cidsTsk(bottom_cids));
+    OUTCOME_TRYA(bottom_, ts_load->load(bottom_tsk));
+
+    std::vector<TipsetCPtr> path;
+    auto ts{head};
+    while (head_->key != ts->key) {
+      if (head_->epoch() >= ts->epoch()) {
+        OUTCOME_TRY(revert(head_));
+      } else {
+        path.push_back(ts);
+        OUTCOME_TRYA(ts, ts_load->load(ts->getParents()));
+      }
+    }
+    for (auto it{path.rbegin()}; it != path.rend(); ++it) {
+      OUTCOME_TRY(apply(*it));
+    }
+    return outcome::success();
+  }
+
+  outcome::result<bool> MsgIndex::backfill(size_t limit) {
+    for (size_t i{0}; i < limit; ++i) {
+      if (bottom_->epoch() == 0) {
+        return false;
+      }
+      OUTCOME_TRY(parent, ts_load->load(bottom_->getParents()));
+      OUTCOME_TRY(visit(bottom_, true));
+      setBottom(parent);
+    }
+    return bottom_->epoch() != 0;
+  }
+
+  ChainEpoch MsgIndex::bottomHeight() const {
+    return bottom_->epoch();
+  }
+
+  const TipsetCPtr &MsgIndex::head() const {
+    return head_;
+  }
+
+  outcome::result<void> MsgIndex::visit(const TipsetCPtr &ts, bool apply) {
+    OUTCOME_TRY(parent, ts_load->load(ts->getParents()));
+    adt::Array<MessageReceipt> receipts{ts->getParentMessageReceipts(), ipld};
+    const auto tsk{tskCids(ts->key)};
+    // message was executed in other tipset, revert keeps its message key
+    auto executedInOther{[&](const Bytes &key) -> outcome::result<bool> {
+      if (!map->contains(key)) {
+        return false;
+      }
+      OUTCOME_TRY(raw, map->get(key));
+      OUTCOME_TRY(entry, codec::cbor::decode<MsgIndexEntry>(raw));
+      return entry.tsk != tsk;
+    }};
+    auto batch{map->batch()};
+    // receipts are indexed by messages with valid nonces
+    OUTCOME_TRY(parent->visitMessages(
+        {ipld, true, true},
+        [&](auto i, auto, auto &cid, auto, auto) -> outcome::result<void> {
+          const auto key{messageKey(cid)};
+          if (apply) {
+            MsgIndexEntry entry{tsk, ts->epoch(), i, {}};
+            OUTCOME_TRYA(entry.receipt, receipts.get(i));
+            OUTCOME_TRY(value, codec::cbor::encode(entry));
+            OUTCOME_TRY(batch->put(key, std::move(value)));
+          } else {
+            OUTCOME_TRY(other, executedInOther(key));
+            if (!other) {
+              OUTCOME_TRY(batch->remove(key));
+            }
+          }
+          return outcome::success();
+        }));
+    // addresses are indexed for all included messages, like StateListMessages
+    OUTCOME_TRY(parent->visitMessages(
+        {ipld, false, true},
+        [&](auto i, auto, auto &cid, auto, auto *msg) -> outcome::result<void> {
+          std::vector<Bytes> address_keys;
+          address_keys.push_back(
+              addressKey(msg->from, parent->epoch(), i, cid));
+          if (msg->to != msg->from) {
+            address_keys.push_back(
+                addressKey(msg->to, parent->epoch(), i, cid));
+          }
+          if (apply) {
+            OUTCOME_TRY(parties,
+                        codec::cbor::encode(
+                            MsgIndexParties{msg->from, msg->to}));
+            for (const auto &address_key : address_keys) {
+              OUTCOME_TRY(batch->put(address_key, copy(parties)));
+            }
+          } else {
+            // keys are specific to inclusion in reverted parent
+            for (const auto &address_key : address_keys) {
+              OUTCOME_TRY(batch->remove(address_key));
+            }
+          }
+          return outcome::success();
+        }));
+    return batch->commit();
+  }
+
+  void MsgIndex::setHead(TipsetCPtr ts) {
+    head_key.setCbor(tskCids(ts->key));
+    head_ = std::move(ts);
+  }
+
+  void MsgIndex::setBottom(TipsetCPtr ts) {
+    bottom_key.setCbor(tskCids(ts->key));
+    bottom_ = std::move(ts);
+  }
+}  // namespace fc::storage::blockchain
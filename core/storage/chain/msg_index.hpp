@@ -0,0 +1,85 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "fwd.hpp"
+#include "primitives/tipset/tipset.hpp"
+#include "storage/map_prefix/prefix.hpp"
+#include "vm/runtime/runtime_types.hpp"
+
+namespace fc::storage::blockchain {
+  using primitives::address::Address;
+  using primitives::tipset::TipsetCPtr;
+  using primitives::tipset::TipsetKey;
+  using vm::runtime::MessageReceipt;
+
+  /**
+   * Persistent index of messages included on main chain.
+   * Message cid maps to tipset where message was executed, its index and
+   * receipt. Sender and receiver addresses map to cids of all included
+   * messages, including messages skipped by execution for invalid nonce.
+   * Follows head changes, reverted tipsets remove their messages.
+   * Tipsets below bottom are indexed by backfill from chain store, so index is
+   * rebuilt when its keys are removed.
+   */
+  class MsgIndex {
+   public:
+    struct Found {
+      /** tipset where message was executed */
+      TipsetKey tsk;
+      ChainEpoch height{};
+      uint64_t index{};
+      MessageReceipt receipt;
+    };
+
+    struct Listed {
+      CID cid;
+      /** height of tipset where message was included */
+      ChainEpoch height{};
+      Address from;
+      Address to;
+    };
+
+    MsgIndex(MapPtr map, TsLoadPtr ts_load, IpldPtr ipld);
+
+    outcome::result<boost::optional<Found>> find(const CID &cid) const;
+    /** messages from or to address included at min_height or above */
+    outcome::result<std::vector<Listed>> list(const Address &address,
+                                              ChainEpoch min_height) const;
+
+    /** indexes messages included in parent of ts, ts is child of head */
+    outcome::result<void> apply(const TipsetCPtr &ts);
+    /** removes messages executed in ts, ts is head */
+    outcome::result<void> revert(const TipsetCPtr &ts);
+    /**
+     * Moves index to head, reverting tipsets of stale branch.
+     * Used on start, when head could change since index was saved.
+     */
+    outcome::result<void> update(const TipsetCPtr &head);
+    /**
+     * Indexes up to limit tipsets below bottom.
+     * Returns false when genesis is reached.
+     */
+    outcome::result<bool> backfill(size_t limit);
+
+    /** messages included at bottom height or above are indexed */
+    ChainEpoch bottomHeight() const;
+    const TipsetCPtr &head() const;
+
+   private:
+    outcome::result<void> visit(const TipsetCPtr &ts, bool apply);
+    void setHead(TipsetCPtr ts);
+    void setBottom(TipsetCPtr ts);
+
+    MapPtr map;
+    TsLoadPtr ts_load;
+    IpldPtr ipld;
+    OneKey head_key;
+    OneKey bottom_key;
+    TipsetCPtr head_;
+    TipsetCPtr bottom_;
+  };
+}  // namespace fc::storage::blockchain
@@ -5,6 +5,7 @@
 
 #include "storage/chain/msg_waiter.hpp"
 
+#include <algorithm>
 #include <boost/asio/io_context.hpp>
 #include <utility>
 
@@ -22,11 +23,16 @@ namespace fc::storage::blockchain {
       TsLoadPtr ts_load,
       IpldPtr ipld,
       std::shared_ptr<boost::asio::io_context> io,
-      const std::shared_ptr<ChainStore> &chain_store) {
+      const std::shared_ptr<ChainStore> &chain_store,
+      MapPtr index_map) {
     auto waiter{std::make_shared<MsgWaiter>()};
     waiter->ts_load = std::move(ts_load);
     waiter->ipld = std::move(ipld);
     waiter->io = std::move(io);
+    if (index_map) {
+      waiter->index = std::make_shared<MsgIndex>(
+          std::move(index_map), waiter->ts_load, waiter->ipld);
+    }
     waiter->head_sub =
         chain_store->subscribeHeadChanges([=](const auto &changes) {
           for (const auto &change : changes) {
@@ -51,6 +57,24 @@ namespace fc::storage::blockchain {
     _search(std::move(ts), cid, lookback_limit, std::move(cb));
   }
 
+  boost::optional<std::vector<MsgIndex::Listed>> MsgWaiter::list(
+      const TipsetCPtr &ts, const Address &address, ChainEpoch min_height) {
+    std::unique_lock lock{mutex};
+    if (!index || ts->key != index->head()->key
+        || min_height < index->bottomHeight()) {
+      return boost::none;
+    }
+    auto listed{index->list(address, min_height)};
+    if (!listed) {
+      spdlog::error("MsgWaiter.list: {:#}", listed.error());
+      return boost::none;
+    }
+    std::stable_sort(listed.value().begin(),
+                     listed.value().end(),
+                     [](auto &l, auto &r) { return l.height > r.height; });
+    return std::move(listed.value());
+  }
+
   void MsgWaiter::wait(const CID &cid,
                        ChainEpoch lookback_limit,
                        EpochDuration confidence,
@@ -93,6 +117,7 @@ namespace fc::storage::blockchain {
   outcome::result<void> MsgWaiter::onHeadChange(const HeadChange &change) {
     std::unique_lock lock{mutex};
     const auto &ts{change.value};
+    indexHeadChange(change);
     if (change.type == HeadChangeType::CURRENT) {
       head = ts;
     } else {
@@ -127,6 +152,55 @@ namespace fc::storage::blockchain {
     return outcome::success();
   }
 
+  void MsgWaiter::indexHeadChange(const HeadChange &change) {
+    if (!index) {
+      return;
+    }
+    const auto &ts{change.value};
+    outcome::result<void> res{outcome::success()};
+    switch (change.type) {
+      case HeadChangeType::CURRENT:
+        res = index->update(ts);
+        if (res) {
+          backfill();
+        }
+        break;
+      case HeadChangeType::APPLY:
+        res = index->apply(ts);
+        break;
+      case HeadChangeType::REVERT:
+        res = index->revert(ts);
+        break;
+    }
+    if (!res) {
+      // searches walk tipsets, index is repaired by update on restart
+      spdlog::error("MsgWaiter index disabled: {:#}", res.error());
+      index.reset();
+    }
+  }
+
+  void MsgWaiter::backfill() {
+    io->post([weak{weak_from_this()}] {
+      if (auto self{weak.lock()}) {
+        std::unique_lock lock{self->mutex};
+        if (!self->index) {
+          return;
+        }
+        const auto more{self->index->backfill(kBackfillBatch)};
+        if (!more) {
+          // old messages may be absent after snapshot import
+          spdlog::warn("MsgWaiter.backfill stopped at {}: {:#}",
+                       self->index->bottomHeight(),
+                       more.error());
+          return;
+        }
+        if (more.value()) {
+          self->backfill();
+        }
+      }
+    });
+  }
+
   outcome::result<bool> MsgWaiter::isSearch(const CID &cid) {
     OUTCOME_TRY(cbor, ipld->get(cid));
     OUTCOME_TRY(msg, vm::message::UnsignedMessage::decode(cbor));
@@ -144,9 +218,42 @@ namespace fc::storage::blockchain {
     search.min_height =
         lookback_limit == -1 ? 0 : head->epoch() - lookback_limit;
     search.ts = std::move(ts);
+    if (indexSearch(search)) {
+      return;
+    }
     searchLoop(searching.emplace(searching.end(), std::move(search)));
   }
 
+  bool MsgWaiter::indexSearch(const Search &search) {
+    if (!index || search.ts->key != index->head()->key) {
+      return false;
+    }
+    auto found{index->find(search.cid)};
+    if (!found) {
+      spdlog::error("MsgWaiter.indexSearch: {:#}", found.error());
+      return false;
+    }
+    if (auto &entry{found.value()}) {
+      if (entry->height < search.min_height) {
+        search.cb({}, {});
+        return true;
+      }
+      auto ts{ts_load->load(entry->tsk)};
+      if (!ts) {
+        return false;
+      }
+      search.cb(std::move(ts.value()), std::move(entry->receipt));
+      return true;
+    }
+    // messages executed since min_height are indexed
+    const auto bottom{index->bottomHeight()};
+    if (bottom == 0 || bottom < search.min_height) {
+      search.cb({}, {});
+      return true;
+    }
+    return false;
+  }
+
   void MsgWaiter::searchLoop(Searching::iterator it) {
     auto &search{*it};
     TipsetCPtr ts_found;
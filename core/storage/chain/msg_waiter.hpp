@@ -9,6 +9,7 @@
 
 #include "fwd.hpp"
 #include "storage/chain/chain_store.hpp"
+#include "storage/chain/msg_index.hpp"
 #include "vm/runtime/runtime_types.hpp"
 
 namespace fc::storage::blockchain {
@@ -33,11 +34,20 @@ namespace fc::storage::blockchain {
     };
     using Searching = std::list<Search>;
 
+    /** tipsets indexed by one backfill step on io */
+    static constexpr size_t kBackfillBatch{20};
+
+    /**
+     * Creates waiter.
+     * Messages are looked up in persistent index stored in index_map, or by
+     * walking tipsets when index_map is null.
+     */
     static std::shared_ptr<MsgWaiter> create(
         TsLoadPtr ts_load,
         IpldPtr ipld,
         std::shared_ptr<boost::asio::io_context> io,
-        const std::shared_ptr<ChainStore>& chain_store);
+        const std::shared_ptr<ChainStore>& chain_store,
+        MapPtr index_map = nullptr);
 
     void search(TipsetCPtr ts,
                 const CID &cid,
@@ -47,11 +57,22 @@ namespace fc::storage::blockchain {
               ChainEpoch lookback_limit,
               EpochDuration confidence,
               Callback cb);
+    /**
+     * Lists indexed messages from or to address, included from min_height to
+     * ts, by descending height.
+     * Returns none when index doesn't cover range.
+     */
+    boost::optional<std::vector<MsgIndex::Listed>> list(
+        const TipsetCPtr &ts, const Address &address, ChainEpoch min_height);
 
    private:
     /** Head change subscription. */
     outcome::result<void> onHeadChange(const HeadChange &change);
+    void indexHeadChange(const HeadChange &change);
+    void backfill();
     outcome::result<bool> isSearch(const CID &cid);
+    /** answers search from index, returns false if index can't answer */
+    bool indexSearch(const Search &search);
     void _search(TipsetCPtr ts,
                  const CID &cid,
                  ChainEpoch lookback_limit,
@@ -66,6 +87,7 @@ namespace fc::storage::blockchain {
     mutable std::mutex mutex;
     TipsetCPtr head;
     std::shared_ptr<vm::state::StateTreeImpl> state_tree;
+    std::shared_ptr<MsgIndex> index;
     // TODO(turuslan): FIL-420 check cache memory usage
     Waiting waiting;
     // TODO(turuslan): FIL-420 check cache memory usage
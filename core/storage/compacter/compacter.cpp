@@ -20,6 +20,9 @@ namespace fc::storage::compacter {
   void CompacterPutBlockHeader::put(const CbCid &key, BytesCow &&value) {
     if (auto compacter{_compacter.lock()}) {
       std::shared_lock lock{compacter->ipld_mutex};
+      if (compacter->gc_marks) {
+        compacter->gc_marks->mark(key);
+      }
       (compacter->use_new_ipld ? compacter->new_ipld : compacter->old_ipld)
           ->put(key, std::move(value));
     }
@@ -37,7 +40,7 @@ namespace fc::storage::compacter {
     std::shared_lock lock{ipld_mutex};
     if ((compact_on_car != 0) && !flag.load()) {
       std::shared_lock written_lock{old_ipld->written_mutex};
-      if (old_ipld->car_offset > compact_on_car) {
+      if (old_ipld->car_offset > gc_car + compact_on_car) {
         asyncStart();
       }
     }
@@ -45,16 +48,52 @@ namespace fc::storage::compacter {
       queue->pushChildren(value);
       new_ipld->put(key, std::move(value));
     } else {
+      if (gc_marks) {
+        if (!gc_marks->sweeping) {
+          queue->pushChildren(value);
+        }
+        gc_marks->mark(key);
+      }
       old_ipld->put(key, std::move(value));
     }
   }
 
+  void CompacterIpld::putMany(
+      gsl::span<const std::pair<CbCid, BytesIn>> items) {
+    std::shared_lock lock{ipld_mutex};
+    if ((compact_on_car != 0) && !flag.load()) {
+      std::shared_lock written_lock{old_ipld->written_mutex};
+      if (old_ipld->car_offset > gc_car + compact_on_car) {
+        asyncStart();
+      }
+    }
+    if (use_new_ipld) {
+      for (const auto &item : items) {
+        queue->pushChildren(item.second);
+      }
+      new_ipld->putMany(items);
+    } else {
+      if (gc_marks) {
+        for (const auto &[key, value] : items) {
+          if (!gc_marks->sweeping) {
+            queue->pushChildren(value);
+          }
+          gc_marks->mark(key);
+        }
+      }
+      old_ipld->putMany(items);
+    }
+  }
+
   void CompacterIpld::carFlush() {
     std::shared_lock lock{ipld_mutex};
     (use_new_ipld ? new_ipld : old_ipld)->carFlush();
   }
 
   void CompacterIpld::open() {
+    if (gc_car_key.has()) {
+      gc_car = gc_car_key.getCbor<uint64_t>();
+    }
     if (start_head_key.has()) {
       resume();
     }
@@ -64,7 +103,13 @@ namespace fc::storage::compacter {
     if (flag.exchange(true)) {
       return false;
     }
-    thread.io->post([&] { doStart(); });
+    thread.io->post([&] {
+      if (gc) {
+        doGc();
+      } else {
+        doStart();
+      }
+    });
     return true;
   }
 
@@ -78,6 +123,12 @@ namespace fc::storage::compacter {
     if (boost::filesystem::exists(index_path)) {
       boost::filesystem::remove(index_path);
     }
+    if (boost::filesystem::exists(index_path + ".bloom")) {
+      boost::filesystem::remove(index_path + ".bloom");
+    }
+    for (const auto &run_path : CidsIpld::listRuns(index_path)) {
+      boost::filesystem::remove(run_path);
+    }
     auto car{cids_index::loadOrCreateWithProgress(
         car_path, true, old_ipld->max_memory, old_ipld->ipld, nullptr)};
     if (!car) {
@@ -91,6 +142,37 @@ namespace fc::storage::compacter {
     queue->visited = new_ipld;
     queue->open(true);
     std::unique_lock vm_lock{*interpreter->mutex};
+    pushRoots();
+    start_head_key.setCbor(start_head->key.cids());
+    {
+      std::unique_lock ipld_lock{ipld_mutex};
+      old_ipld->carFlush();
+      use_new_ipld = true;
+    }
+    vm_lock.unlock();
+    thread.io->post([&] { flow(); });
+  }
+
+  void CompacterIpld::doGc() {
+    spdlog::info("CompacterIpld.doGc");
+    auto marks{GcMarks::make(old_ipld, gc_segment)};
+    if (!marks) {
+      spdlog::error("CompacterIpld.doGc: snapshot failed: {:#}", ~marks);
+      return;
+    }
+    queue->visited = marks.value();
+    queue->open(true);
+    std::unique_lock vm_lock{*interpreter->mutex};
+    pushRoots();
+    {
+      std::unique_lock ipld_lock{ipld_mutex};
+      gc_marks = marks.value();
+    }
+    vm_lock.unlock();
+    thread.io->post([&] { flow(); });
+  }
+
+  void CompacterIpld::pushRoots() {
     std::shared_lock ts_lock{*ts_mutex};
     const auto genesis{ts_load->lazyLoad(ts_main->bottom().second).value()};
     start_head = ts_load->lazyLoad(ts_main->chain.rbegin()->second).value();
@@ -101,14 +183,6 @@ namespace fc::storage::compacter {
     pushState(*asBlake(start_head->getParentStateRoot()));
     state_bottom = start_head;
     headers_top_key.setCbor(headers_top->key.cids());
-    start_head_key.setCbor(start_head->key.cids());
-    {
-      std::unique_lock ipld_lock{ipld_mutex};
-      old_ipld->carFlush();
-      use_new_ipld = true;
-    }
-    vm_lock.unlock();
-    thread.io->post([&] { flow(); });
   }
 
   void CompacterIpld::resume() {
@@ -214,15 +288,64 @@ namespace fc::storage::compacter {
   }
 
   void CompacterIpld::queueLoop() {
-    auto &value{reuse_buffer};
-    while (auto key{queue->pop()}) {
-      if (!old_ipld->get(*key, value)) {
-        spdlog::warn("CompacterIpld.queueLoop not found {}",
-                     common::hex_lower(*key));
-        continue;
+    // estimated, amortizes queue lock
+    constexpr size_t kBatch{64};
+    const auto start{std::chrono::steady_clock::now()};
+    const size_t blocks_before{copied_blocks};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto work{[&] {
+      std::vector<Bytes> values;
+      std::vector<std::pair<CbCid, BytesIn>> blocks;
+      while (true) {
+        const auto keys{queue->popBatch(kBatch)};
+        if (keys.empty()) {
+          break;
+        }
+        auto done{gsl::finally([&] { queue->done(); })};
+        try {
+          values.resize(keys.size());
+          blocks.clear();
+          for (size_t i{0}; i < keys.size(); ++i) {
+            const auto &key{keys[i]};
+            auto &value{values[i]};
+            if (!old_ipld->get(key, value)) {
+              spdlog::warn("CompacterIpld.queueLoop not found {}",
+                           common::hex_lower(key));
+              continue;
+            }
+            // children are queued before parent is marked visited by put
+            queue->pushChildren(value);
+            blocks.emplace_back(key, value);
+            copied_bytes += value.size();
+          }
+          queue->visited->putMany(blocks);
+          copied_blocks += blocks.size();
+        } catch (...) {
+          std::unique_lock lock{error_mutex};
+          if (!error) {
+            error = std::current_exception();
+          }
+          break;
+        }
       }
-      queue->pushChildren(value);
-      new_ipld->put(*key, BytesIn{value});
+    }};
+    std::vector<std::thread> threads;
+    for (size_t i{1}; i < copy_threads; ++i) {
+      threads.emplace_back(work);
+    }
+    work();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    const size_t blocks{copied_blocks - blocks_before};
+    if (blocks != 0) {
+      const std::chrono::duration<double> seconds{
+          std::chrono::steady_clock::now() - start};
+      copy_rate = blocks / std::max(seconds.count(), 1e-3);
     }
   }
 
@@ -278,7 +401,7 @@ namespace fc::storage::compacter {
           break;
         }
         const auto root{*asBlake(ts->getParentStateRoot())};
-        if (!new_ipld->has(root)) {
+        if (!queue->visited->has(root)) {
           spdlog::warn("CompacterIpld.finish missing state height={}",
                        ts->epoch());
           if (epochs <= epochs_full_state) {
@@ -291,8 +414,16 @@ namespace fc::storage::compacter {
       }
     }
     queueLoop();
+    if (gc_marks) {
+      // children of blocks written after marking are not queued
+      gc_marks->sweeping = true;
+    }
     queue->clear();
-    {
+    if (gc_marks) {
+      vm_lock.unlock();
+      ts_lock.unlock();
+      finishGc();
+    } else {
       std::unique_lock old_flush_lock{old_ipld->flush_mutex};
       std::unique_lock new_flush_lock{new_ipld->flush_mutex};
       std::unique_lock ipld_lock{ipld_mutex};
@@ -302,6 +433,20 @@ namespace fc::storage::compacter {
                                 old_ipld->car_path + ".old_ipld");
       boost::filesystem::rename(new_ipld->car_path, old_ipld->car_path);
       boost::filesystem::rename(new_ipld->index_path, old_ipld->index_path);
+      if (boost::filesystem::exists(new_ipld->index_path + ".bloom")) {
+        boost::filesystem::rename(new_ipld->index_path + ".bloom",
+                                  old_ipld->index_path + ".bloom");
+      }
+      for (const auto &run : old_ipld->runs) {
+        boost::filesystem::remove(run.path);
+      }
+      // runs are changed only under flush_mutex
+      for (auto &run : new_ipld->runs) {
+        auto run_path{CidsIpld::runPath(
+            old_ipld->index_path, run.index->info.max_offset.offset.value())};
+        boost::filesystem::rename(run.path, run_path);
+        run.path = run_path;
+      }
       new_ipld->car_path = old_ipld->car_path;
       new_ipld->index_path = old_ipld->index_path;
       use_new_ipld = false;
@@ -313,6 +458,23 @@ namespace fc::storage::compacter {
     spdlog::info("CompacterIpld done");
   }
 
+  void CompacterIpld::finishGc() {
+    auto reclaimed{gc_marks->sweep(gc_max_live)};
+    if (reclaimed) {
+      gc_reclaimed += reclaimed.value();
+      spdlog::info("CompacterIpld.finishGc reclaimed {} bytes",
+                   reclaimed.value());
+    } else {
+      spdlog::error("CompacterIpld.finishGc: sweep failed: {:#}", ~reclaimed);
+    }
+    queue->visited.reset();
+    std::unique_lock ipld_lock{ipld_mutex};
+    gc_marks.reset();
+    std::shared_lock written_lock{old_ipld->written_mutex};
+    gc_car = old_ipld->car_offset;
+    gc_car_key.setCbor(gc_car);
+  }
+
   void CompacterIpld::pushState(const CbCid &state) {
     queue->push(state);
   }
@@ -320,7 +482,7 @@ namespace fc::storage::compacter {
   void CompacterIpld::lookbackState(const CbCid &state) {
     std::vector<CbCid> copy;
     std::vector<CbCid> recurse;
-    lookbackActors(copy, recurse, old_ipld, new_ipld, state);
+    lookbackActors(copy, recurse, old_ipld, queue->visited, state);
     queue->push(recurse);
     for (auto it{copy.rbegin()}; it != copy.rend(); ++it) {
       this->copy(*it);
@@ -330,8 +492,8 @@ namespace fc::storage::compacter {
   void CompacterIpld::copy(const CbCid &key) {
     auto &value{reuse_buffer};
     if (old_ipld->get(key, value)) {
-      new_ipld->put(key, BytesIn{value});
-    } else if (!new_ipld->has(key)) {
+      queue->visited->put(key, BytesIn{value});
+    } else if (!queue->visited->has(key)) {
       spdlog::warn("CompacterIpld.copy not found {}", common::hex_lower(key));
     }
   }
@@ -7,6 +7,7 @@
 
 #include "common/io_thread.hpp"
 #include "primitives/tipset/chain.hpp"
+#include "storage/compacter/gc.hpp"
 #include "storage/compacter/queue.hpp"
 #include "storage/ipld/cids_ipld.hpp"
 #include "storage/map_prefix/prefix.hpp"
@@ -44,17 +45,25 @@ namespace fc::storage::compacter {
 
     bool get(const CbCid &key, Bytes *value) const override;
     void put(const CbCid &key, BytesCow &&value) override;
+    void putMany(gsl::span<const std::pair<CbCid, BytesIn>> items) override;
 
     void carFlush();
 
     void open();
     bool asyncStart();
     void doStart();
+    /** starts marking for incremental gc instead of copying */
+    void doGc();
+    /** queues genesis and head states, requires interpreter mutex */
+    void pushRoots();
     void resume();
     void flow();
     void headersBatch();
+    /** copies queued blocks and their children with copy_threads threads */
     void queueLoop();
     void finish();
+    /** sweeps mostly dead segments of car */
+    void finishGc();
     void pushState(const CbCid &state);
     void lookbackState(const CbCid &state);
     void copy(const CbCid &key);
@@ -63,6 +72,13 @@ namespace fc::storage::compacter {
     size_t epochs_full_state{};
     size_t epochs_lookback_state{};
     size_t epochs_messages{};
+    size_t copy_threads{1};
+    /** reclaim car in place instead of copying to new car */
+    bool gc{};
+    /** estimated, 64mb */
+    uint64_t gc_segment{uint64_t{64} << 20};
+    /** segments with less live bytes are reclaimed */
+    double gc_max_live{0.25};
 
     std::string path;
     IoThread thread;
@@ -74,6 +90,9 @@ namespace fc::storage::compacter {
     OneKey start_head_key{"", {}};
     TipsetCPtr start_head;
     OneKey headers_top_key{"", {}};
+    /** car size after last gc */
+    OneKey gc_car_key{"", {}};
+    uint64_t gc_car{};
     TipsetCPtr headers_top;
     TipsetCPtr state_bottom;
     std::shared_ptr<CompacterQueue> queue;
@@ -82,8 +101,15 @@ namespace fc::storage::compacter {
     TsBranchPtr ts_main;
     mutable std::shared_mutex ipld_mutex;
     std::shared_ptr<CidsIpld> new_ipld;
+    /** marks of running gc, guarded by ipld_mutex */
+    std::shared_ptr<GcMarks> gc_marks;
+    std::atomic_size_t gc_reclaimed{};
     std::atomic_bool flag;
     bool use_new_ipld{};
     Bytes reuse_buffer;
+    std::atomic_size_t copied_blocks{};
+    std::atomic_size_t copied_bytes{};
+    /** blocks per second of last queueLoop */
+    std::atomic<double> copy_rate{};
   };
 }  // namespace fc::storage::compacter
@@ -0,0 +1,214 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "storage/compacter/gc.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "codec/uvarint.hpp"
+#include "common/append.hpp"
+#include "common/error_text.hpp"
+#include "common/logger.hpp"
+
+namespace fc::storage::compacter {
+  using cids_index::maxSize;
+  using cids_index::Row;
+
+  /**
+   * Header of car item with identity cid covering size bytes.
+   * Content of item is ignored by readers, so it can be hole.
+   */
+  inline Bytes paddingHeader(uint64_t size) {
+    // cid v1, raw, identity multihash of one byte
+    const Bytes kIdentityCid{0x01, 0x55, 0x00, 0x01, 0x00};
+    for (size_t length{1};; ++length) {
+      const codec::uvarint::VarintEncoder varint{size - length};
+      if (varint.length == length) {
+        Bytes header;
+        append(header, varint.bytes());
+        append(header, kIdentityCid);
+        return header;
+      }
+    }
+  }
+
+  /** frees disk space of range, keeps file size */
+  inline bool punchHole(int fd, uint64_t offset, uint64_t size) {
+#ifdef __linux__
+    return fallocate(fd,
+                     FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                     gsl::narrow<off_t>(offset),
+                     gsl::narrow<off_t>(size))
+           == 0;
+#else
+    return false;
+#endif
+  }
+
+  /** returns end of car item at offset */
+  inline Outcome<uint64_t> itemEnd(int car_fd, uint64_t offset) {
+    std::array<uint8_t, 10> bytes{};
+    const auto read{pread(car_fd, bytes.data(), bytes.size(), offset)};
+    if (read <= 0) {
+      return ERROR_TEXT("GcMarks.itemEnd: read error");
+    }
+    BytesIn input{bytes.data(), read};
+    uint64_t size{};
+    const auto before{input.size()};
+    if (!codec::uvarint::read(size, input)) {
+      return ERROR_TEXT("GcMarks.itemEnd: decode error");
+    }
+    return offset + (before - input.size()) + size;
+  }
+
+  bool GcMarks::get(const CbCid &key, Bytes *value) const {
+    bool found{false};
+    if (const auto i{snapshot->position(key).value()}) {
+      found = (marked[*i / 64] & (uint64_t{1} << (*i % 64))) != 0;
+    } else {
+      std::shared_lock lock{written_mutex};
+      found = written.count(key) != 0;
+    }
+    if (found && value != nullptr) {
+      return ipld->get(key, value);
+    }
+    return found;
+  }
+
+  void GcMarks::put(const CbCid &key, BytesCow &&value) {
+    mark(key);
+  }
+
+  void GcMarks::mark(const CbCid &key) {
+    const auto i{snapshot->position(key).value()};
+    if (!i) {
+      std::unique_lock lock{written_mutex};
+      written.insert(key);
+      return;
+    }
+    const auto bit{uint64_t{1} << (*i % 64)};
+    if ((marked[*i / 64].fetch_or(bit) & bit) != 0) {
+      return;
+    }
+    const auto &row{snapshot->rows[gsl::narrow<ptrdiff_t>(*i)]};
+    live[row.offset.value() / segment_size] += maxSize(row.max_size64.value());
+    if (sweeping) {
+      std::unique_lock lock{sweep_mutex};
+      relocate(*i).value();
+    }
+  }
+
+  Outcome<void> GcMarks::relocate(size_t i) {
+    const auto &row{snapshot->rows[gsl::narrow<ptrdiff_t>(i)]};
+    if (!reclaimed(row.offset.value()) || relocated[i]) {
+      return outcome::success();
+    }
+    Bytes value;
+    if (!ipld->carGet(row, value)
+        && !cids_index::readCarItem(ipld->car_fd, row, value)) {
+      return ERROR_TEXT("GcMarks.relocate: read error");
+    }
+    ipld->relocate(row.key, value);
+    relocated[i] = true;
+    return outcome::success();
+  }
+
+  bool GcMarks::reclaimed(uint64_t offset) const {
+    auto it{std::upper_bound(reclaim.begin(),
+                             reclaim.end(),
+                             std::make_pair(offset, UINT64_MAX))};
+    return it != reclaim.begin() && offset < std::prev(it)->second;
+  }
+
+  Outcome<uint64_t> GcMarks::sweep(double max_live) {
+    const auto &rows{snapshot->rows};
+    std::vector<uint64_t> total(segments);
+    std::vector<uint64_t> first(segments, UINT64_MAX);
+    std::vector<uint64_t> last(segments);
+    for (const auto &row : rows) {
+      const auto offset{row.offset.value()};
+      const auto segment{offset / segment_size};
+      total[segment] += maxSize(row.max_size64.value());
+      first[segment] = std::min(first[segment], offset);
+      last[segment] = std::max(last[segment], offset);
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    for (size_t segment{0}; segment < segments; ++segment) {
+      if (total[segment] == 0
+          || static_cast<double>(live[segment])
+                 > max_live * static_cast<double>(total[segment])) {
+        continue;
+      }
+      OUTCOME_TRY(end, itemEnd(ipld->car_fd, last[segment]));
+      ranges.emplace_back(first[segment], end);
+    }
+    if (ranges.empty()) {
+      return 0;
+    }
+
+    std::unique_lock sweep_lock{sweep_mutex};
+    relocated.assign(rows.size(), false);
+    reclaim = std::move(ranges);
+    sweep_lock.unlock();
+    for (size_t i{0}; i < rows.size(); ++i) {
+      if ((marked[i / 64] & (uint64_t{1} << (i % 64))) != 0) {
+        sweep_lock.lock();
+        OUTCOME_TRY(relocate(i));
+        sweep_lock.unlock();
+      }
+    }
+    // keys marked until rows are dropped are relocated by mark
+    OUTCOME_TRY(ipld->compactAll(
+        [&](const Row &row) { return !reclaimed(row.offset.value()); }));
+    sweep_lock.lock();
+    sweeping = false;
+    sweep_lock.unlock();
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+    const auto fd{open(ipld->car_path.c_str(), O_WRONLY)};
+    if (fd == -1) {
+      return ERROR_TEXT("GcMarks.sweep: open car failed");
+    }
+    auto BOOST_OUTCOME_TRY_UNIQUE_NAME{gsl::finally([&] { close(fd); })};
+    uint64_t bytes{};
+    for (const auto &[begin, end] : reclaim) {
+      // readers of dropped rows find padding and lookup again
+      const auto header{paddingHeader(end - begin)};
+      if (pwrite(fd, header.data(), header.size(), begin)
+          != static_cast<ssize_t>(header.size())) {
+        return ERROR_TEXT("GcMarks.sweep: write error");
+      }
+      if (punchHole(fd, begin + header.size(), end - begin - header.size())) {
+        bytes += end - begin;
+      }
+    }
+    if (fdatasync(fd) != 0) {
+      return ERROR_TEXT("GcMarks.sweep: sync error");
+    }
+    return bytes;
+  }
+
+  Outcome<std::shared_ptr<GcMarks>> GcMarks::make(
+      std::shared_ptr<CidsIpld> ipld, uint64_t segment_size) {
+    OUTCOME_TRY(ipld->compactAll({}));
+    ipld->carFlush();
+    auto gc{std::make_shared<GcMarks>()};
+    // index file is replaced only under flush_mutex
+    std::unique_lock flush_lock{ipld->flush_mutex};
+    std::ifstream index_file{ipld->index_path, std::ios::binary};
+    OUTCOME_TRY(count, cids_index::checkIndex(index_file));
+    OUTCOME_TRYA(gc->snapshot, MmapIndex::load(ipld->index_path, count));
+    flush_lock.unlock();
+    gc->ipld = ipld;
+    gc->segment_size = segment_size;
+    gc->segments =
+        1 + gc->snapshot->info.max_offset.offset.value() / segment_size;
+    gc->marked = std::make_unique<std::atomic_uint64_t[]>(
+        cids_index::ceilDiv(count, 64));
+    gc->live = std::make_unique<std::atomic_uint64_t[]>(gc->segments);
+    return gc;
+  }
+}  // namespace fc::storage::compacter
@@ -0,0 +1,66 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <set>
+
+#include "storage/ipld/cids_ipld.hpp"
+
+namespace fc::storage::compacter {
+  using cids_index::MmapIndex;
+  using ipld::CidsIpld;
+
+  /**
+   * Incremental garbage collection of car in place.
+   * Reachable keys are marked in bitmap over rows of index snapshot, and live
+   * bytes are estimated for each car segment.
+   * Sweep copies live items of mostly dead segments to the end of car, drops
+   * rows of these segments from index and punches holes in car.
+   * So car is not rewritten, and sweep cost depends on garbage volume.
+   */
+  struct GcMarks : CbIpld {
+    using CbIpld::get, CbIpld::put;
+
+    /** returns whether key is marked */
+    bool get(const CbCid &key, Bytes *value) const override;
+    /** marks key */
+    void put(const CbCid &key, BytesCow &&value) override;
+
+    void mark(const CbCid &key);
+    /** copies item of marked row to end of car, requires sweep_mutex */
+    Outcome<void> relocate(size_t i);
+    bool reclaimed(uint64_t offset) const;
+    /**
+     * Reclaims segments with live bytes not greater than max_live of total.
+     * @return reclaimed bytes
+     */
+    Outcome<uint64_t> sweep(double max_live);
+
+    /** merges index and maps it as snapshot */
+    static Outcome<std::shared_ptr<GcMarks>> make(
+        std::shared_ptr<CidsIpld> ipld, uint64_t segment_size);
+
+    std::shared_ptr<CidsIpld> ipld;
+    /** rows indexed when gc started */
+    std::shared_ptr<MmapIndex> snapshot;
+    uint64_t segment_size{};
+    size_t segments{};
+    /** bit for each snapshot row */
+    std::unique_ptr<std::atomic_uint64_t[]> marked;
+    /** estimated live bytes of each segment */
+    std::unique_ptr<std::atomic_uint64_t[]> live;
+    /** marked keys written after snapshot */
+    mutable std::shared_mutex written_mutex;
+    std::set<CbCid> written;
+    /** keys marked while sweeping are relocated instead of queued */
+    std::atomic_bool sweeping{};
+    std::mutex sweep_mutex;
+    /** sorted car ranges being reclaimed, guarded by sweep_mutex */
+    std::vector<std::pair<uint64_t, uint64_t>> reclaim;
+    std::vector<bool> relocated;
+  };
+}  // namespace fc::storage::compacter
@@ -63,8 +63,11 @@ namespace fc::storage::compacter {
 
   void CompacterQueue::push(const CbCid &key) {
     std::unique_lock lock{mutex};
-    if (_push(key) && !writer.flush()) {
-      _error();
+    if (_push(key)) {
+      if (!writer.flush()) {
+        _error();
+      }
+      cv.notify_all();
     }
   }
 
@@ -76,8 +79,11 @@ namespace fc::storage::compacter {
         any = true;
       }
     }
-    if (any && !writer.flush()) {
-      _error();
+    if (any) {
+      if (!writer.flush()) {
+        _error();
+      }
+      cv.notify_all();
     }
   }
 
@@ -93,8 +99,11 @@ namespace fc::storage::compacter {
         }
       }
     }
-    if (any && !writer.flush()) {
-      _error();
+    if (any) {
+      if (!writer.flush()) {
+        _error();
+      }
+      cv.notify_all();
     }
   }
 
@@ -103,17 +112,34 @@ namespace fc::storage::compacter {
     return stack.empty();
   }
 
-  std::optional<CbCid> CompacterQueue::pop() {
+  std::vector<CbCid> CompacterQueue::popBatch(size_t max) {
     std::unique_lock lock{mutex};
+    std::vector<CbCid> keys;
     while (true) {
-      if (stack.empty()) {
-        return {};
+      while (!stack.empty() && keys.size() < max) {
+        auto key{stack.back()};
+        stack.pop_back();
+        if (!visited->has(key)) {
+          keys.push_back(key);
+        }
+      }
+      if (!keys.empty()) {
+        ++active;
+        return keys;
       }
-      auto key{stack.back()};
-      stack.pop_back();
-      if (!visited->has(key)) {
-        return key;
+      if (active == 0) {
+        return keys;
       }
+      cv.wait(lock);
+    }
+  }
+
+  void CompacterQueue::done() {
+    std::unique_lock lock{mutex};
+    assert(active != 0);
+    --active;
+    if (active == 0) {
+      cv.notify_all();
     }
   }
 }  // namespace fc::storage::compacter
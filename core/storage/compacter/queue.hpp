@@ -5,9 +5,9 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <fstream>
 #include <mutex>
-#include <optional>
 
 #include "cbor_blake/ipld.hpp"
 
@@ -20,12 +20,23 @@ namespace fc::storage::compacter {
     void push(const std::vector<CbCid> &keys);
     void pushChildren(BytesIn input);
     bool empty();
-    std::optional<CbCid> pop();
+    /**
+     * Pops up to max not visited keys and marks caller as active.
+     * Waits while queue is empty and other callers are active, because they
+     * may push children.
+     * Returns empty when all keys were copied.
+     */
+    std::vector<CbCid> popBatch(size_t max);
+    /** marks caller of popBatch as not active */
+    void done();
 
     std::string path;
     CbIpldPtr visited;
 
     std::mutex mutex;
+    std::condition_variable cv;
+    /** number of popBatch callers processing keys */
+    size_t active{};
     std::vector<CbCid> stack;
     std::ofstream writer;
   };
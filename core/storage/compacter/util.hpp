@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <thread>
+
 #include "cbor_blake/ipld_any.hpp"
 #include "storage/compacter/compacter.hpp"
 
@@ -16,9 +18,12 @@ namespace fc::storage::compacter {
     auto compacter{std::make_shared<CompacterIpld>()};
     compacter->path = path;
     compacter->old_ipld = old_ipld;
+    compacter->copy_threads =
+        std::max<size_t>(1, std::thread::hardware_concurrency());
     compacter->ts_mutex = ts_mutex;
     compacter->start_head_key = {"compacter_start_head", kv};
     compacter->headers_top_key = {"compacter_headers_top", kv};
+    compacter->gc_car_key = {"compacter_gc_car", kv};
     compacter->queue = std::make_shared<CompacterQueue>();
     compacter->queue->path = path + ".queue";
     compacter->interpreter = std::make_shared<CompacterInterpreter>();
@@ -26,6 +26,7 @@ OUTCOME_CPP_DEFINE_CATEGORY(fc::storage::hamt, HamtError, e) {
 namespace fc::storage::hamt {
   using codec::cbor::CborEncodeStream;
   using common::which;
+  using ipld::unshare;
 
   inline auto leafFind(Node::Leaf &leaf, BytesIn key) {
     return std::find_if(
@@ -42,10 +43,8 @@ namespace fc::storage::hamt {
   }
 
   CBOR2_ENCODE(Node) {
-    Bits bits;
     auto l_items{CborEncodeStream::list()};
-    for (const auto &[index, value] : v.items) {
-      bit_set(bits, index);
+    for (const auto &value : v.items.values) {
       if (boost::get<Node::Ptr>(&value) != nullptr) {
         outcome::raise(HamtError::kExpectedCID);
       }
@@ -69,21 +68,20 @@ namespace fc::storage::hamt {
         l_items << m_item;
       }
     }
-    return s << (CborEncodeStream::list() << bits << l_items);
+    return s << (CborEncodeStream::list() << v.items.bits << l_items);
   }
 
   CBOR2_DECODE(Node) {
     v.items.clear();
     auto l_node = s.list();
-    Bits bits;
-    l_node >> bits;
+    l_node >> v.items.bits;
     auto n_items = l_node.listLength();
+    if (n_items != v.items.bits.count()) {
+      outcome::raise(HamtError::kInconsistent);
+    }
     auto l_items = l_node.list();
-    size_t j = 0;
+    v.items.values.reserve(n_items);
     for (size_t i = 0; i < n_items; ++i) {
-      while (!bit_test(bits, j)) {
-        ++j;
-      }
       auto _item{l_items};
       l_items.next();
       auto v3{true};
@@ -101,7 +99,7 @@ namespace fc::storage::hamt {
         outcome::raise(HamtError::kInconsistent);
       }
       if (_item.isCid()) {
-        v.items[j] = _item.get<CID>();
+        v.items.values.emplace_back(_item.get<CID>());
       } else {
         auto n_leaf{_item.listLength()};
         auto l_leaf{_item.list()};
@@ -111,15 +109,16 @@ namespace fc::storage::hamt {
           auto key{l_pair.get<Bytes>()};
           leaf.emplace_back(std::move(key), l_pair.raw());
         }
-        v.items[j] = std::move(leaf);
+        v.items.values.emplace_back(std::move(leaf));
       }
-      ++j;
     }
     return s;
   }
 
-  auto consumeIndex(gsl::span<const size_t> indices) {
-    return indices.subspan(1);
+  ipld::NodeCache<Node> &nodeCache() {
+    // estimated, 64k nodes
+    static ipld::NodeCache<Node> cache{size_t{1} << 16};
+    return cache;
   }
 
   Hamt::Hamt(std::shared_ptr<ipfs::IpfsDatastore> store, size_t bit_width)
@@ -139,26 +138,39 @@ namespace fc::storage::hamt {
 
   outcome::result<void> Hamt::set(BytesIn key, BytesCow &&value) {
     OUTCOME_TRY(loadRoot());
-    return set(*boost::get<Node::Ptr>(root_),
+    return set(unshare(boost::get<Node::Ptr>(root_)),
                keyToIndices(key),
                key,
                std::move(value));
   }
 
+  size_t KeyIndices::index() const {
+    constexpr size_t kByteBits{8};
+    size_t index{0};
+    for (auto bit{offset}; bit < offset + bit_width; ++bit) {
+      index <<= 1;
+      index |= 1 & (hash[bit / kByteBits] >> (kByteBits - 1 - bit % kByteBits));
+    }
+    return index;
+  }
+
   outcome::result<Bytes> Hamt::get(BytesIn key) const {
     OUTCOME_TRY(loadRoot());
-    auto node = boost::get<Node::Ptr>(root_);
-    for (auto index : keyToIndices(key)) {
-      auto it = node->items.find(index);
-      if (it == node->items.end()) {
+    auto node{boost::get<Node::Ptr>(root_)};
+    for (auto indices{keyToIndices(key)}; !indices.empty();
+         indices = indices.next()) {
+      const auto *item{node->items.find(indices.index())};
+      if (item == nullptr) {
         return HamtError::kNotFound;
       }
-      auto &item = it->second;
-      OUTCOME_TRY(loadItem(item));
-      if (which<Node::Ptr>(item)) {
-        node = boost::get<Node::Ptr>(item);
+      if (const auto *cid{boost::get<CID>(item)}) {
+        // don't store child in parent, which may be shared by node cache
+        OUTCOME_TRY(child, loadNode(*cid));
+        node = std::move(child);
+      } else if (const auto *child{boost::get<Node::Ptr>(item)}) {
+        node = *child;
       } else {
-        auto &leaf = boost::get<Node::Leaf>(item);
+        const auto &leaf = boost::get<Node::Leaf>(*item);
         auto it{leafFind(leaf, key)};
         if (it == leaf.end()) {
           return HamtError::kNotFound;
@@ -171,7 +183,8 @@ namespace fc::storage::hamt {
 
   outcome::result<void> Hamt::remove(BytesIn key) {
     OUTCOME_TRY(loadRoot());
-    return remove(*boost::get<Node::Ptr>(root_), keyToIndices(key), key);
+    return remove(
+        unshare(boost::get<Node::Ptr>(root_)), keyToIndices(key), key);
   }
 
   outcome::result<bool> Hamt::contains(BytesIn key) const {
@@ -193,49 +206,28 @@ namespace fc::storage::hamt {
     return boost::get<CID>(root_);
   }
 
-  std::vector<size_t> Hamt::keyToIndices(BytesIn key, int n) const {
-    const auto bits{v3() ? bit_width_ : kDefaultBitWidth};
-    std::vector<uint8_t> key_bytes(key.begin(), key.end());
-    auto hash = crypto::sha::sha256(key_bytes);
-    std::vector<size_t> indices;
-    constexpr auto byte_bits = 8;
-    auto max_bits = byte_bits * hash.size();
-    max_bits -= max_bits % bits;
-    int64_t offset = 0;
-    if (n != -1) {
-      offset = gsl::narrow<int64_t>(max_bits - (n - 1) * bits);
-    }
-    while (offset + bits <= max_bits) {
-      size_t index = 0;
-      for (auto i = 0u; i < bits; ++i, ++offset) {
-        index <<= 1;
-        index |= 1
-                 & (gsl::at(hash, offset / byte_bits)
-                    >> (byte_bits - 1 - offset % byte_bits));
-      }
-      indices.push_back(index);
-    }
-    return indices;
+  KeyIndices Hamt::keyToIndices(BytesIn key) const {
+    return {crypto::sha::sha256(key), v3() ? bit_width_ : kDefaultBitWidth};
   }
 
   outcome::result<void> Hamt::set(Node &node,
-                                  gsl::span<const size_t> indices,
+                                  const KeyIndices &indices,
                                   BytesIn key,
                                   BytesCow &&value) {
     if (indices.empty()) {
       return HamtError::kMaxDepth;
     }
-    auto index = indices[0];
-    auto it = node.items.find(index);
-    if (it == node.items.end()) {
+    auto index = indices.index();
+    auto *_item{node.items.find(index)};
+    if (_item == nullptr) {
       node.items[index] = Node::Leaf{{copy(key), copy(value)}};
       return outcome::success();
     }
-    auto &item = it->second;
+    auto &item = *_item;
     OUTCOME_TRY(loadItem(item));
     if (which<Node::Ptr>(item)) {
-      return set(*boost::get<Node::Ptr>(item),
-                 consumeIndex(indices),
+      return set(unshare(boost::get<Node::Ptr>(item)),
+                 indices.next(),
                  key,
                  std::move(value));
     }
@@ -247,10 +239,10 @@ namespace fc::storage::hamt {
     } else {
       auto child = std::make_shared<Node>();
       child->v3 = v3();
-      OUTCOME_TRY(set(*child, consumeIndex(indices), key, std::move(value)));
+      OUTCOME_TRY(set(*child, indices.next(), key, std::move(value)));
       for (auto &pair : leaf) {
-        auto indices2 =
-            keyToIndices(pair.first, gsl::narrow<int>(indices.size()));
+        auto indices2{keyToIndices(pair.first)};
+        indices2.offset = indices.next().offset;
         OUTCOME_TRY(set(*child, indices2, pair.first, std::move(pair.second)));
       }
       item = child;
@@ -259,21 +251,21 @@ namespace fc::storage::hamt {
   }
 
   outcome::result<void> Hamt::remove(Node &node,
-                                     gsl::span<const size_t> indices,
+                                     const KeyIndices &indices,
                                      BytesIn key) {
     if (indices.empty()) {
       return HamtError::kMaxDepth;
     }
-    auto index = indices[0];
-    auto it = node.items.find(index);
-    if (it == node.items.end()) {
+    auto index = indices.index();
+    auto *_item{node.items.find(index)};
+    if (_item == nullptr) {
       return HamtError::kNotFound;
     }
-    auto &item = it->second;
+    auto &item = *_item;
     OUTCOME_TRY(loadItem(item));
     if (which<Node::Ptr>(item)) {
       OUTCOME_TRY(
-          remove(*boost::get<Node::Ptr>(item), consumeIndex(indices), key));
+          remove(unshare(boost::get<Node::Ptr>(item)), indices.next(), key));
       OUTCOME_TRY(cleanShard(item));
     } else {
       auto &leaf = boost::get<Node::Leaf>(item);
@@ -293,17 +285,17 @@ namespace fc::storage::hamt {
   outcome::result<void> Hamt::cleanShard(Node::Item &item) {
     auto &node = *boost::get<Node::Ptr>(item);
     if (node.items.size() == 1) {
-      auto &single_item = node.items.begin()->second;
+      auto &single_item = node.items.values.front();
       if (which<Node::Leaf>(single_item)) {
         item = single_item;
       }
     } else if (node.items.size() <= kLeafMax) {
       Node::Leaf leaf;
-      for (auto &item2 : node.items) {
-        if (!which<Node::Leaf>(item2.second)) {
+      for (auto &item2 : node.items.values) {
+        if (!which<Node::Leaf>(item2)) {
           return outcome::success();
         }
-        for (auto &pair : boost::get<Node::Leaf>(item2.second)) {
+        for (auto &pair : boost::get<Node::Leaf>(item2)) {
           leafInsert(leaf, pair);
           if (leaf.size() > kLeafMax) {
             return outcome::success();
@@ -317,11 +309,14 @@ namespace fc::storage::hamt {
 
   outcome::result<void> Hamt::flush(Node::Item &item) {
     if (which<Node::Ptr>(item)) {
-      auto &node = *boost::get<Node::Ptr>(item);
-      for (auto &item2 : node.items) {
-        OUTCOME_TRY(flush(item2.second));
+      auto node{boost::get<Node::Ptr>(item)};
+      for (auto &item2 : node->items.values) {
+        OUTCOME_TRY(flush(item2));
       }
-      OUTCOME_TRYA(item, fc::setCbor(ipld_, node));
+      OUTCOME_TRY(cid, fc::setCbor(ipld_, *node));
+      // written node is likely to be loaded by next tipset
+      nodeCache().insert(cid, node);
+      item = cid;
     }
     return outcome::success();
   }
@@ -333,33 +328,47 @@ namespace fc::storage::hamt {
 
   outcome::result<void> Hamt::loadItem(Node::Item &item) const {
     if (which<CID>(item)) {
-      OUTCOME_TRY(child, fc::getCbor<Node>(ipld_, boost::get<CID>(item)));
-      if (!child.v3) {
-        child.v3 = v3();
-      } else if (*child.v3 != v3()) {
-        return HamtError::kInconsistent;
-      }
-      item = std::make_shared<Node>(std::move(child));
+      OUTCOME_TRY(child, loadNode(boost::get<CID>(item)));
+      item = std::move(child);
     }
     return outcome::success();
   }
 
+  outcome::result<Node::Ptr> Hamt::loadNode(const CID &cid) const {
+    OUTCOME_TRY(child, nodeCache().load(ipld_, cid));
+    if (!child->v3) {
+      // node without items depends on version
+      child = std::make_shared<Node>(*child);
+      child->v3 = v3();
+      child->cached = false;
+    } else if (*child->v3 != v3()) {
+      return HamtError::kInconsistent;
+    }
+    return child;
+  }
+
   outcome::result<void> Hamt::visit(const Visitor &visitor) const {
-    lazyCreateRoot();
+    OUTCOME_TRY(loadRoot());
     return visit(root_, visitor);
   }
 
-  outcome::result<void> Hamt::visit(Node::Item &item,
+  outcome::result<void> Hamt::visit(const Node::Item &item,
                                     const Visitor &visitor) const {
-    OUTCOME_TRY(loadItem(item));
-    if (which<Node::Ptr>(item)) {
-      for (auto &item2 : boost::get<Node::Ptr>(item)->items) {
-        OUTCOME_TRY(visit(item2.second, visitor));
-      }
+    Node::Ptr node;
+    if (const auto *cid{boost::get<CID>(&item)}) {
+      // don't store child in parent, which may be shared by node cache
+      OUTCOME_TRY(child, loadNode(*cid));
+      node = std::move(child);
+    } else if (const auto *child{boost::get<Node::Ptr>(&item)}) {
+      node = *child;
     } else {
-      for (auto &pair : boost::get<Node::Leaf>(item)) {
+      for (const auto &pair : boost::get<Node::Leaf>(item)) {
         OUTCOME_TRY(visitor(pair.first, pair.second));
       }
+      return outcome::success();
+    }
+    for (const auto &item2 : node->items.values) {
+      OUTCOME_TRY(visit(item2, visitor));
     }
     return outcome::success();
   }
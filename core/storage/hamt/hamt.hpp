@@ -5,7 +5,6 @@
 
 #pragma once
 
-#include <boost/multiprecision/cpp_int.hpp>
 #include <boost/variant.hpp>
 
 #include "codec/cbor/cbor_codec.hpp"
@@ -13,8 +12,10 @@
 #include "common/outcome.hpp"
 #include "common/span.hpp"
 #include "common/visitor.hpp"
+#include "crypto/sha/sha256.hpp"
 #include "primitives/cid/cid.hpp"
 #include "storage/ipfs/datastore.hpp"
+#include "storage/ipld/node_cache.hpp"
 
 namespace fc::storage::hamt {
   enum class HamtError {
@@ -28,17 +29,49 @@ namespace fc::storage::hamt {
 OUTCOME_HPP_DECLARE_ERROR(fc::storage::hamt, HamtError);
 
 namespace fc::storage::hamt {
-  using boost::multiprecision::cpp_int;
-
   constexpr size_t kLeafMax = 3;
   constexpr size_t kDefaultBitWidth = 5;
+  constexpr size_t kMaxBitWidth = 8;
+
+  /** Node bitfield, encoded as big-endian integer */
+  struct Bits {
+    static constexpr size_t kWords{(size_t{1} << kMaxBitWidth) / 64};
+
+    bool test(size_t i) const {
+      return ((words[i / 64] >> (i % 64)) & 1) != 0;
+    }
+    void set(size_t i) {
+      words[i / 64] |= uint64_t{1} << (i % 64);
+    }
+    void reset(size_t i) {
+      words[i / 64] &= ~(uint64_t{1} << (i % 64));
+    }
+    /** number of set bits before i */
+    size_t rank(size_t i) const {
+      size_t n{};
+      for (size_t w{0}; w < i / 64; ++w) {
+        n += __builtin_popcountll(words[w]);
+      }
+      if (i % 64 != 0) {
+        n += __builtin_popcountll(words[i / 64]
+                                  & ((uint64_t{1} << (i % 64)) - 1));
+      }
+      return n;
+    }
+    size_t count() const {
+      return rank(kWords * 64);
+    }
 
-  struct Bits : cpp_int {};
+    std::array<uint64_t, kWords> words{};
+  };
 
   CBOR_ENCODE(Bits, bits) {
     std::vector<uint8_t> bytes;
-    if (bits != 0) {
-      export_bits(bits, std::back_inserter(bytes), 8);
+    for (size_t i{Bits::kWords * 8}; i-- != 0;) {
+      const auto byte{static_cast<uint8_t>(bits.words[i / 8] >> (8 * (i % 8)))};
+      if (byte != 0 || !bytes.empty()) {
+        bytes.push_back(byte);
+      }
     }
     return s << bytes;
   }
@@ -46,10 +79,16 @@ namespace fc::storage::hamt {
   CBOR_DECODE(Bits, bits) {
     std::vector<uint8_t> bytes;
     s >> bytes;
-    if (bytes.empty()) {
-      bits = {0};
-    } else {
-      import_bits(bits, bytes.begin(), bytes.end());
+    while (!bytes.empty() && bytes.front() == 0) {
+      bytes.erase(bytes.begin());
+    }
+    if (bytes.size() > Bits::kWords * 8) {
+      outcome::raise(HamtError::kInconsistent);
+    }
+    bits = {};
+    for (size_t i{0}; i < bytes.size(); ++i) {
+      bits.words[i / 8] |= uint64_t{bytes[bytes.size() - 1 - i]}
+                           << (8 * (i % 8));
     }
     return s;
   }
@@ -60,11 +99,71 @@ namespace fc::storage::hamt {
     using Leaf = std::vector<std::pair<Bytes, Bytes>>;
     using Item = boost::variant<CID, Ptr, Leaf>;
 
-    std::map<size_t, Item> items;
+    /** Items of set bits ordered by index, found by popcount */
+    struct Items {
+      size_t size() const {
+        return values.size();
+      }
+      bool empty() const {
+        return values.empty();
+      }
+      Item *find(size_t index) {
+        return bits.test(index) ? &values[bits.rank(index)] : nullptr;
+      }
+      const Item *find(size_t index) const {
+        return bits.test(index) ? &values[bits.rank(index)] : nullptr;
+      }
+      Item &operator[](size_t index) {
+        const auto i{bits.rank(index)};
+        if (!bits.test(index)) {
+          bits.set(index);
+          values.emplace(values.begin() + gsl::narrow<ptrdiff_t>(i));
+        }
+        return values[i];
+      }
+      void erase(size_t index) {
+        if (bits.test(index)) {
+          values.erase(values.begin()
+                       + gsl::narrow<ptrdiff_t>(bits.rank(index)));
+          bits.reset(index);
+        }
+      }
+      void clear() {
+        bits = {};
+        values.clear();
+      }
+
+      Bits bits;
+      std::vector<Item> values;
+    };
+
+    Items items;
     boost::optional<bool> v3;
+    /** shared by node cache, copied before modification */
+    bool cached{};
   };
   CBOR2_DECODE_ENCODE(Node)
 
+  /** decoded nodes shared by all hamts */
+  ipld::NodeCache<Node> &nodeCache();
+
+  /** Indices of key hash bits for each level */
+  struct KeyIndices {
+    bool empty() const {
+      return offset + bit_width > hash.size() * 8;
+    }
+    size_t index() const;
+    KeyIndices next() const {
+      auto next{*this};
+      next.offset += bit_width;
+      return next;
+    }
+
+    crypto::sha::Hash256 hash;
+    size_t bit_width{};
+    size_t offset{};
+  };
+
   // TODO(turuslan): v3 caching
   /**
    * Hamt map
@@ -150,18 +249,20 @@ namespace fc::storage::hamt {
     }
 
    private:
-    std::vector<size_t> keyToIndices(BytesIn key, int n = -1) const;
+    KeyIndices keyToIndices(BytesIn key) const;
     outcome::result<void> set(Node &node,
-                              gsl::span<const size_t> indices,
+                              const KeyIndices &indices,
                               BytesIn key,
                               BytesCow &&value);
     outcome::result<void> remove(Node &node,
-                                 gsl::span<const size_t> indices,
+                                 const KeyIndices &indices,
                                  BytesIn key);
     static outcome::result<void> cleanShard(Node::Item &item);
     outcome::result<void> flush(Node::Item &item);
     outcome::result<void> loadItem(Node::Item &item) const;
-    outcome::result<void> visit(Node::Item &item, const Visitor &visitor) const;
+    outcome::result<Node::Ptr> loadNode(const CID &cid) const;
+    outcome::result<void> visit(const Node::Item &item,
+                                const Visitor &visitor) const;
 
     void lazyCreateRoot() const;
     bool v3() const;
@@ -34,12 +34,35 @@ namespace fc::storage::ipfs {
      */
     virtual outcome::result<void> set(const CID &key, BytesCow &&value) = 0;
 
+    /**
+     * @brief associates keys with values, may be faster than separate set
+     * @param items keys and values to associate
+     * @return success if operation succeeded, error otherwise
+     */
+    virtual outcome::result<void> setMany(
+        std::vector<std::pair<CID, BytesCow>> &&items) {
+      for (auto &[key, value] : items) {
+        OUTCOME_TRY(set(key, std::move(value)));
+      }
+      return outcome::success();
+    }
+
     /**
      * @brief searches for a key in data store
      * @param key key to find
      * @return value associated with key or error
      */
     virtual outcome::result<Value> get(const CID &key) const = 0;
+
+    /**
+     * @brief searches for a key in data store
+     * @param key key to find
+     * @return shared immutable value, cached values are not copied
+     */
+    virtual outcome::result<SharedBytes> getShared(const CID &key) const {
+      OUTCOME_TRY(value, get(key));
+      return std::make_shared<const Bytes>(std::move(value));
+    }
   };
 }  // namespace fc::storage::ipfs
 
@@ -0,0 +1,107 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "storage/ipld/block_cache.hpp"
+
+namespace fc::storage::ipld {
+  CachedCbIpld::CachedCbIpld(CbIpldPtr ipld, size_t max_bytes)
+      : ipld{std::move(ipld)}, max_shard_bytes{max_bytes / kShards} {}
+
+  bool CachedCbIpld::get(const CbCid &key, Bytes *value) const {
+    if (value == nullptr) {
+      // cache may outlive blocks removed by compacter
+      return ipld->has(key);
+    }
+    if (auto shared{getShared(key)}) {
+      *value = *shared;
+      return true;
+    }
+    return false;
+  }
+
+  void CachedCbIpld::put(const CbCid &key, BytesCow &&value) {
+    ipld->put(key, std::move(value));
+  }
+
+  void CachedCbIpld::putMany(
+      gsl::span<const std::pair<CbCid, BytesIn>> items) {
+    ipld->putMany(items);
+  }
+
+  SharedBytes CachedCbIpld::getShared(const CbCid &key) const {
+    auto &shard{this->shard(key)};
+    {
+      std::unique_lock lock{shard.mutex};
+      if (const auto it{shard.slots.find(key)}; it != shard.slots.end()) {
+        auto &entry{shard.entries[it->second]};
+        entry.referenced = true;
+        ++hits;
+        return entry.value;
+      }
+    }
+    ++misses;
+    auto value{ipld->getShared(key)};
+    if (value && value->size() <= kMaxBlock) {
+      std::unique_lock lock{shard.mutex};
+      insert(shard, key, value);
+    }
+    return value;
+  }
+
+  size_t CachedCbIpld::bytes() const {
+    size_t bytes{};
+    for (auto &shard : shards) {
+      std::unique_lock lock{shard.mutex};
+      bytes += shard.bytes;
+    }
+    return bytes;
+  }
+
+  double CachedCbIpld::hitRate() const {
+    const auto _hits{hits.load()};
+    const auto total{_hits + misses.load()};
+    return total == 0 ? 0 : static_cast<double>(_hits) / total;
+  }
+
+  CachedCbIpld::Shard &CachedCbIpld::shard(const CbCid &key) const {
+    return shards[key[0] % kShards];
+  }
+
+  void CachedCbIpld::insert(Shard &shard,
+                            const CbCid &key,
+                            const SharedBytes &value) const {
+    if (shard.slots.count(key) != 0) {
+      // inserted by concurrent miss
+      return;
+    }
+    shard.bytes += value->size();
+    // evict unreferenced entries, referenced get second chance
+    while (shard.bytes > max_shard_bytes && !shard.entries.empty()) {
+      if (shard.hand >= shard.entries.size()) {
+        shard.hand = 0;
+      }
+      auto &entry{shard.entries[shard.hand]};
+      if (entry.referenced) {
+        entry.referenced = false;
+        ++shard.hand;
+        continue;
+      }
+      shard.bytes -= entry.value->size();
+      shard.slots.erase(entry.key);
+      if (shard.hand + 1 != shard.entries.size()) {
+        entry = std::move(shard.entries.back());
+        shard.slots[entry.key] = shard.hand;
+      }
+      shard.entries.pop_back();
+    }
+    if (shard.bytes > max_shard_bytes) {
+      // block bigger than shard
+      shard.bytes -= value->size();
+      return;
+    }
+    shard.slots.emplace(key, shard.entries.size());
+    shard.entries.push_back(Entry{key, value, false});
+  }
+}  // namespace fc::storage::ipld
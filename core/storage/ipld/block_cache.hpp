@@ -0,0 +1,65 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "cbor_blake/ipld.hpp"
+
+namespace fc::storage::ipld {
+  /**
+   * Shared cache of immutable blocks read from inner ipld.
+   * Keys are split between shards with separate locks.
+   * Each shard evicts with CLOCK (second chance) policy, so hits only set
+   * flag and don't reorder entries.
+   * getShared returns cached value without copy.
+   */
+  struct CachedCbIpld : CbIpld {
+    using CbIpld::get, CbIpld::put;
+
+    static constexpr size_t kShards{16};
+    /** bigger blocks are not cached */
+    static constexpr size_t kMaxBlock{1 << 20};
+
+    CachedCbIpld(CbIpldPtr ipld, size_t max_bytes);
+
+    bool get(const CbCid &key, Bytes *value) const override;
+    void put(const CbCid &key, BytesCow &&value) override;
+    void putMany(gsl::span<const std::pair<CbCid, BytesIn>> items) override;
+    SharedBytes getShared(const CbCid &key) const override;
+
+    /** cached bytes */
+    size_t bytes() const;
+    double hitRate() const;
+
+    struct Entry {
+      CbCid key;
+      SharedBytes value;
+      bool referenced{};
+    };
+    struct Shard {
+      std::mutex mutex;
+      std::unordered_map<CbCid, size_t> slots;
+      std::vector<Entry> entries;
+      size_t hand{};
+      size_t bytes{};
+    };
+
+    CbIpldPtr ipld;
+    size_t max_shard_bytes{};
+    mutable std::array<Shard, kShards> shards;
+    mutable std::atomic_size_t hits{};
+    mutable std::atomic_size_t misses{};
+
+   private:
+    Shard &shard(const CbCid &key) const;
+    void insert(Shard &shard, const CbCid &key, const SharedBytes &value) const;
+  };
+}  // namespace fc::storage::ipld
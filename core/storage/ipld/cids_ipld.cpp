@@ -5,6 +5,8 @@
 
 #include "storage/ipld/cids_ipld.hpp"
 
+#include <fcntl.h>
+#include <unistd.h>
 #include <boost/asio/io_context.hpp>
 #include <boost/filesystem/operations.hpp>
 
@@ -20,15 +22,49 @@ namespace fc::storage::ipld {
   using cids_index::maxSize64;
   using cids_index::MergeRange;
 
-  boost::optional<Row> CidsIpld::findWritten(const CbCid &key) const {
-    assert(writable != nullptr);
-    auto it{written.lower_bound(Row{key, {}, {}})};
-    if (it != written.end() && it->key == key) {
-      return *it;
+  /** appends car item of block, returns item size */
+  inline size_t encodeCarItem(Bytes &out, const CbCid &key, BytesIn value) {
+    const auto begin{out.size()};
+    codec::uvarint::VarintEncoder varint{kCborBlakePrefix.size() + CbCid::size()
+                                         + value.size()};
+    out.reserve(begin + varint.length + varint.value);
+    append(out, varint.bytes());
+    append(out, kCborBlakePrefix);
+    append(out, key);
+    append(out, value);
+    return out.size() - begin;
+  }
+
+  CidsIpld::~CidsIpld() {
+    if (writable != nullptr) {
+      // keys of runs and written rows are inserted again on load
+      std::ignore = saveBloom();
+    }
+    if (car_fd != -1) {
+      close(car_fd);
+    }
+  }
+
+  boost::optional<Row> CidsIpld::findIndex(const CbCid &key) const {
+    if (auto row{index->find(key).value()}) {
+      return row;
+    }
+    for (auto it{runs.rbegin()}; it != runs.rend(); ++it) {
+      if (auto row{it->index->find(key).value()}) {
+        return row;
+      }
     }
     return boost::none;
   }
 
+  size_t CidsIpld::indexSize() const {
+    auto size{index->size()};
+    for (const auto &run : runs) {
+      size += run.index->size();
+    }
+    return size;
+  }
+
   outcome::result<bool> CidsIpld::contains(const CID &cid) const {
     if (auto key{asBlake(cid)}) {
       if (has(*key)) {
@@ -71,32 +107,162 @@ namespace fc::storage::ipld {
     return ipfs::IpfsDatastoreError::kNotFound;
   }
 
+  std::string CidsIpld::runPath(const std::string &index_path,
+                                uint64_t max_offset) {
+    return fmt::format("{}.run.{}", index_path, max_offset);
+  }
+
+  std::vector<std::string> CidsIpld::listRuns(const std::string &index_path) {
+    std::vector<std::string> paths;
+    const boost::filesystem::path path{index_path};
+    const auto prefix{path.filename().string() + ".run."};
+    boost::system::error_code ec;
+    for (boost::filesystem::directory_iterator it{path.parent_path(), ec}, end;
+         it != end;
+         it.increment(ec)) {
+      const auto name{it->path().filename().string()};
+      if (name.size() > prefix.size() && name.rfind(prefix, 0) == 0
+          && name.find_first_not_of("0123456789", prefix.size())
+                 == std::string::npos) {
+        paths.push_back(it->path().string());
+      }
+    }
+    return paths;
+  }
+
+  Outcome<CidsRun> CidsIpld::writeRun(const std::string &path,
+                                      std::vector<MergeRange> &&ranges) const {
+    const auto tmp_path{path + ".tmp"};
+    {
+      std::ofstream out{tmp_path, std::ios::binary};
+      OUTCOME_TRY(merge(out, std::move(ranges)));
+    }
+    boost::system::error_code ec;
+    boost::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+      return ec;
+    }
+    OUTCOME_TRY(run_index, cids_index::loadMapped(path));
+    return CidsRun{path, run_index};
+  }
+
   Outcome<void> CidsIpld::doFlush() {
     std::unique_lock flush_lock{flush_mutex};
     std::shared_lock written_slock{written_mutex};
-    uint64_t max_offset{};
-    std::vector<Row> rows;
-    rows.reserve(written.size());
-    for (const auto &row : written) {
-      max_offset = std::max(max_offset, row.offset.value());
-      rows.push_back(row);
-    }
+    auto rows{written.sorted()};
     written_slock.unlock();
-    std::sort(rows.begin(), rows.end());
 
-    std::ifstream index_in{index_path, std::ios::binary};
+    if (!rows.empty()) {
+      uint64_t max_offset{};
+      for (const auto &row : rows) {
+        max_offset = std::max(max_offset, row.offset.value());
+      }
+      std::vector<MergeRange> ranges;
+      auto &range{ranges.emplace_back()};
+      range.current = 0;
+      range.rows = std::move(rows);
+      OUTCOME_TRY(run,
+                  writeRun(runPath(index_path, max_offset), std::move(ranges)));
+      std::unique_lock index_lock{index_mutex};
+      runs.push_back(run);
+      index_lock.unlock();
+
+      // get checks written before index, so rows are removed after adding run
+      std::unique_lock written_ulock{written_mutex};
+      written.eraseUntil(max_offset);
+      written_ulock.unlock();
+    }
+
+    OUTCOME_TRY(compactRuns());
+    OUTCOME_TRY(rebuildBloom());
+
+    flushing.clear();
+
+    return outcome::success();
+  }
+
+  Outcome<void> CidsIpld::compactRuns() {
+    // runs are changed only by flush, so they are read without lock
+    auto tier{[&](size_t size) {
+      size_t tier{0};
+      for (auto max{std::max<size_t>(flush_on, 1) * kRunsPerTier}; size >= max;
+           max *= kRunsPerTier) {
+        ++tier;
+      }
+      return tier;
+    }};
+    while (true) {
+      std::map<size_t, std::vector<size_t>> tiers;
+      for (size_t i{0}; i < runs.size(); ++i) {
+        tiers[tier(runs[i].index->size())].push_back(i);
+      }
+      const auto it{std::find_if(tiers.begin(), tiers.end(), [](auto &tier) {
+        return tier.second.size() >= kRunsPerTier;
+      })};
+      if (it == tiers.end()) {
+        break;
+      }
+      const auto &merged{it->second};
+      uint64_t max_offset{};
+      std::vector<std::ifstream> files(merged.size());
+      std::vector<MergeRange> ranges;
+      for (size_t i{0}; i < merged.size(); ++i) {
+        const auto &run{runs[merged[i]]};
+        max_offset =
+            std::max(max_offset, run.index->info.max_offset.offset.value());
+        files[i].open(run.path, std::ios::binary);
+        auto &range{ranges.emplace_back()};
+        range.file = &files[i];
+        range.begin = 1;
+        range.end = 1 + run.index->size();
+      }
+      // replaces file of newest merged run
+      OUTCOME_TRY(run,
+                  writeRun(runPath(index_path, max_offset), std::move(ranges)));
+      std::vector<CidsRun> removed;
+      std::unique_lock index_lock{index_mutex};
+      for (auto i{merged.rbegin()}; i != merged.rend(); ++i) {
+        removed.push_back(std::move(runs[*i]));
+        runs.erase(runs.begin() + gsl::narrow<ptrdiff_t>(*i));
+      }
+      runs.push_back(run);
+      index_lock.unlock();
+      for (const auto &old : removed) {
+        if (old.path != run.path) {
+          boost::system::error_code ec;
+          boost::filesystem::remove(old.path, ec);
+        }
+      }
+    }
+
+    size_t runs_size{};
+    for (const auto &run : runs) {
+      runs_size += run.index->size();
+    }
+    if (runs.empty() || runs_size < index->size()) {
+      return outcome::success();
+    }
+    OUTCOME_TRY(mergeIndex({}));
+    return saveBloom();
+  }
+
+  Outcome<void> CidsIpld::mergeIndex(const cids_index::MergeFilter &keep) {
+    std::vector<std::ifstream> files(runs.size() + 1);
     std::vector<MergeRange> ranges;
-    auto &range1{ranges.emplace_back()};
-    range1.begin = 1;
-    range1.end = 1 + index->size();
-    range1.file = &index_in;
-    auto &range2{ranges.emplace_back()};
-    range2.current = 0;
-    range2.rows = std::move(rows);
+    for (size_t i{0}; i < files.size(); ++i) {
+      const auto &path{i == 0 ? index_path : runs[i - 1].path};
+      const auto size{i == 0 ? index->size() : runs[i - 1].index->size()};
+      files[i].open(path, std::ios::binary);
+      auto &range{ranges.emplace_back()};
+      range.file = &files[i];
+      range.begin = 1;
+      range.end = 1 + size;
+    }
     auto tmp_path{index_path + ".tmp"};
-    std::ofstream index_out{tmp_path, std::ios::binary};
-    OUTCOME_TRY(merge(index_out, std::move(ranges)));
-
+    {
+      std::ofstream index_out{tmp_path, std::ios::binary};
+      OUTCOME_TRY(merge(index_out, std::move(ranges), keep));
+    }
     OUTCOME_TRY(new_index, cids_index::load(tmp_path, max_memory));
     std::unique_lock index_lock{index_mutex};
     boost::system::error_code ec;
@@ -105,35 +271,93 @@ namespace fc::storage::ipld {
       return ec;
     }
     index = new_index;
+    auto removed{std::move(runs)};
+    runs.clear();
     index_lock.unlock();
-
-    std::unique_lock written_ulock{written_mutex};
-    for (auto it{written.begin()}; it != written.end();) {
-      if (it->offset.value() > max_offset) {
-        ++it;
-      } else {
-        it = written.erase(it);
-      }
+    for (const auto &run : removed) {
+      boost::filesystem::remove(run.path, ec);
     }
-    written_ulock.unlock();
+    return outcome::success();
+  }
 
-    flushing.clear();
+  Outcome<void> CidsIpld::compactAll(const cids_index::MergeFilter &keep) {
+    OUTCOME_TRY(doFlush());
+    std::unique_lock flush_lock{flush_mutex};
+    OUTCOME_TRY(mergeIndex(keep));
+    // dropped keys are removed from bloom
+    OUTCOME_TRY(rebuildBloom(keep != nullptr));
+    return saveBloom();
+  }
 
+  Outcome<void> CidsIpld::rebuildBloom(bool force) {
+    if (!bloom) {
+      return outcome::success();
+    }
+    if (!force && bloom->count <= bloom->capacity) {
+      return outcome::success();
+    }
+    std::shared_lock written_slock{written_mutex};
+    const auto written_size{written.size()};
+    written_slock.unlock();
+    // reserve for keys written until next build
+    auto new_bloom{
+        std::make_shared<Bloom>((indexSize() + written_size) * 2)};
+    OUTCOME_TRY(new_bloom->insertIndex(index_path));
+    for (const auto &run : runs) {
+      OUTCOME_TRY(new_bloom->insertIndex(run.path));
+    }
+    std::unique_lock index_lock{index_mutex};
+    // keys written after flush
+    written_slock.lock();
+    written.forEach([&](const Row &row) { new_bloom->insert(row.key); });
+    bloom = new_bloom;
+    written_slock.unlock();
+    index_lock.unlock();
     return outcome::success();
   }
 
+  Outcome<void> CidsIpld::saveBloom() const {
+    std::shared_lock index_lock{index_mutex};
+    if (!bloom || !index) {
+      return outcome::success();
+    }
+    return bloom->save(index_path + ".bloom", *index);
+  }
+
+  double CidsIpld::bloomFalsePositiveRate() const {
+    const double false_positives = bloom_false_positives;
+    const double total =
+        false_positives + static_cast<double>(bloom_negatives);
+    return total == 0 ? 0 : false_positives / total;
+  }
+
   bool CidsIpld::get(const CbCid &key, Bytes *value) const {
     if (value != nullptr) {
       value->resize(0);
     }
     std::shared_lock index_lock{index_mutex};
-    auto row{index->find(key).value()};
+    const auto maybe{!bloom || bloom->has(key)};
+    const auto has_bloom{bloom != nullptr};
     index_lock.unlock();
-    if (!row && writable != nullptr) {
-      std::shared_lock written_lock{written_mutex};
-      row = findWritten(key);
+    boost::optional<Row> row;
+    if (maybe) {
+      // flush adds run before removing rows from written
+      if (writable != nullptr) {
+        std::shared_lock written_lock{written_mutex};
+        row = written.find(key);
+      }
+      if (!row) {
+        index_lock.lock();
+        row = findIndex(key);
+        index_lock.unlock();
+      }
+    } else {
+      ++bloom_negatives;
     }
     if (!row) {
+      if (maybe && has_bloom) {
+        ++bloom_false_positives;
+      }
       if (ipld) {
         return AnyAsCbIpld::get(ipld, key, value);
       }
@@ -143,16 +367,28 @@ namespace fc::storage::ipld {
       if (carGet(*row, *value)) {
         return true;
       }
-      std::unique_lock car_lock{car_mutex};
-      auto [good, size]{readCarItem(car_file, *row, nullptr)};
-      if (!good) {
-        spdlog::error("CidsIpld.get inconsistent");
-        outcome::raise(ERROR_TEXT("CidsIpld.get: inconsistent"));
-      }
-      value->resize(size);
-      if (!common::read(car_file, *value)) {
-        spdlog::error("CidsIpld.get read error");
-        outcome::raise(ERROR_TEXT("CidsIpld.get: read error"));
+      if (!readCarItem(car_fd, *row, *value)) {
+        // row may be dropped or relocated by gc after lookup
+        const auto old_offset{row->offset.value()};
+        if (writable != nullptr) {
+          std::shared_lock written_lock{written_mutex};
+          row = written.find(key);
+        }
+        if (!row) {
+          index_lock.lock();
+          row = findIndex(key);
+          index_lock.unlock();
+        }
+        if (!row) {
+          value->resize(0);
+          return false;
+        }
+        if (row->offset.value() == old_offset
+            || (!carGet(*row, *value)
+                && !readCarItem(car_fd, *row, *value))) {
+          spdlog::error("CidsIpld.get inconsistent");
+          outcome::raise(ERROR_TEXT("CidsIpld.get: inconsistent"));
+        }
       }
     }
     return true;
@@ -166,18 +402,93 @@ namespace fc::storage::ipld {
       return;
     }
     std::unique_lock written_lock{written_mutex};
-    if (findWritten(key)) {
+    if (written.find(key)) {
+      return;
+    }
+    appendItem(key, value, written_lock);
+  }
+
+  void CidsIpld::putMany(gsl::span<const std::pair<CbCid, BytesIn>> items) {
+    if (writable == nullptr) {
+      outcome::raise(ERROR_TEXT("CidsIpld.putMany: not writable"));
+    }
+    // same lookup order as get, flush adds run before removing written rows
+    std::vector<bool> present(items.size());
+    std::shared_lock written_slock{written_mutex};
+    for (size_t i{0}; i < items.size(); ++i) {
+      present[i] = written.find(items[i].first).has_value();
+    }
+    written_slock.unlock();
+    std::shared_lock index_lock{index_mutex};
+    for (size_t i{0}; i < items.size(); ++i) {
+      const auto &key{items[i].first};
+      if (!present[i]) {
+        present[i] = (!bloom || bloom->has(key)) && findIndex(key);
+      }
+    }
+    index_lock.unlock();
+    size_t reserve{0};
+    for (size_t i{0}; i < items.size(); ++i) {
+      const auto &[key, value]{items[i]};
+      if (!present[i] && ipld) {
+        present[i] = AnyAsCbIpld::get(ipld, key, nullptr);
+      }
+      if (!present[i]) {
+        reserve += kCborBlakePrefix.size() + CbCid::size() + value.size() + 10;
+      }
+    }
+    if (reserve == 0) {
       return;
     }
 
+    std::unique_lock written_lock{written_mutex};
+    std::unique_lock car_lock{car_flush_mutex};
+    car_queue_buffer.reserve(car_queue_buffer.size() + reserve);
+    for (size_t i{0}; i < items.size(); ++i) {
+      const auto &[key, value]{items[i]};
+      // duplicates in batch and concurrent puts are in written
+      if (present[i] || written.find(key)) {
+        continue;
+      }
+      const auto buffer_offset{car_queue_buffer.size()};
+      const auto size{encodeCarItem(car_queue_buffer, key, value)};
+      Row row;
+      row.key = key;
+      row.offset = car_offset;
+      row.max_size64 = maxSize64(size);
+      car_queue.emplace(car_offset, buffer_offset);
+      car_offset += size;
+      // bloom is replaced under written_mutex too
+      if (bloom) {
+        bloom->insert(key);
+      }
+      written.insert(row);
+    }
+    // whole batch is written with one call
+    if (car_queue.size() >= car_flush_on) {
+      carFlush(std::adopt_lock);
+    }
+    car_lock.unlock();
+    const auto flush{flush_on != 0 && written.size() >= flush_on};
+    written_lock.unlock();
+    if (flush) {
+      asyncFlush();
+    }
+  }
+
+  void CidsIpld::relocate(const CbCid &key, BytesIn value) {
+    if (writable == nullptr) {
+      outcome::raise(ERROR_TEXT("CidsIpld.relocate: not writable"));
+    }
+    std::unique_lock written_lock{written_mutex};
+    appendItem(key, value, written_lock);
+  }
+
+  void CidsIpld::appendItem(const CbCid &key,
+                            BytesIn value,
+                            std::unique_lock<std::shared_mutex> &written_lock) {
     Bytes item;
-    codec::uvarint::VarintEncoder varint{kCborBlakePrefix.size() + CbCid::size()
-                                         + value.size()};
-    item.reserve(varint.length + varint.value);
-    append(item, varint.bytes());
-    append(item, kCborBlakePrefix);
-    append(item, key);
-    append(item, value);
+    encodeCarItem(item, key, value);
 
     Row row;
     row.key = key;
@@ -185,6 +496,10 @@ namespace fc::storage::ipld {
     row.max_size64 = maxSize64(item.size());
     car_offset += item.size();
     carPut(row, std::move(item));
+    // bloom is replaced under written_mutex too
+    if (bloom) {
+      bloom->insert(key);
+    }
     written.insert(row);
     if (flush_on != 0 && written.size() >= flush_on) {
       written_lock.unlock();
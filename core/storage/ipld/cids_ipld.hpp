@@ -12,17 +12,29 @@
 #include "cbor_blake/ipld.hpp"
 #include "common/outcome2.hpp"
 #include "primitives/cid/cid.hpp"
+#include "storage/car/cids_index/bloom.hpp"
 #include "storage/car/cids_index/cids_index.hpp"
+#include "storage/car/cids_index/memtable.hpp"
 #include "storage/ipfs/datastore.hpp"
 
 namespace fc::storage::ipld {
+  using cids_index::Bloom;
   using cids_index::Index;
+  using cids_index::Memtable;
   using cids_index::Row;
 
+  /** immutable sorted index file of flushed rows */
+  struct CidsRun {
+    std::string path;
+    std::shared_ptr<Index> index;
+  };
+
   struct CidsIpld : CbIpld,
                     public Ipld,
                     public std::enable_shared_from_this<CidsIpld> {
-    using CbIpld::get, CbIpld::put;
+    using CbIpld::get, CbIpld::put, CbIpld::getShared, Ipld::getShared;
+
+    ~CidsIpld() override;
 
     outcome::result<bool> contains(const CID &cid) const override;
     outcome::result<void> set(const CID &cid, BytesCow &&value) override;
@@ -30,6 +42,16 @@ namespace fc::storage::ipld {
 
     bool get(const CbCid &key, Bytes *value) const override;
     void put(const CbCid &key, BytesCow &&value) override;
+    /**
+     * Looks up whole batch with one pass over written rows and index,
+     * then appends missing blocks at consecutive car offsets under one lock.
+     */
+    void putMany(gsl::span<const std::pair<CbCid, BytesIn>> items) override;
+    /** appends item even if key is indexed, new row shadows old one */
+    void relocate(const CbCid &key, BytesIn value);
+    void appendItem(const CbCid &key,
+                    BytesIn value,
+                    std::unique_lock<std::shared_mutex> &written_lock);
 
     void carPut(const Row &row, Bytes &&item);
     bool carGet(const Row &row, Bytes &value) const;
@@ -38,17 +60,66 @@ namespace fc::storage::ipld {
 
     void asyncFlush();
 
-    inline boost::optional<Row> findWritten(const CbCid &key) const;
+    /** finds row in index and runs, requires index_mutex */
+    boost::optional<Row> findIndex(const CbCid &key) const;
+    /** rows in index and runs, requires index_mutex */
+    size_t indexSize() const;
+    /**
+     * Writes written rows as new run, then compacts runs.
+     * Flush cost doesn't depend on index size.
+     */
     Outcome<void> doFlush();
+    /** merges ranges into run file */
+    Outcome<CidsRun> writeRun(const std::string &path,
+                              std::vector<cids_index::MergeRange> &&ranges) const;
+    /**
+     * Size-tiered compaction.
+     * Merges kRunsPerTier runs of same tier into one run.
+     * Merges runs into index when runs are as large as index, so each row is
+     * rewritten log(index size) times.
+     */
+    Outcome<void> compactRuns();
+    /** merges runs into index, requires flush_mutex */
+    Outcome<void> mergeIndex(const cids_index::MergeFilter &keep);
+    /** flushes and merges everything into index, dropping filtered rows */
+    Outcome<void> compactAll(const cids_index::MergeFilter &keep);
+    /** rebuilds bloom when it's over capacity or forced */
+    Outcome<void> rebuildBloom(bool force = false);
+    /**
+     * Saves bloom for current index.
+     * Called when runs are merged into index and on shutdown, because save
+     * cost depends on index size.
+     */
+    Outcome<void> saveBloom() const;
+
+    static std::string runPath(const std::string &index_path,
+                               uint64_t max_offset);
+    static std::vector<std::string> listRuns(const std::string &index_path);
+
+    /** observed false positive rate of bloom filter */
+    double bloomFalsePositiveRate() const;
 
-    mutable std::mutex car_mutex;
-    mutable std::ifstream car_file;
+    /** read-only car descriptor for concurrent positional reads */
+    int car_fd{-1};
     mutable std::shared_mutex index_mutex;
     std::shared_ptr<Index> index;
+    /**
+     * Flushed runs not merged into index yet, guarded by index_mutex.
+     * Runs are mapped, they don't count against max_memory.
+     */
+    std::vector<CidsRun> runs;
+    /** runs of same tier merged together */
+    static constexpr size_t kRunsPerTier{4};
+    /** filter of index and written keys, guarded by index_mutex */
+    std::shared_ptr<Bloom> bloom;
+    /** lookups answered "absent" by bloom */
+    mutable std::atomic_size_t bloom_negatives{};
+    /** lookups answered "maybe present" by bloom, but key was absent */
+    mutable std::atomic_size_t bloom_false_positives{};
     IpldPtr ipld;
     std::shared_ptr<FILE> writable;
     mutable std::shared_mutex written_mutex;
-    std::set<Row> written;
+    Memtable written;
     uint64_t car_offset{};
     std::atomic_flag flushing{};
     std::mutex flush_mutex;
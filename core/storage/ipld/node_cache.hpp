@@ -0,0 +1,67 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <boost/compute/detail/lru_cache.hpp>
+#include <mutex>
+
+#include "cbor_blake/ipld_cbor.hpp"
+
+namespace fc::storage::ipld {
+  /**
+   * Process-wide cache of decoded tree nodes by cid.
+   * Cached nodes are shared between trees and must not be modified, trees
+   * copy cached node before modification (copy-on-write).
+   * Block is still read from ipld on each load, so gas charges and missing
+   * blocks are same as without cache, only decoding is skipped.
+   */
+  template <typename Node>
+  struct NodeCache {
+    using Ptr = std::shared_ptr<Node>;
+
+    explicit NodeCache(size_t capacity) : lru{capacity} {}
+
+    outcome::result<Ptr> load(const IpldPtr &ipld, const CID &key) {
+      OUTCOME_TRY(cbor, ipld->getShared(key));
+      std::unique_lock lock{mutex};
+      if (auto node{lru.get(key)}) {
+        ++hits;
+        return *node;
+      }
+      lock.unlock();
+      ++misses;
+      OUTCOME_TRY(node, cbor_blake::cbDecodeT<Node>(ipld, *cbor));
+      auto ptr{std::make_shared<Node>(std::move(node))};
+      ptr->cached = true;
+      lock.lock();
+      lru.insert(key, ptr);
+      return ptr;
+    }
+
+    /** caches node written with key, node must not be modified after */
+    void insert(const CID &key, const Ptr &node) {
+      node->cached = true;
+      std::unique_lock lock{mutex};
+      lru.insert(key, node);
+    }
+
+    std::mutex mutex;
+    boost::compute::detail::lru_cache<CID, Ptr> lru;
+    std::atomic_size_t hits{};
+    std::atomic_size_t misses{};
+  };
+
+  /** returns node if it is not cached, or replaces it with copy */
+  template <typename Node>
+  Node &unshare(std::shared_ptr<Node> &node) {
+    if (node->cached) {
+      node = std::make_shared<Node>(*node);
+      node->cached = false;
+    }
+    return *node;
+  }
+}  // namespace fc::storage::ipld
@@ -0,0 +1,241 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "storage/ipld/selector.hpp"
+
+#include "codec/cbor/cbor_decode_stream.hpp"
+
+namespace fc::storage::ipld {
+  using codec::cbor::CborDecodeStream;
+  using Type = SelectorNode::Type;
+
+  namespace {
+    /// Max nesting of selector, protects parser stack
+    constexpr size_t kMaxSelectorNesting{64};
+
+    using Map = std::map<std::string, CborDecodeStream>;
+
+    Map asMap(CborDecodeStream &s) {
+      if (!s.isMap()) {
+        outcome::raise(SelectorError::kInvalid);
+      }
+      return s.map();
+    }
+
+    CborDecodeStream &field(Map &map, const std::string &name) {
+      const auto it{map.find(name)};
+      if (it == map.end()) {
+        outcome::raise(SelectorError::kInvalid);
+      }
+      return it->second;
+    }
+
+    uint64_t uintField(Map &map, const std::string &name) {
+      uint64_t value{};
+      field(map, name) >> value;
+      return value;
+    }
+
+    // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+    SelectorPtr parse(CborDecodeStream &s, size_t nesting, bool recursive) {
+      if (nesting > kMaxSelectorNesting) {
+        outcome::raise(SelectorError::kInvalid);
+      }
+      auto outer{asMap(s)};
+      if (outer.size() != 1) {
+        outcome::raise(SelectorError::kInvalid);
+      }
+      auto &[key, value]{*outer.begin()};
+      ++nesting;
+      auto node{std::make_shared<SelectorNode>()};
+      if (key == ".") {
+        node->type = Type::kMatcher;
+      } else if (key == "a") {
+        node->type = Type::kAll;
+        auto map{asMap(value)};
+        node->next = parse(field(map, ">"), nesting, recursive);
+      } else if (key == "f") {
+        node->type = Type::kFields;
+        auto map{asMap(value)};
+        for (auto &[name, next] : asMap(field(map, "f>"))) {
+          node->fields.emplace(name, parse(next, nesting, recursive));
+        }
+      } else if (key == "i") {
+        node->type = Type::kIndex;
+        auto map{asMap(value)};
+        node->start = uintField(map, "i");
+        node->end = node->start + 1;
+        node->next = parse(field(map, ">"), nesting, recursive);
+      } else if (key == "r") {
+        node->type = Type::kRange;
+        auto map{asMap(value)};
+        node->start = uintField(map, "^");
+        node->end = uintField(map, "$");
+        node->next = parse(field(map, ">"), nesting, recursive);
+      } else if (key == "|") {
+        node->type = Type::kUnion;
+        if (!value.isList()) {
+          outcome::raise(SelectorError::kInvalid);
+        }
+        auto n{value.listLength()};
+        for (auto l{value.list()}; n != 0; --n) {
+          node->members.push_back(parse(l, nesting, recursive));
+        }
+      } else if (key == "R") {
+        node->type = Type::kRecursive;
+        auto map{asMap(value)};
+        if (map.count("!") != 0) {
+          // stop condition
+          outcome::raise(SelectorError::kUnsupported);
+        }
+        auto limit{asMap(field(map, "l"))};
+        if (limit.size() != 1) {
+          outcome::raise(SelectorError::kInvalid);
+        }
+        if (limit.count("depth") != 0) {
+          node->depth = uintField(limit, "depth");
+        } else if (limit.count("none") == 0) {
+          outcome::raise(SelectorError::kInvalid);
+        }
+        node->sequence = parse(field(map, ":>"), nesting, true);
+        node->current = node->sequence;
+      } else if (key == "@") {
+        if (!recursive) {
+          outcome::raise(SelectorError::kInvalid);
+        }
+        node->type = Type::kRecursiveEdge;
+      } else {
+        // ExploreConditional, ExploreInterpretAs
+        outcome::raise(SelectorError::kUnsupported);
+      }
+      return node;
+    }
+
+    bool hasRecursiveEdge(const SelectorPtr &selector) {
+      if (selector->type == Type::kRecursiveEdge) {
+        return true;
+      }
+      if (selector->type == Type::kUnion) {
+        for (const auto &member : selector->members) {
+          if (member->type == Type::kRecursiveEdge) {
+            return true;
+          }
+        }
+      }
+      return false;
+    }
+
+    /** replaces recursive edges with selector, null removes them */
+    SelectorPtr replaceRecursiveEdge(const SelectorPtr &selector,
+                                     const SelectorPtr &with) {
+      if (selector->type == Type::kRecursiveEdge) {
+        return with;
+      }
+      if (selector->type == Type::kUnion) {
+        auto node{std::make_shared<SelectorNode>(*selector)};
+        node->members.clear();
+        for (const auto &member : selector->members) {
+          if (member->type != Type::kRecursiveEdge) {
+            node->members.push_back(member);
+          } else if (with) {
+            node->members.push_back(with);
+          }
+        }
+        if (node->members.empty()) {
+          return nullptr;
+        }
+        return node;
+      }
+      return selector;
+    }
+  }  // namespace
+
+  outcome::result<SelectorPtr> parseSelector(BytesIn cbor) {
+    try {
+      CborDecodeStream s{cbor};
+      return parse(s, 0, false);
+    } catch (std::system_error &e) {
+      return outcome::failure(e.code());
+    }
+  }
+
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  SelectorPtr explore(const SelectorPtr &selector,
+                      const PathSegment &segment) {
+    switch (selector->type) {
+      case Type::kMatcher:
+      case Type::kRecursiveEdge:
+        return nullptr;
+      case Type::kAll:
+        return selector->next;
+      case Type::kFields:
+        if (const auto *key{boost::get<std::string_view>(&segment)}) {
+          const auto it{selector->fields.find(*key)};
+          if (it != selector->fields.end()) {
+            return it->second;
+          }
+        }
+        return nullptr;
+      case Type::kIndex:
+      case Type::kRange:
+        if (const auto *index{boost::get<uint64_t>(&segment)}) {
+          if (*index >= selector->start && *index < selector->end) {
+            return selector->next;
+          }
+        }
+        return nullptr;
+      case Type::kUnion: {
+        std::vector<SelectorPtr> members;
+        for (const auto &member : selector->members) {
+          if (auto next{explore(member, segment)}) {
+            members.push_back(std::move(next));
+          }
+        }
+        if (members.empty()) {
+          return nullptr;
+        }
+        if (members.size() == 1) {
+          return members[0];
+        }
+        auto node{std::make_shared<SelectorNode>()};
+        node->type = Type::kUnion;
+        node->members = std::move(members);
+        return node;
+      }
+      case Type::kRecursive: {
+        auto next{explore(selector->current, segment)};
+        if (!next) {
+          return nullptr;
+        }
+        auto node{std::make_shared<SelectorNode>(*selector)};
+        if (!hasRecursiveEdge(next)) {
+          node->current = std::move(next);
+          return node;
+        }
+        if (selector->depth) {
+          if (*selector->depth < 2) {
+            return replaceRecursiveEdge(next, nullptr);
+          }
+          node->depth = *selector->depth - 1;
+        }
+        node->current = replaceRecursiveEdge(next, selector->sequence);
+        return node;
+      }
+    }
+    return nullptr;
+  }
+}  // namespace fc::storage::ipld
+
+OUTCOME_CPP_DEFINE_CATEGORY(fc::storage::ipld, SelectorError, e) {
+  using fc::storage::ipld::SelectorError;
+
+  switch (e) {
+    case SelectorError::kInvalid:
+      return "Selector: invalid";
+    case SelectorError::kUnsupported:
+      return "Selector: unsupported";
+  }
+  return "Selector: unknown error";
+}
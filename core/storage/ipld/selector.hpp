@@ -5,11 +5,16 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
+#include <boost/variant.hpp>
+#include <map>
+
 #include "codec/cbor/cbor_raw.hpp"
+#include "common/outcome.hpp"
 
 namespace fc::storage::ipld {
 
-  // TODO(turuslan): implement selectors
+  /// Encoded selector
   using Selector = CborRaw;
 
   /**
@@ -19,4 +24,58 @@ namespace fc::storage::ipld {
   static const Selector kAllSelector{
       common::unhex("a16152a2616ca1646e6f6e65a0623a3ea16161a1613ea16140a0")
           .value()};
+
+  enum class SelectorError {
+    kInvalid = 1,
+    kUnsupported,
+  };
+
+  struct SelectorNode;
+  using SelectorPtr = std::shared_ptr<const SelectorNode>;
+
+  /**
+   * Parsed selector.
+   * Supports Matcher, ExploreAll, ExploreFields, ExploreIndex, ExploreRange,
+   * ExploreUnion, ExploreRecursive with depth limit and
+   * ExploreRecursiveEdge.
+   */
+  struct SelectorNode {
+    enum class Type {
+      kMatcher,
+      kAll,
+      kFields,
+      kIndex,
+      kRange,
+      kUnion,
+      kRecursive,
+      kRecursiveEdge,
+    };
+
+    Type type{};
+    /// selector of explored children for all, index and range
+    SelectorPtr next;
+    std::map<std::string, SelectorPtr, std::less<>> fields;
+    /// index range [start, end) for index and range
+    uint64_t start{};
+    uint64_t end{};
+    std::vector<SelectorPtr> members;
+    /// recursive sequence and its current state
+    SelectorPtr sequence;
+    SelectorPtr current;
+    /// remaining recursion depth, none if unlimited
+    boost::optional<uint64_t> depth;
+  };
+
+  /// Path segment of child node, map key or list index
+  using PathSegment = boost::variant<std::string_view, uint64_t>;
+
+  outcome::result<SelectorPtr> parseSelector(BytesIn cbor);
+
+  /**
+   * Returns selector for child node at segment.
+   * @return null if child is not explored
+   */
+  SelectorPtr explore(const SelectorPtr &selector, const PathSegment &segment);
 }  // namespace fc::storage::ipld
+
+OUTCOME_HPP_DECLARE_ERROR(fc::storage::ipld, SelectorError);
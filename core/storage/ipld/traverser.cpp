@@ -53,70 +53,108 @@ namespace fc::storage::ipld::traverser {
     }
   };
 
+  namespace {
+    SelectorPtr parseOrAll(const Selector &selector) {
+      if (auto parsed{parseSelector(selector.b)}) {
+        return parsed.value();
+      }
+      static const auto all{parseSelector(kAllSelector.b).value()};
+      return all;
+    }
+  }  // namespace
+
   Traverser::Traverser(Ipld &store,
                        const CID &root,
                        const Selector &selector,
                        bool unique)
+      : Traverser{store, root, parseOrAll(selector), unique} {}
+
+  Traverser::Traverser(Ipld &store,
+                       const CID &root,
+                       SelectorPtr selector,
+                       bool unique)
       : store{store}, unique{unique} {
-    to_visit_.push_back(root);
+    to_visit_.emplace_back(root, std::move(selector));
   }
 
   outcome::result<std::vector<CID>> Traverser::traverseAll() {
-    // TODO(turuslan): implement selectors
+    std::vector<CID> visit_order;
     while (!isCompleted()) {
-      OUTCOME_TRY(advance());
+      OUTCOME_TRY(cid, advance());
+      visit_order.push_back(std::move(cid));
     }
-    return visit_order_;
+    return visit_order;
   }
 
   outcome::result<CID> Traverser::advance() {
+    OUTCOME_TRY(block, advanceBlock());
+    return std::move(block.first);
+  }
+
+  outcome::result<std::pair<CID, Bytes>> Traverser::advanceBlock() {
     if (isCompleted()) {
       return TraverserError::kTraverseCompleted;
     }
-    CID cid{std::move(to_visit_.back())};
+    auto [cid, selector]{std::move(to_visit_.back())};
     to_visit_.pop_back();
     if (unique) {
       visited_.insert(cid);
     }
     auto BOOST_OUTCOME_TRY_UNIQUE_NAME{gsl::finally([&] {
       if (unique) {
-        while (!to_visit_.empty() && visited_.count(to_visit_.back()) != 0) {
+        while (!to_visit_.empty()
+               && visited_.count(to_visit_.back().first) != 0) {
           to_visit_.pop_back();
         }
       }
     })};
     OUTCOME_TRY(bytes, store.get(cid));
-    visit_order_.push_back(cid);
     const auto last{to_visit_.size()};
     // TODO(turuslan): what about other types?
     if (cid.content_type == CID::Multicodec::DAG_CBOR) {
       CborDecodeStream s{bytes};
-      OUTCOME_TRY(parseCbor(s));
+      OUTCOME_TRY(parseCbor(s, selector));
     } else if (cid.content_type == CID::Multicodec::DAG_PB) {
-      OUTCOME_TRY(PbNodeDecoder::links(to_visit_, bytes));
+      std::vector<CID> links;
+      OUTCOME_TRY(PbNodeDecoder::links(links, bytes));
+      const std::string_view kLinks{"Links"}, kHash{"Hash"};
+      if (auto links_selector{explore(selector, kLinks)}) {
+        for (uint64_t i{0}; i < links.size(); ++i) {
+          if (auto link{explore(links_selector, i)}) {
+            if (auto hash{explore(link, kHash)}) {
+              to_visit_.emplace_back(std::move(links[i]), std::move(hash));
+            }
+          }
+        }
+      }
     }
     std::reverse(to_visit_.begin() + gsl::narrow<int64_t>(last),
                  to_visit_.end());
-    return cid;
+    return std::make_pair(std::move(cid), std::move(bytes));
   }
 
   bool Traverser::isCompleted() const {
     return to_visit_.empty();
   }
 
-  outcome::result<void> Traverser::parseCbor(CborDecodeStream &s) {
-    if (s.isCid()) {
+  outcome::result<void> Traverser::parseCbor(CborDecodeStream &s,
+                                             const SelectorPtr &selector) {
+    if (!selector || selector->type == SelectorNode::Type::kMatcher) {
+      s.next();
+    } else if (s.isCid()) {
       CID cid;
       s >> cid;
-      to_visit_.push_back(cid);
+      to_visit_.emplace_back(std::move(cid), selector);
     } else if (s.isList()) {
       auto n = s.listLength();
-      for (auto l = s.list(); n != 0; --n) {
-        OUTCOME_TRY(parseCbor(l));
+      auto l = s.list();
+      for (uint64_t i{0}; i < n; ++i) {
+        OUTCOME_TRY(parseCbor(l, explore(selector, i)));
       }
     } else if (s.isMap()) {
       for (auto &p : s.map()) {
-        OUTCOME_TRY(parseCbor(p.second));
+        const std::string_view key{p.first};
+        OUTCOME_TRY(parseCbor(p.second, explore(selector, key)));
       }
     } else {
       s.next();
@@ -30,12 +30,22 @@ namespace fc::storage::ipld::traverser {
      * @param root - root cid
      * @param selector - selector
      * @param unique - should skip duplicates
+     * Explores all nodes if selector can't be parsed.
      */
     Traverser(Ipld &store,
               const CID &root,
               const Selector &selector,
               bool unique);
 
+    /**
+     * Constructor with parsed selector
+     * @param store - ipld store
+     * @param root - root cid
+     * @param selector - parsed selector
+     * @param unique - should skip duplicates
+     */
+    Traverser(Ipld &store, const CID &root, SelectorPtr selector, bool unique);
+
     /**
      * Traverse all from the root
      * @return all the visited cids
@@ -49,6 +59,13 @@ namespace fc::storage::ipld::traverser {
      */
     outcome::result<CID> advance();
 
+    /**
+     * Visit only next element
+     * Starts with root CID
+     * @return cid and content of traversed block
+     */
+    outcome::result<std::pair<CID, Bytes>> advanceBlock();
+
     /**
      * Checks if traversal completed
      * @return true if all cids are visited
@@ -56,13 +73,14 @@ namespace fc::storage::ipld::traverser {
     bool isCompleted() const;
 
    private:
-    outcome::result<void> parseCbor(CborDecodeStream &s);
+    outcome::result<void> parseCbor(CborDecodeStream &s,
+                                    const SelectorPtr &selector);
 
     Ipld &store;
     bool unique{};
-    std::vector<CID> to_visit_;     // set of cids to visit
-    std::vector<CID> visit_order_;  // visited cids in visit order
-    std::set<CID> visited_;         // set of visited cids
+    // stack of cids to visit with their selectors
+    std::vector<std::pair<CID, SelectorPtr>> to_visit_;
+    std::set<CID> visited_;  // set of visited cids, only if unique
   };
 
 }  // namespace fc::storage::ipld::traverser
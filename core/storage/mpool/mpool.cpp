@@ -19,6 +19,7 @@
 #include "node/pubsub_gate.hpp"
 #include "vm/actor/builtin/methods/payment_channel.hpp"
 #include "vm/interpreter/interpreter.hpp"
+#include "vm/message/sig_verifier.hpp"
 #include "vm/runtime/make_vm.hpp"
 #include "vm/state/impl/state_tree_impl.hpp"
 #include "vm/state/resolve_key.hpp"
@@ -32,6 +33,7 @@ namespace fc::storage::mpool {
   using vm::interpreter::InterpreterCache;
   using vm::message::UnsignedMessage;
   using vm::state::StateTreeImpl;
+  using vm::version::NetworkVersion;
   namespace paych = vm::actor::builtin::paych;
 
   constexpr GasAmount kMinGas{1298450};
@@ -86,10 +88,13 @@ namespace fc::storage::mpool {
     return out;
   }
 
-  void add(std::map<Address, std::map<Nonce, SignedMessage>> &by_from,
+  /** returns false if message replaced message with same nonce */
+  bool add(std::map<Address, std::map<Nonce, SignedMessage>> &by_from,
            const SignedMessage &smsg) {
     assert(smsg.message.from.isKeyType());
-    by_from[smsg.message.from][smsg.message.nonce] = smsg;
+    return by_from[smsg.message.from]
+        .insert_or_assign(smsg.message.nonce, smsg)
+        .second;
   }
 
   auto remove(std::map<Address, std::map<Nonce, SignedMessage>> &by_from,
@@ -115,7 +120,8 @@ namespace fc::storage::mpool {
   struct MsgChain {
     using Ptr = std::shared_ptr<MsgChain>;
 
-    std::vector<SignedMessage> msgs;
+    /** point to pending messages, valid while pending_mutex_ is locked */
+    std::vector<const SignedMessage *> msgs;
     TokenAmount gas_reward;
     GasAmount gas_limit{};
     double gas_perf{};
@@ -185,7 +191,7 @@ namespace fc::storage::mpool {
 
   void trim(MsgChain &mc, GasAmount gas_limit, const TokenAmount &base_fee) {
     while (!mc.msgs.empty() && (mc.gas_limit > gas_limit || mc.gas_perf < 0)) {
-      auto &msg{mc.msgs.back().message};
+      auto &msg{mc.msgs.back()->message};
       mc.gas_reward -= getGasReward(msg, base_fee);
       mc.gas_limit -= msg.gas_limit;
       if (mc.gas_limit > 0) {
@@ -226,7 +232,7 @@ namespace fc::storage::mpool {
       TokenAmount actor_balance,
       const vm::runtime::Pricelist &pricelist) {
     auto gas_limit{kBlockGasLimit};
-    std::vector<SignedMessage> msgs;
+    std::vector<const SignedMessage *> msgs;
     for (const auto &[nonce, msg] : pending) {
       if (nonce < actor_nonce) {
         continue;
@@ -247,7 +253,7 @@ namespace fc::storage::mpool {
       }
       actor_balance -= msg.message.requiredFunds();
       actor_balance -= msg.message.value;
-      msgs.push_back(msg);
+      msgs.push_back(&msg);
     }
     std::vector<MsgChain::Ptr> chains;
     if (msgs.empty()) {
@@ -260,15 +266,15 @@ namespace fc::storage::mpool {
       return chain;
     }};
     auto cur_chain{new_chain()};
-    for (auto &msg : msgs) {
-      auto reward{getGasReward(msg.message, base_fee)};
+    for (const auto *msg : msgs) {
+      auto reward{getGasReward(msg->message, base_fee)};
       TokenAmount gas_reward{cur_chain->gas_reward + reward};
-      const auto chain_gas_limit{cur_chain->gas_limit + msg.message.gas_limit};
+      const auto chain_gas_limit{cur_chain->gas_limit + msg->message.gas_limit};
       auto gas_perf{getGasPerf(gas_reward, gas_limit)};
       if (!cur_chain->msgs.empty() && gas_perf < cur_chain->gas_perf) {
         cur_chain = new_chain();
         cur_chain->gas_reward = reward;
-        cur_chain->gas_limit = msg.message.gas_limit;
+        cur_chain->gas_limit = msg->message.gas_limit;
         cur_chain->gas_perf =
             getGasPerf(cur_chain->gas_reward, cur_chain->gas_limit);
       } else {
@@ -276,7 +282,7 @@ namespace fc::storage::mpool {
         cur_chain->gas_limit = chain_gas_limit;
         cur_chain->gas_perf = gas_perf;
       }
-      cur_chain->msgs.push_back(std::move(msg));
+      cur_chain->msgs.push_back(msg);
     }
     while (true) {
       auto merged{0};
@@ -316,7 +322,7 @@ namespace fc::storage::mpool {
   auto greedy(std::vector<MsgChain::Ptr> &chains,
               GasAmount &gas_limit,
               const TokenAmount &base_fee) {
-    std::vector<SignedMessage> messages;
+    std::vector<const SignedMessage *> messages;
     std::sort(chains.begin(), chains.end(), deref(before));
     for (size_t i{0}; i < chains.size(); ++i) {
       auto &chain{chains[i]};
@@ -375,7 +381,7 @@ namespace fc::storage::mpool {
                GasAmount &gas_limit,
                const TokenAmount &base_fee,
                double ticket_quality) {
-    std::vector<SignedMessage> messages;
+    std::vector<const SignedMessage *> messages;
     std::sort(chains.begin(), chains.end(), deref(before));
     if (chains.empty() || chains[0]->gas_perf < 0) {
       return messages;
@@ -431,7 +437,7 @@ namespace fc::storage::mpool {
                      GasAmount &gas_limit,
                      const TokenAmount &base_fee,
                      std::default_random_engine &generator) {
-    std::vector<SignedMessage> messages;
+    std::vector<const SignedMessage *> messages;
     if (gas_limit >= kMinGas) {
       std::shuffle(chains.begin(), chains.end(), generator);
     }
@@ -460,6 +466,108 @@ namespace fc::storage::mpool {
     return messages;
   }
 
+  /** chains of sender and inputs they were created from */
+  struct SenderChains {
+    Nonce nonce{};
+    TokenAmount balance;
+    TokenAmount base_fee;
+    /** rewards don't depend on base fee up to this bound */
+    TokenAmount fee_bound;
+    NetworkVersion version{};
+    std::vector<MsgChain::Ptr> chains;
+
+    bool valid(Nonce nonce,
+               const TokenAmount &balance,
+               const TokenAmount &base_fee,
+               NetworkVersion version) const {
+      return nonce == this->nonce && balance == this->balance
+             && version == this->version
+             && (base_fee == this->base_fee
+                 || (base_fee <= fee_bound && this->base_fee <= fee_bound));
+    }
+  };
+
+  struct ChainsCache {
+    std::mutex mutex;
+    std::map<Address, SenderChains> senders;
+
+    void erase(const Address &from) {
+      std::unique_lock lock{mutex};
+      senders.erase(from);
+    }
+  };
+
+  /** copies chains, because selection modifies them */
+  std::vector<MsgChain::Ptr> cloneChains(
+      const std::vector<MsgChain::Ptr> &chains) {
+    std::vector<MsgChain::Ptr> clones;
+    clones.reserve(chains.size());
+    for (const auto &chain : chains) {
+      auto clone{std::make_shared<MsgChain>(*chain)};
+      clone->prev.reset();
+      clone->next.reset();
+      if (!clones.empty()) {
+        clone->prev = clones.back();
+        clones.back()->next = clone;
+      }
+      clones.push_back(std::move(clone));
+    }
+    return clones;
+  }
+
+  /**
+   * Appends chains of sender.
+   * Cached chains are reused when sender actor and base fee didn't change
+   * them, so only changed senders are rebuilt.
+   * Cache is not used when pending messages differ from pool.
+   */
+  outcome::result<void> appendChains(
+      std::vector<MsgChain::Ptr> &chains,
+      ChainsCache *cache,
+      const Address &from,
+      const std::map<Nonce, SignedMessage> &by_nonce,
+      StateTreeImpl &state_tree,
+      const TokenAmount &base_fee,
+      const vm::runtime::Pricelist &pricelist,
+      NetworkVersion version) {
+    OUTCOME_TRY(actor, state_tree.get(from));
+    std::unique_lock<std::mutex> lock;
+    if (cache) {
+      lock = std::unique_lock{cache->mutex};
+      auto it{cache->senders.find(from)};
+      if (it != cache->senders.end()
+          && it->second.valid(actor.nonce, actor.balance, base_fee, version)) {
+        append(chains, cloneChains(it->second.chains));
+        return outcome::success();
+      }
+    }
+    auto created{createMessageChains(
+        by_nonce, base_fee, actor.nonce, actor.balance, pricelist)};
+    if (cache) {
+      auto &cached{cache->senders[from]};
+      cached.nonce = actor.nonce;
+      cached.balance = actor.balance;
+      cached.base_fee = base_fee;
+      cached.version = version;
+      boost::optional<TokenAmount> fee_bound;
+      for (const auto &chain : created) {
+        for (const auto *msg : chain->msgs) {
+          TokenAmount bound{msg->message.gas_fee_cap
+                            - msg->message.gas_premium};
+          if (!fee_bound || bound < *fee_bound) {
+            fee_bound = std::move(bound);
+          }
+        }
+      }
+      cached.fee_bound = fee_bound ? *fee_bound : TokenAmount{};
+      cached.chains = created;
+      append(chains, cloneChains(created));
+    } else {
+      append(chains, created);
+    }
+    return outcome::success();
+  }
+
   std::shared_ptr<MessagePool> MessagePool::create(
       const EnvironmentContext &env_context,
       TsBranchPtr ts_main,
@@ -481,6 +589,7 @@ namespace fc::storage::mpool {
             }
           }
         });
+    mpool->chains_cache_ = std::make_shared<ChainsCache>();
     mpool->bls_cache = {bls_cache_size};
     mpool->pubsub_gate_ = std::move(pubsub_gate);
     mpool->logger_ = common::createLogger("MessagePool");
@@ -530,13 +639,12 @@ namespace fc::storage::mpool {
     OUTCOME_TRY(cached, env_context.interpreter_cache->get(tipset_ptr->key));
     vm::state::StateTreeImpl state_tree{
         withVersion(env_context.ipld, tipset_ptr->height()), cached.state_root};
-    std::shared_lock pending_lock{pending_mutex_};
-    auto pending{pending_};
-    pending_lock.unlock();
+    const auto version{vm::version::getNetworkVersion(tipset_ptr->epoch())};
     constexpr auto kDepth{20};
     std::shared_lock head_lock(head_mutex_);
     OUTCOME_TRY(path, findPath(env_context.ts_load, head_, tipset_ptr, kDepth));
     head_lock.unlock();
+    std::vector<SignedMessage> reverted;
     for (auto &ts : path.first) {
       OUTCOME_TRY(ts->visitMessages(
           {ipld, false, true},
@@ -545,50 +653,100 @@ namespace fc::storage::mpool {
             if (bls) {
               std::lock_guard bls_cache_lock{bls_cache_mutex_};
               if (auto sig{bls_cache.get(cid)}) {
-                mpool::add(pending, {*msg, *sig});
+                reverted.push_back({*msg, *sig});
               }
             } else {
-              mpool::add(pending, *smsg);
+              reverted.push_back(*smsg);
             }
             return outcome::success();
           }));
     }
+    std::vector<std::pair<Address, Nonce>> applied;
     for (auto &ts : path.second) {
       OUTCOME_TRY(ts->visitMessages(
           {ipld, false, true},
           [&](auto, auto, auto &, auto *, auto *msg) -> outcome::result<void> {
-            mpool::remove(pending, msg->from, msg->nonce);
+            applied.emplace_back(msg->from, msg->nonce);
             return outcome::success();
           }));
     }
-    std::vector<SignedMessage> messages;
+
+    // chains point to pending messages
+    std::shared_lock pending_lock{pending_mutex_};
+    // senders changed by path from head to tipset, their chains are not cached
+    std::map<Address, std::map<Nonce, SignedMessage>> changed;
+    auto changedSender{[&](const Address &from) -> auto & {
+      auto it{changed.find(from)};
+      if (it == changed.end()) {
+        it = changed.emplace(from, std::map<Nonce, SignedMessage>{}).first;
+        auto pending_it{pending_.find(from)};
+        if (pending_it != pending_.end()) {
+          it->second = pending_it->second;
+        }
+      }
+      return it->second;
+    }};
+    for (auto &smsg : reverted) {
+      changedSender(smsg.message.from)[smsg.message.nonce] = std::move(smsg);
+    }
+    for (auto &[from, nonce] : applied) {
+      changedSender(from).erase(nonce);
+    }
+
+    std::vector<const SignedMessage *> messages;
     std::vector<MsgChain::Ptr> chains;
     GasAmount gas_limit{kBlockGasLimit};
-    auto createChains{
-        [&](auto &chains, auto &from, auto &by_nonce) -> outcome::result<void> {
-          OUTCOME_TRY(actor, state_tree.get(from));
-          append(
-              chains,
-              createMessageChains(
-                  by_nonce, base_fee, actor.nonce, actor.balance, pricelist));
-          return outcome::success();
-        }};
+    auto createChains{[&](auto &chains, auto &from) -> outcome::result<void> {
+      if (auto it{changed.find(from)}; it != changed.end()) {
+        return appendChains(chains,
+                            nullptr,
+                            from,
+                            it->second,
+                            state_tree,
+                            base_fee,
+                            pricelist,
+                            version);
+      }
+      if (auto it{pending_.find(from)}; it != pending_.end()) {
+        return appendChains(chains,
+                            chains_cache_.get(),
+                            from,
+                            it->second,
+                            state_tree,
+                            base_fee,
+                            pricelist,
+                            version);
+      }
+      return outcome::success();
+    }};
     // TODO(turuslan): priority addrs
-    std::vector<Address> priority_addrs;
+    std::set<Address> priority_addrs;
     for (auto &from : priority_addrs) {
-      auto it{pending.find(from)};
-      if (it != pending.end()) {
-        OUTCOME_TRY(createChains(chains, from, it->second));
-        pending.erase(it);
-      }
+      OUTCOME_TRY(createChains(chains, from));
     }
     append(messages, greedy(chains, gas_limit, base_fee));
     chains.clear();
+    auto result{[&] {
+      messages.resize(std::min(kMaxBlockMessages, messages.size()));
+      std::vector<SignedMessage> result;
+      result.reserve(messages.size());
+      for (const auto *msg : messages) {
+        result.push_back(*msg);
+      }
+      return result;
+    }};
     if (gas_limit < kMinGas) {
-      return messages;
+      return result();
+    }
+    for (auto &[from, by_nonce] : pending_) {
+      if (priority_addrs.count(from) == 0) {
+        OUTCOME_TRY(createChains(chains, from));
+      }
     }
-    for (auto &[from, by_nonce] : pending) {
-      OUTCOME_TRY(createChains(chains, from, by_nonce));
+    for (auto &[from, by_nonce] : changed) {
+      if (priority_addrs.count(from) == 0 && pending_.count(from) == 0) {
+        OUTCOME_TRY(createChains(chains, from));
+      }
     }
     if (ticket_quality > 0.84) {
       append(messages, greedy(chains, gas_limit, base_fee));
@@ -596,8 +754,7 @@ namespace fc::storage::mpool {
       append(messages, optimal(chains, gas_limit, base_fee, ticket_quality));
       append(messages, optimalRandom(chains, gas_limit, base_fee, generator));
     }
-    messages.resize(std::min(kMaxBlockMessages, messages.size()));
-    return messages;
+    return result();
   }
 
   outcome::result<Nonce> MessagePool::nonce(const Address &from) const {
@@ -777,6 +934,13 @@ namespace fc::storage::mpool {
   }
 
   outcome::result<void> MessagePool::add(const SignedMessage &message) {
+    if (const auto &verifier{env_context.sig_verifier}) {
+      auto key{message.message.from};
+      if (!key.isKeyType()) {
+        OUTCOME_TRYA(key, resolveKeyAtFinality(key));
+      }
+      OUTCOME_TRY(verifier->verify(key, message));
+    }
     if (message.signature.isBls()) {
       std::lock_guard bls_cache_lock{bls_cache_mutex_};
       bls_cache.insert(message.getCid(), message.signature);
@@ -784,18 +948,123 @@ namespace fc::storage::mpool {
     OUTCOME_TRY(setCbor(ipld, message));
     OUTCOME_TRY(setCbor(ipld, message.message));
     std::unique_lock pending_lock{pending_mutex_};
-    mpool::add(pending_, message);
+    if (mpool::add(pending_, message)) {
+      ++pending_count_;
+    }
+    chains_cache_->erase(message.message.from);
     signal({MpoolUpdate::Type::ADD, message});
+    const auto prune{pending_count_ > size_limit_high};
+    pending_lock.unlock();
+    if (prune) {
+      if (auto res{pruneMessages()}; !res) {
+        logger_->warn("pruneMessages: {:#}", res.error());
+      }
+    }
     return outcome::success();
   }
 
   void MessagePool::remove(const Address &from, Nonce nonce) {
     std::unique_lock pending_lock{pending_mutex_};
     if (auto smsg{mpool::remove(pending_, from, nonce)}) {
+      --pending_count_;
+      chains_cache_->erase(from);
       signal({MpoolUpdate::Type::REMOVE, *smsg});
     }
   }
 
+  size_t MessagePool::pendingCount() const {
+    std::shared_lock pending_lock{pending_mutex_};
+    return pending_count_;
+  }
+
+  // https://github.com/filecoin-project/lotus/blob/8f78066d4f3c4981da73e3328716631202c6e614/chain/messagepool/pruning.go#L38
+  outcome::result<void> MessagePool::pruneMessages() {
+    if (pruning_.test_and_set()) {
+      return outcome::success();
+    }
+    auto clear{gsl::finally([&] { pruning_.clear(); })};
+    const auto now{std::chrono::steady_clock::now()};
+    if (last_prune_ != std::chrono::steady_clock::time_point{}
+        && now - last_prune_ < kPruneCooldown) {
+      return outcome::success();
+    }
+
+    std::shared_lock head_lock(head_mutex_);
+    OUTCOME_TRY(base_fee, head_->nextBaseFee(ipld));
+    const vm::runtime::Pricelist pricelist{head_->epoch()};
+    const auto version{vm::version::getNetworkVersion(head_->epoch())};
+    OUTCOME_TRY(cached, env_context.interpreter_cache->get(head_->key));
+    vm::state::StateTreeImpl state_tree{
+        withVersion(env_context.ipld, head_->height()), cached.state_root};
+    head_lock.unlock();
+
+    std::unique_lock pending_lock{pending_mutex_};
+    if (pending_count_ <= size_limit_high) {
+      return outcome::success();
+    }
+    last_prune_ = now;
+    std::shared_lock local_addresses_lock{local_addresses_mutex_};
+    std::set<const SignedMessage *> keep;
+    std::vector<MsgChain::Ptr> chains;
+    for (const auto &[from, by_nonce] : pending_) {
+      // local messages are never pruned
+      if (local_addresses_.contains(from)) {
+        for (const auto &[nonce, message] : by_nonce) {
+          keep.insert(&message);
+        }
+        continue;
+      }
+      // messages of unknown actor are pruned
+      if (auto res{appendChains(chains,
+                                chains_cache_.get(),
+                                from,
+                                by_nonce,
+                                state_tree,
+                                base_fee,
+                                pricelist,
+                                version)};
+          !res) {
+        logger_->debug("pruneMessages {}: {:#}", from, res.error());
+      }
+    }
+    local_addresses_lock.unlock();
+    std::sort(chains.begin(), chains.end(), deref(before));
+    for (const auto &chain : chains) {
+      if (keep.size() >= size_limit_low) {
+        break;
+      }
+      for (const auto *message : chain->msgs) {
+        if (keep.size() >= size_limit_low) {
+          break;
+        }
+        keep.insert(message);
+      }
+    }
+    chains.clear();
+
+    size_t pruned{0};
+    for (auto from_it{pending_.begin()}; from_it != pending_.end();) {
+      auto &by_nonce{from_it->second};
+      const auto count{by_nonce.size()};
+      for (auto it{by_nonce.begin()}; it != by_nonce.end();) {
+        if (keep.count(&it->second) == 0) {
+          signal({MpoolUpdate::Type::REMOVE, it->second});
+          it = by_nonce.erase(it);
+        } else {
+          ++it;
+        }
+      }
+      if (by_nonce.size() != count) {
+        pruned += count - by_nonce.size();
+        chains_cache_->erase(from_it->first);
+      }
+      from_it = by_nonce.empty() ? pending_.erase(from_it) : std::next(from_it);
+    }
+    pending_count_ -= pruned;
+    logger_->info("pruned {} messages", pruned);
+    return outcome::success();
+  }
+
   // NOLINTNEXTLINE(readability-function-cognitive-complexity)
   outcome::result<void> MessagePool::onHeadChange(const HeadChange &change) {
     if (change.type == HeadChangeType::CURRENT) {
@@ -947,13 +1216,13 @@ namespace fc::storage::mpool {
       if (chain->gas_limit <= gas_limit) {
         // check the baseFee lower bound -- only republish messages that can be
         // included in the chain within the next 20 blocks.
-        for (const auto &message : chain->msgs) {
-          if (message.message.gas_fee_cap < base_fee_lower_bound) {
+        for (const auto *message : chain->msgs) {
+          if (message->message.gas_fee_cap < base_fee_lower_bound) {
             invalidate(*chain);
             break;
           }
-          gas_limit -= message.message.gas_limit;
-          messages.push_back(message);
+          gas_limit -= message->message.gas_limit;
+          messages.push_back(*message);
         }
         continue;
       }
@@ -39,6 +39,14 @@ namespace fc::storage::mpool {
   constexpr size_t kResolvedCacheSize{1000};
   constexpr size_t kLocalAddressesCacheSize{1000};
   constexpr std::chrono::milliseconds kRepublishBatchDelay{100};
+  // https://github.com/filecoin-project/lotus/blob/8f78066d4f3c4981da73e3328716631202c6e614/chain/messagepool/config.go#L15
+  /** pool is pruned when it has more messages */
+  constexpr size_t kSizeLimitHigh{30000};
+  /** pruning keeps best messages up to this count */
+  constexpr size_t kSizeLimitLow{20000};
+  constexpr std::chrono::minutes kPruneCooldown{1};
+
+  struct ChainsCache;
 
   struct MpoolUpdate {
     enum class Type : int64_t { ADD, REMOVE };
@@ -142,6 +150,19 @@ namespace fc::storage::mpool {
     static TokenAmount getBaseFeeLowerBound(const TokenAmount &base_fee,
                                             const BigInt &factor);
 
+    /**
+     * Removes worst messages when pool is over size_limit_high.
+     * Chains of not local senders are ranked by gas performance, best
+     * messages up to size_limit_low are kept.
+     */
+    outcome::result<void> pruneMessages();
+
+    /** number of pending messages */
+    size_t pendingCount() const;
+
+    size_t size_limit_high{kSizeLimitHigh};
+    size_t size_limit_low{kSizeLimitLow};
+
    private:
     // For empty value in lru cache
     struct Empty {};
@@ -165,8 +186,15 @@ namespace fc::storage::mpool {
 
     // pending messages, key is a from address
     std::map<Address, std::map<Nonce, SignedMessage>> pending_;
+    size_t pending_count_{};
     mutable std::shared_mutex pending_mutex_;
 
+    /** message chains of senders, entry is removed when sender changes */
+    std::shared_ptr<ChainsCache> chains_cache_;
+
+    std::atomic_flag pruning_{};
+    std::chrono::steady_clock::time_point last_prune_;
+
     std::deque<SignedMessage> publishing_;
     std::mutex publishing_mutex_;
 
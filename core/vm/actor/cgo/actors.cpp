@@ -5,7 +5,11 @@
 
 #include "vm/actor/cgo/actors.hpp"
 
+#include <array>
+#include <atomic>
+
 #include "proofs/impl/proof_engine_impl.hpp"
+#include "proofs/seal_verifier.hpp"
 #include "vm/actor/builtin/types/storage_power/policy.hpp"
 #include "vm/actor/builtin/types/verified_registry/policy.hpp"
 #include "vm/actor/cgo/c_actors.h"
@@ -14,18 +18,15 @@
 #include "vm/runtime/env.hpp"
 #include "vm/toolchain/toolchain.hpp"
 
-#define RUNTIME_METHOD(name)                         \
-  void rt_##name(const std::shared_ptr<Runtime> &,   \
-                 CborDecodeStream &,                 \
-                 CborEncodeStream &);                \
-  CBOR_METHOD(name) {                                \
-    std::unique_lock runtimes_lock{runtimes_mutex};  \
-    auto &rt{runtimes.at(arg.get<size_t>())};        \
-    runtimes_lock.unlock();                          \
-    rt_##name(rt, arg, ret);                         \
-  }                                                  \
-  void rt_##name(const std::shared_ptr<Runtime> &rt, \
-                 CborDecodeStream &arg,              \
+#define RUNTIME_METHOD(name)                          \
+  void rt_##name(const std::shared_ptr<Runtime> &,    \
+                 CborDecodeStream &,                  \
+                 CborEncodeStream &);                 \
+  CBOR_METHOD(name) {                                 \
+    rt_##name(runtimeAt(arg.get<size_t>()), arg, ret); \
+  }                                                   \
+  void rt_##name(const std::shared_ptr<Runtime> &rt,  \
+                 CborDecodeStream &arg,               \
                  CborEncodeStream &ret)
 
 namespace fc::vm::actor::cgo {
@@ -65,9 +66,51 @@ namespace fc::vm::actor::cgo {
   constexpr auto kFatal{VMExitCode::kFatal};
   constexpr auto kOk{VMExitCode::kOk};
 
-  static std::mutex runtimes_mutex;
-  static std::map<size_t, std::shared_ptr<Runtime>> runtimes;
-  static size_t next_runtime{0};
+  /// Actor calls in progress, nested and from concurrent threads
+  constexpr size_t kRuntimeSlots{1 << 12};
+
+  struct RuntimeSlot {
+    std::atomic<const std::shared_ptr<Runtime> *> runtime{};
+    /// Borrowed by go until next callback of runtime
+    Bytes buffer;
+  };
+
+  static std::array<RuntimeSlot, kRuntimeSlots> runtimes;
+  static std::atomic_size_t next_runtime{0};
+
+  RuntimeHandle::RuntimeHandle(const std::shared_ptr<Runtime> &runtime) {
+    // each slot is tried once, table is full when all are taken
+    for (size_t i{0}; i < kRuntimeSlots; ++i) {
+      const auto slot{next_runtime++ % kRuntimeSlots};
+      const std::shared_ptr<Runtime> *empty{nullptr};
+      if (runtimes[slot].runtime.compare_exchange_strong(empty, &runtime)) {
+        id = slot;
+        return;
+      }
+    }
+  }
+
+  RuntimeHandle::~RuntimeHandle() {
+    if (!*this) {
+      return;
+    }
+    auto &slot{runtimes[id]};
+    // release memory of large blocks returned to go
+    Bytes{}.swap(slot.buffer);
+    slot.runtime.store(nullptr);
+  }
+
+  inline const std::shared_ptr<Runtime> &runtimeAt(size_t id) {
+    return *runtimes.at(id).runtime.load();
+  }
+
+  /** runtime in slot, null for invalid id, doesn't throw */
+  inline const std::shared_ptr<Runtime> *runtimeRaw(uint64_t id) {
+    if (id >= kRuntimeSlots) {
+      return nullptr;
+    }
+    return runtimes[id].runtime.load();
+  }
 
   static std::shared_ptr<proofs::ProofEngine> proofs =
       std::make_shared<proofs::ProofEngineImpl>();
@@ -75,21 +118,20 @@ namespace fc::vm::actor::cgo {
   outcome::result<Bytes> invoke(const CID &code,
                                 const std::shared_ptr<Runtime> &runtime) {
     CborEncodeStream arg;
-    std::unique_lock runtimes_lock{runtimes_mutex};
-    auto id{next_runtime++};  // TODO: mod
-    runtimes.emplace(id, runtime);
-    runtimes_lock.unlock();
+    const RuntimeHandle handle{runtime};
+    if (!handle) {
+      spdlog::error("cgoActorsInvoke: {} actor calls in progress",
+                    kRuntimeSlots);
+      return kFatal;
+    }
     const auto &message{runtime->getMessage().get()};
     auto version{runtime->getNetworkVersion()};
     const auto &base_fee{runtime->execution()->env->base_fee};
-    arg << id << version << base_fee << message.from << message.to
+    arg << handle.id << version << base_fee << message.from << message.to
         << runtime->getCurrentEpoch() << message.value << code << message.method
         << message.params;
     const auto _ret{cgoCall<cgoActorsInvoke>(arg)};
     CborDecodeStream ret{_ret};
-    runtimes_lock.lock();
-    runtimes.erase(id);
-    runtimes_lock.unlock();
     auto exit{ret.get<VMExitCode>()};
     if (exit != kOk) {
       auto abortf{ret.get<Bytes>()};
@@ -152,6 +194,62 @@ namespace fc::vm::actor::cgo {
     return {};
   }
 
+  template <typename T>
+  inline int64_t exitCode(const outcome::result<T> &r) {
+    if (r) {
+      return static_cast<int64_t>(kOk);
+    }
+    if (r.error() == asAbort(VMExitCode::kSysErrOutOfGas)) {
+      return static_cast<int64_t>(VMExitCode::kSysErrOutOfGas);
+    }
+    return static_cast<int64_t>(kFatal);
+  }
+
+  // raw callbacks must not throw across cgo boundary
+  extern "C" int64_t gocRtIpldGetRaw(uint64_t id, Raw key, Raw *value) {
+    const auto *rt{runtimeRaw(id)};
+    const auto cid{CID::fromBytes(gocArg(key))};
+    if (!rt || !cid) {
+      return static_cast<int64_t>(kFatal);
+    }
+    auto r{(*rt)->execution()->charging_ipld->get(cid.value())};
+    if (r) {
+      auto &slot{runtimes[id]};
+      slot.buffer = std::move(r.value());
+      *value = cgoArg(slot.buffer);
+    }
+    return exitCode(r);
+  }
+
+  extern "C" int64_t gocRtIpldPutRaw(uint64_t id, Raw value, Raw *key) {
+    const auto *rt{runtimeRaw(id)};
+    const BytesIn input{gocArg(value)};
+    const auto cid{common::getCidOf(input)};
+    if (!rt || !cid) {
+      return static_cast<int64_t>(kFatal);
+    }
+    const auto r{
+        (*rt)->execution()->charging_ipld->set(cid.value(), BytesCow{input})};
+    if (r) {
+      auto cid_bytes{cid.value().toBytes()};
+      if (!cid_bytes) {
+        return static_cast<int64_t>(kFatal);
+      }
+      auto &slot{runtimes[id]};
+      slot.buffer = std::move(cid_bytes.value());
+      *key = cgoArg(slot.buffer);
+    }
+    return exitCode(r);
+  }
+
+  extern "C" int64_t gocRtChargeRaw(uint64_t id, int64_t gas) {
+    const auto *rt{runtimeRaw(id)};
+    if (!rt) {
+      return static_cast<int64_t>(kFatal);
+    }
+    return exitCode((*rt)->execution()->chargeGas(gas));
+  }
+
   RUNTIME_METHOD(gocRtIpldGet) {
     if (auto value{ipldGet(ret, rt, arg.get<CID>())}) {
       ret << kOk << *value;
@@ -212,11 +310,26 @@ namespace fc::vm::actor::cgo {
   }
 
   RUNTIME_METHOD(gocRtVerifySeals) {
-    auto n{arg.get<size_t>()};
+    const auto n{arg.get<size_t>()};
+    std::vector<SealVerifyInfo> infos;
+    infos.reserve(n);
+    for (size_t i{0}; i < n; ++i) {
+      infos.push_back(arg.get<SealVerifyInfo>());
+    }
+    const auto &seal_verifier{
+        rt->execution()->env->env_context.seal_verifier};
+    std::vector<bool> valid;
+    if (seal_verifier) {
+      valid = seal_verifier->verify(infos);
+    } else {
+      for (const auto &info : infos) {
+        const auto r{proofs->verifySeal(info)};
+        valid.push_back(r && r.value());
+      }
+    }
     ret << kOk;
-    for (auto i{0u}; i < n; ++i) {
-      auto r{proofs->verifySeal(arg.get<SealVerifyInfo>())};
-      ret << (r && r.value());
+    for (const auto v : valid) {
+      ret << v;
     }
   }
 
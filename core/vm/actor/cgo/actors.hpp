@@ -26,6 +26,28 @@ namespace fc::vm::actor::cgo {
   };
   void logLevel(LogLevel level);
 
+  /**
+   * Makes runtime visible by id to callbacks from go until destroyed.
+   * Runtimes are kept in lock-free slot table, runtime must outlive handle.
+   * Handle is false if table is full.
+   */
+  struct RuntimeHandle {
+    explicit RuntimeHandle(const std::shared_ptr<Runtime> &runtime);
+    RuntimeHandle(const RuntimeHandle &) = delete;
+    RuntimeHandle(RuntimeHandle &&) = delete;
+    ~RuntimeHandle();
+    RuntimeHandle &operator=(const RuntimeHandle &) = delete;
+    RuntimeHandle &operator=(RuntimeHandle &&) = delete;
+
+    /** false if all slots were taken */
+    explicit operator bool() const {
+      return id != kNoSlot;
+    }
+
+    static constexpr size_t kNoSlot{SIZE_MAX};
+    size_t id{kNoSlot};
+  };
+
   outcome::result<Bytes> invoke(const CID &code,
                                 const std::shared_ptr<Runtime> &runtime);
 }  // namespace fc::vm::actor::cgo
@@ -11,6 +11,12 @@
 extern "C" {
 #endif
 
+// Hot callbacks with fixed binary abi, return exit code.
+// Output buffers are borrowed until next callback of runtime.
+int64_t gocRtIpldGetRaw(uint64_t, Raw, Raw *);
+int64_t gocRtIpldPutRaw(uint64_t, Raw, Raw *);
+int64_t gocRtChargeRaw(uint64_t, int64_t);
+
 Raw gocRtIpldGet(Raw);
 Raw gocRtIpldPut(Raw);
 Raw gocRtCharge(Raw);
@@ -287,7 +287,7 @@ func (rt *rt) StartSpan(string) (EndSpan func()) {
 }
 
 func (rt *rt) ChargeGas(_ string, gas int64, _ int64) {
-	rt.gocRet(C.gocRtCharge(rt.gocArg().int(gas).arg()))
+	rt.gocExit(C.gocRtChargeRaw(C.uint64_t(rt.id), C.int64_t(gas)))
 }
 
 var log_level rtt.LogLevel = rtt.WARN
@@ -343,8 +343,10 @@ var _ rt6.Store = &rt{}
 var _ rt7.Store = &rt{}
 
 func (rt *rt) StoreGet(c cid.Cid, o cbor.Unmarshaler) bool {
-	ret := rt.gocRet(C.gocRtIpldGet(rt.gocArg().cid(c).arg()))
-	if e := o.UnmarshalCBOR(bytes.NewReader(ret.bytes())); e != nil {
+	var value C.Raw
+	rt.gocExit(C.gocRtIpldGetRaw(C.uint64_t(rt.id), gocArg(c.Bytes()), &value))
+	// value is borrowed until next callback, decoder copies what it keeps
+	if e := o.UnmarshalCBOR(bytes.NewReader(cgoArg(value))); e != nil {
 		rt.Abort(ExitFatal)
 	}
 	return true
@@ -355,8 +357,13 @@ func (rt *rt) StorePut(o cbor.Marshaler) cid.Cid {
 	if e := o.MarshalCBOR(w); e != nil {
 		rt.Abort(exitcode.ErrSerialization)
 	}
-	ret := rt.gocRet(C.gocRtIpldPut(rt.gocArg().bytes(w.Bytes()).arg()))
-	return ret.cid()
+	var key C.Raw
+	rt.gocExit(C.gocRtIpldPutRaw(C.uint64_t(rt.id), gocArg(w.Bytes()), &key))
+	c, e := cid.Cast(cgoArg(key))
+	if e != nil {
+		rt.Abort(ExitFatal)
+	}
+	return c
 }
 
 var _ rt1.Message = &rt{}
@@ -662,6 +669,12 @@ func (rt *rt) gocArg() *cborOut {
 	return CborOut().uint(rt.id)
 }
 
+func (rt *rt) gocExit(exit C.int64_t) {
+	if exitcode.ExitCode(exit) != exitcode.Ok {
+		rt.Abort(exitcode.ExitCode(exit))
+	}
+}
+
 func (rt *rt) gocRet(raw C.Raw) *cborIn {
 	ret := CborIn(gocRet(raw))
 	exit := exitcode.ExitCode(ret.int())
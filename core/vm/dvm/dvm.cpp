@@ -47,7 +47,7 @@ namespace fc::dvm {
   }()};
 
   DEFINE(logging){false};
-  DEFINE(Indent::indent_){0};
+  thread_local DEFINE(Indent::indent_){0};
 
   void onCharge(GasAmount gas) {
     if (gas != 0) {
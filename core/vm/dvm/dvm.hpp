@@ -57,7 +57,7 @@ namespace fc::dvm {
 
    private:
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
-    static size_t indent_;
+    static thread_local size_t indent_;
   };
 
   void onIpldGet(const CID &cid, const BytesIn &data);
@@ -14,6 +14,8 @@
 #include "primitives/tipset/load.hpp"
 #include "vm/actor/builtin/methods/cron.hpp"
 #include "vm/actor/builtin/methods/reward.hpp"
+#include "vm/dvm/dvm.hpp"
+#include "vm/interpreter/impl/speculative_execution.hpp"
 #include "vm/runtime/make_vm.hpp"
 #include "vm/toolchain/toolchain.hpp"
 
@@ -194,6 +196,27 @@ namespace fc::vm::interpreter {
 
     nextStep(&metricMessages);
 
+    // dvm log must follow canonical order
+    std::unique_ptr<SpeculativeExecution> speculative;
+    if (speculative_threads != 0 && !dvm::logging) {
+      if (auto runtime_env{std::dynamic_pointer_cast<runtime::Env>(env)}) {
+        std::vector<SpeculativeExecution::Message> messages;
+        MessageVisitor message_visitor{ipld, true, true};
+        for (const auto &block : tipset->blks) {
+          OUTCOME_TRY(message_visitor.visit(
+              block,
+              [&](auto, auto, auto &cid, auto, auto *msg)
+                  -> outcome::result<void> {
+                OUTCOME_TRY(raw, ipld->get(cid));
+                messages.push_back({cid, *msg, raw.size()});
+                return outcome::success();
+              }));
+        }
+        speculative = std::make_unique<SpeculativeExecution>(
+            runtime_env, std::move(messages), speculative_threads);
+      }
+    }
+
     adt::Array<MessageReceipt> receipts{ipld};
     MessageVisitor message_visitor{ipld, true, true};
     for (const auto &block : tipset->blks) {
@@ -201,10 +224,13 @@ namespace fc::vm::interpreter {
           block.miner, 0, 0, block.election_proof.win_count};
       OUTCOME_TRY(message_visitor.visit(
           block,
-          [&](auto, auto bls, auto &cid, auto, auto *msg)
+          [&](auto i, auto bls, auto &cid, auto, auto *msg)
               -> outcome::result<void> {
             OUTCOME_TRY(raw, ipld->get(cid));
-            OUTCOME_TRY(apply, env->applyMessage(*msg, raw.size()));
+            OUTCOME_TRY(apply,
+                        speculative
+                            ? speculative->apply(i, cid, *msg, raw.size())
+                            : env->applyMessage(*msg, raw.size()));
             reward.penalty += apply.penalty;
             reward.gas_reward += apply.reward;
             on_receipt(apply.receipt);
@@ -30,6 +30,9 @@ namespace fc::vm::interpreter {
         const TipsetCPtr &tipset,
         std::vector<MessageReceipt> *all_receipts) const;
 
+    /// Threads to execute messages speculatively, 0 for serial execution
+    size_t speculative_threads{};
+
    private:
     static bool hasDuplicateMiners(const std::vector<BlockHeader> &blocks);
     outcome::result<BigInt> getWeight(const TipsetCPtr &tipset) const;
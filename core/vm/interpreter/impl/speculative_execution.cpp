@@ -0,0 +1,114 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "vm/interpreter/impl/speculative_execution.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "common/prometheus/metrics.hpp"
+
+namespace fc::vm::interpreter {
+  SpeculativeExecution::SpeculativeExecution(std::shared_ptr<Env> env,
+                                             std::vector<Message> messages,
+                                             size_t threads)
+      : env_{std::move(env)},
+        messages_{std::move(messages)},
+        results_(messages_.size()) {
+    static auto &metric{prometheus::BuildCounter()
+                            .Name("vm_speculative_messages")
+                            .Help("Messages executed speculatively")
+                            .Register(prometheusRegistry())
+                            .Add({})};
+    threads = std::max<size_t>(1, std::min(threads, messages_.size()));
+    std::vector<std::shared_ptr<Env>> envs(threads);
+    std::atomic_size_t next{};
+    auto work{[&](size_t thread) {
+      auto _env{Env::make(env_->env_context,
+                          env_->ts_branch,
+                          env_->base_fee,
+                          env_->base_state,
+                          env_->epoch)};
+      if (!_env) {
+        return;
+      }
+      auto &env{envs[thread] = _env.value()};
+      size_t i{};
+      while ((i = next++) < messages_.size()) {
+        const auto &message{messages_[i]};
+        auto &result{results_[i]};
+        env->state_tree =
+            std::make_shared<StateTreeImpl>(env->ipld, env->base_state);
+        env->state_tree->access = std::make_shared<StateTreeImpl::Access>();
+        env->deltas.emplace();
+        try {
+          result.apply = env->applyMessage(message.message, message.size);
+        } catch (...) {
+          // executed again serially
+          continue;
+        }
+        result.state_tree = env->state_tree;
+        result.deltas = std::move(*env->deltas);
+      }
+    }};
+    std::vector<std::thread> workers;
+    for (size_t thread{1}; thread < threads; ++thread) {
+      workers.emplace_back(work, thread);
+    }
+    work(0);
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    metric.Increment(messages_.size());
+    // blocks written by committed messages must be available to flush
+    for (auto &env : envs) {
+      if (env) {
+        env_->ipld->write.putAll(env->ipld->write);
+      }
+    }
+    env_->state_tree->access = std::make_shared<StateTreeImpl::Access>();
+  }
+
+  outcome::result<ApplyRet> SpeculativeExecution::apply(
+      size_t index,
+      const CID &cid,
+      const UnsignedMessage &message,
+      size_t size) {
+    static auto &metric{prometheus::BuildCounter()
+                            .Name("vm_speculative_conflicts")
+                            .Help("Speculative messages executed again")
+                            .Register(prometheusRegistry())
+                            .Add({})};
+    if (index < results_.size() && messages_[index].cid == cid) {
+      auto &result{results_[index]};
+      if (result.apply && result.apply->has_value()
+          && !conflict(*result.state_tree->access)) {
+        auto &state_tree{*env_->state_tree};
+        state_tree.merge(*result.state_tree);
+        for (const auto &[address, delta] : result.deltas) {
+          OUTCOME_TRY(actor, state_tree.get(address));
+          actor.balance += delta;
+          OUTCOME_TRY(state_tree.set(address, actor));
+        }
+        return std::move(result.apply->value());
+      }
+    }
+    ++conflicts;
+    metric.Increment();
+    return env_->applyMessage(message, size);
+  }
+
+  bool SpeculativeExecution::conflict(
+      const StateTreeImpl::Access &access) const {
+    const auto &written{env_->state_tree->access->write};
+    auto any{[&](const std::set<primitives::ActorId> &ids) {
+      return std::any_of(ids.begin(), ids.end(), [&](primitives::ActorId id) {
+        return written.count(id) != 0;
+      });
+    }};
+    return any(access.read) || any(access.write);
+  }
+}  // namespace fc::vm::interpreter
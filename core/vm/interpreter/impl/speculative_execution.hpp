@@ -0,0 +1,58 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "vm/runtime/env.hpp"
+
+namespace fc::vm::interpreter {
+  using message::UnsignedMessage;
+  using runtime::Env;
+  using state::StateTreeImpl;
+
+  /**
+   * Executes tipset messages in parallel, each against the state before all
+   * messages, and records actors each message read and wrote.
+   * Results are committed in canonical order. A message which accessed an
+   * actor written by earlier message or implicit message is executed again
+   * on actual state, so resulting state is the same as of serial execution.
+   * Gas paid to burnt funds and reward actors is collected as balance deltas,
+   * otherwise every message would conflict on them.
+   */
+  class SpeculativeExecution {
+   public:
+    struct Message {
+      CID cid;
+      UnsignedMessage message;
+      size_t size{};
+    };
+
+    /// Executes messages in parallel, env must not have applied messages
+    SpeculativeExecution(std::shared_ptr<Env> env,
+                         std::vector<Message> messages,
+                         size_t threads);
+
+    /// Returns result of message with index, executes it again on conflict
+    outcome::result<ApplyRet> apply(size_t index,
+                                    const CID &cid,
+                                    const UnsignedMessage &message,
+                                    size_t size);
+
+    size_t conflicts{};
+
+   private:
+    struct Result {
+      boost::optional<outcome::result<ApplyRet>> apply;
+      std::shared_ptr<StateTreeImpl> state_tree;
+      std::map<Address, TokenAmount> deltas;
+    };
+
+    bool conflict(const StateTreeImpl::Access &access) const;
+
+    std::shared_ptr<Env> env_;
+    std::vector<Message> messages_;
+    std::vector<Result> results_;
+  };
+}  // namespace fc::vm::interpreter
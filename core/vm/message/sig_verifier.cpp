@@ -0,0 +1,202 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "vm/message/sig_verifier.hpp"
+
+#include "common/error_text.hpp"
+#include "crypto/bls/impl/bls_provider_impl.hpp"
+#include "storage/keystore/keystore.hpp"
+
+namespace fc::vm::message {
+  /// Signatures verified by thread before it takes next part of batch
+  constexpr size_t kSigChunk{16};
+  /// Window of message verifications counted for throttling
+  constexpr std::chrono::seconds kRateWindow{1};
+
+  struct SigVerifier::Batch {
+    gsl::span<const Secp> items;
+    std::atomic_size_t next{};
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t done{};
+    std::error_code error;
+  };
+
+  SigVerifier::SigVerifier(size_t threads,
+                           size_t cache_size,
+                           size_t rate_limit)
+      : rate_limit_{rate_limit}, cache_{cache_size} {
+    for (size_t i{0}; i < threads; ++i) {
+      threads_.emplace_back([this] { loop(); });
+    }
+  }
+
+  SigVerifier::~SigVerifier() {
+    {
+      std::lock_guard lock{queue_mutex_};
+      stop_ = true;
+    }
+    queue_cv_.notify_all();
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+  }
+
+  outcome::result<void> SigVerifier::verify(const Address &key,
+                                            const SignedMessage &smsg) {
+    const auto cid{smsg.getCid()};
+    if (verified(cid, smsg.signature)) {
+      return outcome::success();
+    }
+    countMessage();
+    return verifyCached(cid, key, smsg);
+  }
+
+  outcome::result<void> SigVerifier::verifySecp(gsl::span<const Secp> items) {
+    if (items.empty()) {
+      return outcome::success();
+    }
+    auto batch{std::make_shared<Batch>()};
+    batch->items = items;
+    const auto chunks{(items.size() + kSigChunk - 1) / kSigChunk};
+    const auto helpers{std::min(threads_.size(), chunks - 1)};
+    if (helpers != 0) {
+      {
+        std::lock_guard lock{queue_mutex_};
+        for (size_t i{0}; i < helpers; ++i) {
+          queue_.push_back(batch);
+        }
+      }
+      queue_cv_.notify_all();
+    }
+    work(*batch);
+    std::unique_lock lock{batch->mutex};
+    batch->cv.wait(lock, [&] { return batch->done == items.size(); });
+    if (batch->error) {
+      return batch->error;
+    }
+    return outcome::success();
+  }
+
+  outcome::result<void> SigVerifier::verifyBls(
+      gsl::span<const CID> cids,
+      gsl::span<const crypto::bls::PublicKey> keys,
+      const Signature &_aggregate) {
+    static const crypto::bls::BlsProviderImpl bls;
+    if (!_aggregate.isBls()) {
+      return ERROR_TEXT("SigVerifier: aggregate is not bls");
+    }
+    const auto &aggregate{boost::get<BlsSignature>(_aggregate)};
+    std::vector<BlsSignature> signatures;
+    {
+      std::lock_guard lock{cache_mutex_};
+      for (const auto &cid : cids) {
+        auto signature{cache_.get(cid)};
+        if (!signature || !signature->isBls()) {
+          break;
+        }
+        signatures.push_back(boost::get<BlsSignature>(*signature));
+      }
+    }
+    if (signatures.size() == cids.size()) {
+      OUTCOME_TRY(expected, bls.aggregateSignatures(signatures));
+      if (expected == aggregate) {
+        return outcome::success();
+      }
+    }
+    std::vector<Bytes> messages;
+    messages.reserve(cids.size());
+    for (const auto &cid : cids) {
+      OUTCOME_TRY(bytes, cid.toBytes());
+      messages.push_back(std::move(bytes));
+    }
+    const std::vector<BytesIn> inputs{messages.begin(), messages.end()};
+    OUTCOME_TRY(valid, bls.verifyAggregateSignature(inputs, aggregate, keys));
+    if (!valid) {
+      return ERROR_TEXT("SigVerifier: wrong bls aggregate");
+    }
+    return outcome::success();
+  }
+
+  bool SigVerifier::verified(const CID &cid, const Signature &signature) const {
+    std::lock_guard lock{cache_mutex_};
+    const auto cached{cache_.get(cid)};
+    return cached && *cached == signature;
+  }
+
+  bool SigVerifier::busy() const {
+    std::lock_guard lock{rate_mutex_};
+    return std::chrono::steady_clock::now() - rate_window_ < kRateWindow
+           && rate_count_ > rate_limit_;
+  }
+
+  void SigVerifier::countMessage() {
+    const auto now{std::chrono::steady_clock::now()};
+    std::lock_guard lock{rate_mutex_};
+    if (now - rate_window_ >= kRateWindow) {
+      rate_window_ = now;
+      rate_count_ = 0;
+    }
+    ++rate_count_;
+  }
+
+  outcome::result<void> SigVerifier::verifyCached(const CID &cid,
+                                                  const Address &key,
+                                                  const SignedMessage &smsg) {
+    if (verified(cid, smsg.signature)) {
+      return outcome::success();
+    }
+    OUTCOME_TRY(data, smsg.message.getCid().toBytes());
+    OUTCOME_TRY(valid,
+                storage::keystore::kDefaultKeystore->verify(
+                    key, data, smsg.signature));
+    if (!valid) {
+      return MessageError::kVerificationFailure;
+    }
+    std::lock_guard lock{cache_mutex_};
+    cache_.insert(cid, smsg.signature);
+    return outcome::success();
+  }
+
+  void SigVerifier::work(Batch &batch) {
+    const auto size{batch.items.size()};
+    size_t begin{};
+    while ((begin = batch.next.fetch_add(kSigChunk)) < size) {
+      const auto end{std::min(begin + kSigChunk, size)};
+      std::error_code error;
+      for (auto i{begin}; i < end; ++i) {
+        const auto &item{batch.items[i]};
+        if (auto res{verifyCached(item.cid, item.key, *item.smsg)}; !res) {
+          error = res.error();
+          break;
+        }
+      }
+      std::lock_guard lock{batch.mutex};
+      if (error && !batch.error) {
+        batch.error = error;
+      }
+      batch.done += end - begin;
+      if (batch.done == size) {
+        batch.cv.notify_all();
+      }
+    }
+  }
+
+  void SigVerifier::loop() {
+    while (true) {
+      std::shared_ptr<Batch> batch;
+      {
+        std::unique_lock lock{queue_mutex_};
+        queue_cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+        if (stop_) {
+          return;
+        }
+        batch = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      work(*batch);
+    }
+  }
+}  // namespace fc::vm::message
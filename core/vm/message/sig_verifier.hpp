@@ -0,0 +1,102 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <boost/compute/detail/lru_cache.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "vm/message/message.hpp"
+
+namespace fc::vm::message {
+  using boost::compute::detail::lru_cache;
+  using crypto::signature::BlsSignature;
+
+  /// Verified message signatures kept in lru
+  constexpr size_t kSigCacheSize{32 << 10};
+  /// Uncached message signatures verified per second above which gossip
+  /// messages are throttled
+  constexpr size_t kSigRateLimit{5000};
+
+  /**
+   * Message signature verification shared by mpool, gossip and block
+   * validation.
+   * Secp signatures of block are verified in batches by worker threads and
+   * calling thread. Bls signatures of block are verified as one aggregate.
+   * Verified signatures are kept in lru by message cid, so message received
+   * from gossip is not verified again when it is included in block.
+   */
+  class SigVerifier {
+   public:
+    struct Secp {
+      /** cid of signed message */
+      CID cid;
+      /** resolved key address of sender */
+      Address key;
+      const SignedMessage *smsg{};
+    };
+
+    SigVerifier(size_t threads, size_t cache_size, size_t rate_limit);
+    SigVerifier(const SigVerifier &) = delete;
+    SigVerifier(SigVerifier &&) = delete;
+    ~SigVerifier();
+    SigVerifier &operator=(const SigVerifier &) = delete;
+    SigVerifier &operator=(SigVerifier &&) = delete;
+
+    /** verifies signature of message, key is resolved address of sender */
+    outcome::result<void> verify(const Address &key, const SignedMessage &smsg);
+
+    /** verifies secp signatures on worker threads, returns first error */
+    outcome::result<void> verifySecp(gsl::span<const Secp> items);
+
+    /**
+     * Verifies aggregate of bls signatures of messages.
+     * Compares with aggregate of cached signatures if all messages were
+     * verified before, otherwise checks one pairing.
+     * @param cids - cids of unsigned messages
+     * @param keys - bls public keys of senders
+     */
+    outcome::result<void> verifyBls(
+        gsl::span<const CID> cids,
+        gsl::span<const crypto::bls::PublicKey> keys,
+        const Signature &aggregate);
+
+    /** signature of message with cid was verified */
+    bool verified(const CID &cid, const Signature &signature) const;
+
+    /**
+     * Too many message signatures were verified in last second, gossip
+     * should drop messages. Block signatures are not counted.
+     */
+    bool busy() const;
+
+   private:
+    struct Batch;
+
+    outcome::result<void> verifyCached(const CID &cid,
+                                       const Address &key,
+                                       const SignedMessage &smsg);
+    void countMessage();
+    void work(Batch &batch);
+    void loop();
+
+    size_t rate_limit_;
+    mutable std::mutex rate_mutex_;
+    std::chrono::steady_clock::time_point rate_window_;
+    size_t rate_count_{};
+    mutable std::mutex cache_mutex_;
+    mutable lru_cache<CID, Signature> cache_;
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<std::shared_ptr<Batch>> queue_;
+    bool stop_{false};
+    std::vector<std::thread> threads_;
+  };
+}  // namespace fc::vm::message
@@ -10,6 +10,7 @@
 #include "vm/actor/invoker.hpp"
 #include "vm/runtime/circulating.hpp"
 #include "vm/runtime/env_context.hpp"
+#include "vm/runtime/ipld_buffer.hpp"
 #include "vm/runtime/pricelist.hpp"
 #include "vm/runtime/runtime_randomness.hpp"
 #include "vm/runtime/virtual_machine.hpp"
@@ -29,10 +30,11 @@ namespace fc::vm::runtime {
     outcome::result<bool> contains(const CID &key) const override;
     outcome::result<void> set(const CID &key, BytesCow &&value) override;
     outcome::result<Value> get(const CID &key) const override;
+    outcome::result<SharedBytes> getShared(const CID &key) const override;
 
     IpldPtr ipld;
     // vm only stores "DAG_CBOR blake2b_256" cids
-    std::unordered_map<CbCid, Bytes> write;
+    IpldBuffer write;
     bool flushed{false};
   };
 
@@ -61,6 +63,9 @@ namespace fc::vm::runtime {
     TokenAmount base_fee;
     Pricelist pricelist{0};
     TokenAmount base_circulating;
+    /// If set, gas paid to burnt funds and reward actors is collected here
+    /// instead of state tree, used by speculative execution.
+    boost::optional<std::map<Address, TokenAmount>> deltas;
   };
 
   struct Execution : std::enable_shared_from_this<Execution> {
@@ -97,6 +102,7 @@ namespace fc::vm::runtime {
     }
     outcome::result<void> set(const CID &key, BytesCow &&value) override;
     outcome::result<Value> get(const CID &key) const override;
+    outcome::result<SharedBytes> getShared(const CID &key) const override;
 
     std::weak_ptr<Execution> execution_;
   };
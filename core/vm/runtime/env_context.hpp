@@ -10,6 +10,8 @@
 namespace fc::vm::runtime {
   using actor::Invoker;
   using interpreter::InterpreterCache;
+  using message::SigVerifier;
+  using proofs::SealVerifier;
 
   struct EnvironmentContext {
     IpldPtr ipld;
@@ -19,5 +21,9 @@ namespace fc::vm::runtime {
     std::shared_ptr<InterpreterCache> interpreter_cache{};
     std::shared_ptr<Circulating> circulating{};
     SharedMutexPtr ts_branches_mutex{};
+    /** shared by mpool and block validation, serial verification if null */
+    std::shared_ptr<SigVerifier> sig_verifier{};
+    /** shared by all tipsets, serial verification without cache if null */
+    std::shared_ptr<SealVerifier> seal_verifier{};
   };
 }  // namespace fc::vm::runtime
@@ -6,7 +6,6 @@
 #include "vm/runtime/env.hpp"
 
 #include "cbor_blake/cid.hpp"
-#include "codec/cbor/light_reader/cid.hpp"
 #include "common/prometheus/metrics.hpp"
 #include "common/prometheus/since.hpp"
 #include "vm/actor/builtin/methods/miner.hpp"
@@ -58,29 +57,15 @@ namespace fc::vm::runtime {
     const Since since;
 
     assert(isCbor(root));
-    auto _root{*asBlake(root)};
-    assert(write.count(_root));
-    std::vector<const CbCid *> queue{&_root};
-    std::set<CbCid> visited{_root};
-    size_t next{};
-    while (next < queue.size()) {
-      const auto &key{*queue[next++]};
-      BytesIn value{write.at(key)};
-      BytesIn _cid;
-      while (codec::cbor::findCid(_cid, value)) {
-        const CbCid *cid = nullptr;
-        if (codec::cbor::light_reader::readCborBlake(cid, _cid)) {
-          if (auto it{write.find(*cid)};
-              it != write.end() && visited.emplace(*cid).second) {
-            queue.push_back(&it->first);
-          }
-        }
-      }
-    }
+    const auto queue{write.reachable(*asBlake(root))};
+    assert(!queue.empty());
+    // children before parents
+    std::vector<std::pair<CID, BytesCow>> items;
+    items.reserve(queue.size());
     for (auto it{queue.rbegin()}; it != queue.rend(); ++it) {
-      const auto &key{**it};
-      OUTCOME_TRY(ipld->set(CID{key}, std::move(write.at(key))));
+      items.emplace_back(CID{(*it)->key}, BytesCow{(*it)->value});
     }
+    OUTCOME_TRY(ipld->setMany(std::move(items)));
     write.clear();
 
     metricTime.Increment(since.ms());
@@ -90,7 +75,7 @@ namespace fc::vm::runtime {
   }
 
   outcome::result<bool> IpldBuffered::contains(const CID &cid) const {
-    if (auto it{write.find(*asBlake(cid))}; it != write.end()) {
+    if (isCbor(cid) && write.find(*asBlake(cid))) {
       return true;
     }
     return ipld->contains(cid).value();
@@ -98,20 +83,30 @@ namespace fc::vm::runtime {
 
   outcome::result<void> IpldBuffered::set(const CID &cid, BytesCow &&value) {
     assert(isCbor(cid));
-    write.emplace(*asBlake(cid), value.into());
+    write.put(*asBlake(cid), value);
     return outcome::success();
   }
 
   outcome::result<Ipld::Value> IpldBuffered::get(const CID &cid) const {
     if (isCbor(cid)) {
-      if (auto it{write.find(*asBlake(cid))}; it != write.end()) {
-        return it->second;
+      if (const auto *entry{write.find(*asBlake(cid))}) {
+        return copy(entry->value);
       }
       return ipld->get(cid);
     }
     return storage::ipfs::IpfsDatastoreError::kNotFound;
   }
 
+  outcome::result<SharedBytes> IpldBuffered::getShared(const CID &cid) const {
+    if (isCbor(cid)) {
+      if (const auto *entry{write.find(*asBlake(cid))}) {
+        return std::make_shared<const Bytes>(copy(entry->value));
+      }
+      return ipld->getShared(cid);
+    }
+    return storage::ipfs::IpfsDatastoreError::kNotFound;
+  }
+
   outcome::result<std::shared_ptr<Env>> Env::make(
       const EnvironmentContext &env_context,
       TsBranchPtr ts_branch,
@@ -146,6 +141,13 @@ namespace fc::vm::runtime {
     auto add_locked{
         [&](auto &address, const TokenAmount &add) -> outcome::result<void> {
           if (add != 0) {
+            if (deltas
+                && (address == actor::kBurntFundsActorAddress
+                    || address == kRewardAddress)) {
+              (*deltas)[address] += add;
+              locked -= add;
+              return outcome::success();
+            }
             OUTCOME_TRY(actor, state_tree->get(address));
             actor.balance += add;
             locked -= add;
@@ -438,4 +440,12 @@ namespace fc::vm::runtime {
     dvm::onIpldGet(key, value);
     return std::move(value);
   }
+
+  outcome::result<SharedBytes> ChargingIpld::getShared(const CID &key) const {
+    auto execution{execution_.lock()};
+    OUTCOME_TRY(execution->chargeGas(execution->env->pricelist.onIpldGet()));
+    OUTCOME_TRY(value, execution->env->ipld->getShared(key));
+    dvm::onIpldGet(key, *value);
+    return std::move(value);
+  }
 }  // namespace fc::vm::runtime
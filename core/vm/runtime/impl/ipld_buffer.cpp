@@ -0,0 +1,151 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "vm/runtime/ipld_buffer.hpp"
+
+#include <cstring>
+
+#include "codec/cbor/light_reader/cid.hpp"
+
+namespace fc::vm::runtime {
+  constexpr size_t kChunkSize{1 << 20};
+  constexpr size_t kMinSlots{1 << 10};
+
+  bool IpldBuffer::put(const CbCid &key, BytesIn value) {
+    if (find(key)) {
+      return false;
+    }
+    if ((entries_.size() + 1) * 2 > slots_.size()) {
+      grow();
+    }
+    auto *data{allocate(value.size())};
+    std::copy(value.begin(), value.end(), data);
+    auto &entry{entries_.emplace_back()};
+    entry.key = key;
+    entry.value = BytesIn{data, value.size()};
+    entry.children_begin = children_.size();
+    BytesIn input{entry.value};
+    BytesIn _cid;
+    while (codec::cbor::findCid(_cid, input)) {
+      const CbCid *cid = nullptr;
+      if (codec::cbor::light_reader::readCborBlake(cid, _cid)) {
+        children_.push_back(cid);
+      }
+    }
+    entry.children_end = children_.size();
+    const auto mask{slots_.size() - 1};
+    auto slot{hash(key) & mask};
+    while (slots_[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    slots_[slot] = entries_.size();
+    return true;
+  }
+
+  const IpldBuffer::Entry *IpldBuffer::find(const CbCid &key) const {
+    if (slots_.empty()) {
+      return nullptr;
+    }
+    const auto mask{slots_.size() - 1};
+    for (auto slot{hash(key) & mask}; slots_[slot] != 0;
+         slot = (slot + 1) & mask) {
+      const auto &entry{entries_[slots_[slot] - 1]};
+      if (entry.key == key) {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+  gsl::span<const CbCid *const> IpldBuffer::children(
+      const Entry &entry) const {
+    return gsl::make_span(children_)
+        .subspan(entry.children_begin,
+                 entry.children_end - entry.children_begin);
+  }
+
+  std::vector<const IpldBuffer::Entry *> IpldBuffer::reachable(
+      const CbCid &root) const {
+    std::vector<const Entry *> queue;
+    const auto *entry{find(root)};
+    if (!entry) {
+      return queue;
+    }
+    std::vector<bool> visited(entries_.size());
+    visited[entry - entries_.data()] = true;
+    queue.push_back(entry);
+    size_t next{};
+    while (next < queue.size()) {
+      for (const auto *cid : children(*queue[next++])) {
+        if (const auto *child{find(*cid)}) {
+          const auto index{static_cast<size_t>(child - entries_.data())};
+          if (!visited[index]) {
+            visited[index] = true;
+            queue.push_back(child);
+          }
+        }
+      }
+    }
+    return queue;
+  }
+
+  void IpldBuffer::putAll(const IpldBuffer &other) {
+    for (const auto &entry : other.entries_) {
+      put(entry.key, entry.value);
+    }
+  }
+
+  size_t IpldBuffer::size() const {
+    return entries_.size();
+  }
+
+  bool IpldBuffer::empty() const {
+    return entries_.empty();
+  }
+
+  void IpldBuffer::clear() {
+    chunks_.clear();
+    chunk_left_ = 0;
+    chunk_next_ = nullptr;
+    entries_.clear();
+    children_.clear();
+    slots_.clear();
+  }
+
+  size_t IpldBuffer::hash(const CbCid &key) {
+    // blake2b hash is uniform, its prefix is good enough
+    size_t hash{};
+    std::memcpy(&hash, key.data(), sizeof(hash));
+    return hash;
+  }
+
+  uint8_t *IpldBuffer::allocate(size_t size) {
+    if (size > kChunkSize / 4) {
+      // large value gets own chunk, current chunk continues to be used
+      return chunks_.emplace_back(std::make_unique<uint8_t[]>(size)).get();
+    }
+    if (size > chunk_left_) {
+      chunk_next_ =
+          chunks_.emplace_back(std::make_unique<uint8_t[]>(kChunkSize)).get();
+      chunk_left_ = kChunkSize;
+    }
+    auto *data{chunk_next_};
+    chunk_next_ += size;
+    chunk_left_ -= size;
+    return data;
+  }
+
+  void IpldBuffer::grow() {
+    slots_.assign(std::max(kMinSlots, slots_.size() * 2), 0);
+    const auto mask{slots_.size() - 1};
+    for (size_t i{}; i < entries_.size(); ++i) {
+      auto slot{hash(entries_[i].key) & mask};
+      while (slots_[slot] != 0) {
+        slot = (slot + 1) & mask;
+      }
+      slots_[slot] = i + 1;
+    }
+  }
+}  // namespace fc::vm::runtime
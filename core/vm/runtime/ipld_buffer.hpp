@@ -0,0 +1,62 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "cbor_blake/cid.hpp"
+
+namespace fc::vm::runtime {
+  /**
+   * Blocks written by vm.
+   * Values are copied to arena chunks, keys are in open-addressing table.
+   * Child cids are found when block is put, so reachability walk doesn't
+   * parse values again.
+   */
+  class IpldBuffer {
+   public:
+    struct Entry {
+      CbCid key;
+      BytesIn value;
+      /// range of children_
+      size_t children_begin{};
+      size_t children_end{};
+    };
+
+    /// Puts block if key is absent, returns false if key was present
+    bool put(const CbCid &key, BytesIn value);
+
+    const Entry *find(const CbCid &key) const;
+
+    /// Children cids of entry, pointing into its value
+    gsl::span<const CbCid *const> children(const Entry &entry) const;
+
+    /// Buffered blocks reachable from root, in breadth-first order
+    std::vector<const Entry *> reachable(const CbCid &root) const;
+
+    /// Puts all blocks of other buffer
+    void putAll(const IpldBuffer &other);
+
+    size_t size() const;
+    bool empty() const;
+    void clear();
+
+   private:
+    static size_t hash(const CbCid &key);
+
+    uint8_t *allocate(size_t size);
+    void grow();
+
+    std::vector<std::unique_ptr<uint8_t[]>> chunks_;
+    size_t chunk_left_{};
+    uint8_t *chunk_next_{};
+    std::vector<Entry> entries_;
+    std::vector<const CbCid *> children_;
+    /// entry index + 1, 0 for empty slot
+    std::vector<uint32_t> slots_;
+  };
+}  // namespace fc::vm::runtime
@@ -33,6 +33,9 @@ namespace fc::vm::state {
                                            const Actor &actor) {
     OUTCOME_TRY(address_id, lookupId(address));
     dvm::onActor(*this, address, actor);
+    if (access) {
+      access->write.insert(address_id.getId());
+    }
     setActor(address_id.getId(), actor);
     return outcome::success();
   }
@@ -43,6 +46,9 @@ namespace fc::vm::state {
     if (!id) {
       return boost::none;
     }
+    if (access) {
+      access->read.insert(id->getId());
+    }
     for (auto it{tx_.rbegin()}; it != tx_.rend(); ++it) {
       if (it->removed.count(id->getId()) != 0) {
         return boost::none;
@@ -114,6 +120,9 @@ namespace fc::vm::state {
 
   outcome::result<void> StateTreeImpl::remove(const Address &address) {
     OUTCOME_TRY(address_id, lookupId(address));
+    if (access) {
+      access->write.insert(address_id.getId());
+    }
     tx_.back().removed.insert(address_id.getId());
     return outcome::success();
   }
@@ -142,6 +151,25 @@ namespace fc::vm::state {
     }
   }
 
+  void StateTreeImpl::merge(const StateTreeImpl &other) {
+    assert(tx_.size() == 1);
+    assert(other.tx_.size() == 1);
+    const auto &top{other.tx_.back()};
+    for (const auto &[id, actor] : top.actors) {
+      setActor(id, actor);
+    }
+    for (const auto &[address, id] : top.lookup) {
+      tx_.back().lookup[address] = id;
+    }
+    for (auto id : top.removed) {
+      tx_.back().removed.insert(id);
+    }
+    if (access && other.access) {
+      access->write.insert(other.access->write.begin(),
+                           other.access->write.end());
+    }
+  }
+
   void StateTreeImpl::setActor(ActorId id, const Actor &actor) const {
     tx_.back().actors[id] = actor;
     tx_.back().removed.erase(id);
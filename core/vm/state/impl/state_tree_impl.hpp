@@ -21,6 +21,12 @@ namespace fc::vm::state {
       std::set<ActorId> removed;
     };
 
+    /// Actors read and written through tree, for conflict detection.
+    struct Access {
+      std::set<ActorId> read;
+      std::set<ActorId> write;
+    };
+
     explicit StateTreeImpl(const std::shared_ptr<IpfsDatastore> &store);
     StateTreeImpl(std::shared_ptr<IpfsDatastore> store, const CID &root);
     /// Set actor state, does not write to storage
@@ -50,6 +56,12 @@ namespace fc::vm::state {
     /// Removes snapshot layer and merges changes to the previous layer.
     void txEnd() override;
 
+    /// Applies changes of other tree made on top of the same root.
+    void merge(const StateTreeImpl &other);
+
+    /// Records accessed actors if set
+    std::shared_ptr<Access> access;
+
    private:
     void setActor(ActorId id, const Actor &actor) const;
     /**
@@ -0,0 +1,140 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "api/rpc/broadcast.hpp"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <chrono>
+
+#include "testutil/literals.hpp"
+
+namespace fc::api::rpc {
+  using primitives::ChainEpoch;
+  using primitives::block::BlockHeader;
+  using primitives::jwt::kReadPermission;
+  using primitives::tipset::HeadChange;
+  using primitives::tipset::HeadChangeType;
+  using primitives::tipset::Tipset;
+
+  struct Sent {
+    std::string method;
+    SharedChanValue value;
+    OkCb cb;
+  };
+
+  /** subscribes fake session, which records sent values */
+  inline void subscribe(const std::shared_ptr<Broadcast> &broadcast,
+                        uint64_t chan,
+                        std::vector<Sent> &sent) {
+    boost::optional<uint64_t> id;
+    broadcast->method()(
+        Document{},
+        [&](auto result) {
+          id = codec::json::decode<uint64_t>(boost::get<Document>(result))
+                   .value();
+        },
+        [chan] { return chan; },
+        [&](auto method, auto params, auto cb) {
+          sent.push_back({method,
+                          boost::get<SharedChanValue>(params),
+                          std::move(cb)});
+        },
+        kDefaultPermission);
+    EXPECT_EQ(id, chan);
+  }
+
+  /**
+   * @given broadcast with initial value and two subscribed sessions
+   * @when values are written
+   * @then sessions get initial value and same encoded buffer of value,
+   * session which failed write is unsubscribed
+   */
+  TEST(RpcBroadcastTest, SharedJson) {
+    auto broadcast{std::make_shared<Broadcast>(
+        kReadPermission, [] { return Broadcast::encode(std::vector<int>{0}); })};
+    std::vector<Sent> sent1, sent2;
+    subscribe(broadcast, 1, sent1);
+    subscribe(broadcast, 2, sent2);
+    EXPECT_EQ(broadcast->size(), 2);
+    ASSERT_EQ(sent1.size(), 1);
+    EXPECT_EQ(sent1[0].method, kRpcChVal);
+    EXPECT_EQ(sent1[0].value.chan, 1);
+    EXPECT_EQ(common::span::bytestr(*sent1[0].value.json), "[0]");
+
+    broadcast->write(std::vector<int>{1, 2});
+    ASSERT_EQ(sent1.size(), 2);
+    ASSERT_EQ(sent2.size(), 2);
+    EXPECT_EQ(sent1[1].value.json, sent2[1].value.json);
+    EXPECT_EQ(sent2[1].value.chan, 2);
+    EXPECT_EQ(common::span::bytestr(*sent2[1].value.json), "[1,2]");
+
+    sent1[1].cb(false);
+    broadcast->write(std::vector<int>{3});
+    EXPECT_EQ(sent1.size(), 2);
+    EXPECT_EQ(sent2.size(), 3);
+    EXPECT_EQ(broadcast->size(), 1);
+  }
+
+  /**
+   * Reports cost of head change for subscriber count, when each session
+   * encodes head change and when it is encoded once.
+   */
+  TEST(RpcBroadcastTest, DISABLED_HeadChangeCost) {
+    std::vector<HeadChange> changes;
+    for (ChainEpoch height{0}; height < 4; ++height) {
+      BlockHeader block;
+      block.miner = primitives::address::Address::makeFromId(1000);
+      block.ticket = primitives::block::Ticket{Bytes(96, 1)};
+      block.parents = {CbCid::hash("01"_unhex)};
+      block.height = height;
+      block.parent_state_root = "010001020005"_cid;
+      block.parent_message_receipts = "010001020006"_cid;
+      block.messages = "010001020007"_cid;
+      changes.push_back(
+          {HeadChangeType::APPLY, Tipset::create({block}).value()});
+    }
+    const auto report{[&](std::string_view name, size_t sessions, auto &&f) {
+      constexpr size_t kChanges{100};
+      size_t bytes{};
+      const auto start{std::chrono::steady_clock::now()};
+      for (size_t i{0}; i < kChanges; ++i) {
+        bytes += f();
+      }
+      const std::chrono::duration<double, std::micro> us{
+          std::chrono::steady_clock::now() - start};
+      fmt::print("{} sessions={} {:.0f}us/change {}bytes/change\n",
+                 name,
+                 sessions,
+                 us.count() / kChanges,
+                 bytes / kChanges);
+    }};
+    for (const size_t sessions : {1, 10, 100, 500}) {
+      report("each", sessions, [&] {
+        size_t bytes{};
+        for (uint64_t i{0}; i < sessions; ++i) {
+          const Request request{
+              i, kRpcChVal, codec::json::encode(std::make_tuple(i, changes))};
+          bytes += codec::json::format(codec::json::encode(request))->size();
+        }
+        return bytes;
+      });
+      report("once", sessions, [&] {
+        const auto json{Broadcast::encode(changes)};
+        size_t bytes{json->size()};
+        for (uint64_t i{0}; i < sessions; ++i) {
+          // head of request spliced by session
+          bytes += fmt::format(
+                       R"({{"jsonrpc":"2.0","id":{},"method":"{}","params":[{},)",
+                       i,
+                       kRpcChVal,
+                       i)
+                       .size();
+        }
+        return bytes;
+      });
+    }
+  }
+}  // namespace fc::api::rpc
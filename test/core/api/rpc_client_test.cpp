@@ -0,0 +1,198 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "api/rpc/wsc.hpp"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <future>
+
+#include "api/rpc/ws.hpp"
+#include "codec/json/json.hpp"
+#include "common/io_thread.hpp"
+
+namespace fc::api::rpc {
+  using Result = outcome::result<Document>;
+  using std::chrono::milliseconds;
+
+  struct RpcClientTest : testing::Test {
+    void SetUp() override {
+      rpc->setup(
+          "Echo", [](const Value &params, auto respond, auto, auto, auto &) {
+            Document result;
+            result.CopyFrom(params[0], result.GetAllocator());
+            respond(std::move(result));
+          });
+      rpc->setup("Sub",
+                 [](const Value &params,
+                    auto respond,
+                    auto make_chan,
+                    auto send,
+                    auto &) {
+                   const auto chan{make_chan()};
+                   respond(codec::json::encode(chan));
+                   for (auto i{0}; i < params[0].GetInt(); ++i) {
+                     send(kRpcChVal,
+                          codec::json::encode(std::make_tuple(chan, i)),
+                          {});
+                   }
+                   send(kRpcChClose,
+                        codec::json::encode(std::make_tuple(chan)),
+                        {});
+                 });
+      std::map<std::string, std::shared_ptr<Rpc>> rpcs;
+      rpcs.emplace("/rpc/v0", rpc);
+      serve(rpcs, std::make_shared<Routes>(), *io.io, "127.0.0.1", kPort);
+    }
+
+    template <typename T>
+    static Request request(const std::string &method, const T &param) {
+      Request req{};
+      req.method = method;
+      req.params = codec::json::encode(std::make_tuple(param));
+      return req;
+    }
+
+    static auto promise() {
+      return std::make_shared<std::promise<Result>>();
+    }
+
+    static Client::ResultCb resolve(
+        const std::shared_ptr<std::promise<Result>> &promise) {
+      return [promise](auto result) { promise->set_value(std::move(result)); };
+    }
+
+    std::unique_ptr<Client> connect(size_t connections) {
+      auto client{std::make_unique<Client>(*io.io, connections)};
+      EXPECT_TRUE(
+          client->connect("127.0.0.1", std::to_string(kPort), "/rpc/v0", "")
+              .has_value());
+      return client;
+    }
+
+    static constexpr auto kPort{12346};
+    IoThread io;
+    std::shared_ptr<Rpc> rpc{std::make_shared<Rpc>()};
+  };
+
+  /**
+   * @given client with pool of connections
+   * @when many calls are made without waiting for responses
+   * @then each call gets own response
+   */
+  TEST_F(RpcClientTest, Pool) {
+    auto client{connect(4)};
+    std::vector<std::future<Result>> futures;
+    for (auto i{0}; i < 100; ++i) {
+      auto result{promise()};
+      futures.push_back(result->get_future());
+      client->call(request("Echo", i), resolve(result));
+    }
+    for (auto i{0}; i < 100; ++i) {
+      auto result{futures[i].get()};
+      ASSERT_TRUE(result);
+      EXPECT_EQ(codec::json::decode<int>(result.value()).value(), i);
+    }
+  }
+
+  /**
+   * @given client
+   * @when calls are sent as one batch, one of them is unknown
+   * @then each call gets own response or error
+   */
+  TEST_F(RpcClientTest, Batch) {
+    auto client{connect(1)};
+    std::vector<std::pair<Request, Client::ResultCb>> calls;
+    std::vector<std::future<Result>> futures;
+    for (const auto &method : {"Echo", "Unknown", "Echo"}) {
+      auto result{promise()};
+      futures.push_back(result->get_future());
+      calls.emplace_back(request(method, futures.size()), resolve(result));
+    }
+    client->batch(std::move(calls));
+    auto result1{futures[0].get()};
+    ASSERT_TRUE(result1);
+    EXPECT_EQ(codec::json::decode<int>(result1.value()).value(), 1);
+    EXPECT_FALSE(futures[1].get());
+    auto result3{futures[2].get()};
+    ASSERT_TRUE(result3);
+    EXPECT_EQ(codec::json::decode<int>(result3.value()).value(), 3);
+  }
+
+  /**
+   * @given client with pool of connections
+   * @when method returning channel is called
+   * @then channel values are received until channel is closed
+   */
+  TEST_F(RpcClientTest, Chan) {
+    auto client{connect(4)};
+    std::promise<std::vector<int>> done;
+    std::vector<int> values;
+    client->_callChan(request("Sub", 3), [&](auto result) {
+      ASSERT_TRUE(result);
+      client->_chan(codec::json::decode<uint64_t>(result.value()).value(),
+                    [&](auto value) {
+                      if (!value) {
+                        done.set_value(values);
+                        return false;
+                      }
+                      values.push_back(
+                          codec::json::decode<int>(*value).value());
+                      return true;
+                    });
+    });
+    auto future{done.get_future()};
+    ASSERT_EQ(future.wait_for(milliseconds{1000}), std::future_status::ready);
+    EXPECT_EQ(future.get(), (std::vector<int>{0, 1, 2}));
+  }
+
+  /**
+   * Reports round-trip latency of small calls and throughput over loopback,
+   * while large calls are in flight, for different connection counts.
+   */
+  TEST_F(RpcClientTest, DISABLED_Loopback) {
+    const Bytes small(16, 1);
+    const Bytes large(1 << 20, 1);
+    for (const size_t connections : {1, 4}) {
+      auto client{connect(connections)};
+      constexpr size_t kCalls{1000};
+      std::vector<double> latency;
+      std::vector<std::future<Result>> large_futures;
+      const auto start{std::chrono::steady_clock::now()};
+      for (size_t i{0}; i < kCalls; ++i) {
+        if (i % 20 == 0) {
+          auto result{promise()};
+          large_futures.push_back(result->get_future());
+          client->call(request("Echo", large), resolve(result));
+        }
+        const auto call_start{std::chrono::steady_clock::now()};
+        auto result{promise()};
+        auto future{result->get_future()};
+        client->call(request("Echo", small), resolve(result));
+        future.get();
+        const std::chrono::duration<double, std::milli> ms{
+            std::chrono::steady_clock::now() - call_start};
+        latency.push_back(ms.count());
+      }
+      for (auto &future : large_futures) {
+        future.get();
+      }
+      const std::chrono::duration<double> seconds{
+          std::chrono::steady_clock::now() - start};
+      std::sort(latency.begin(), latency.end());
+      fmt::print(
+          "connections={} small p50={:.3f}ms p99={:.3f}ms, {:.0f}calls/s "
+          "{:.1f}MB/s\n",
+          connections,
+          latency[kCalls / 2],
+          latency[kCalls * 99 / 100],
+          (kCalls + large_futures.size()) / seconds.count(),
+          2.0 * large.size() * large_futures.size() / (1 << 20)
+              / seconds.count());
+    }
+  }
+}  // namespace fc::api::rpc
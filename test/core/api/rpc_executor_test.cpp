@@ -0,0 +1,287 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "api/rpc/executor.hpp"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <chrono>
+#include <future>
+
+#include "adt/array.hpp"
+#include "api/full_node/make.hpp"
+#include "api/rpc/make.hpp"
+#include "cbor_blake/ipld_cbor.hpp"
+#include "cbor_blake/ipld_version.hpp"
+#include "primitives/tipset/load.hpp"
+#include "storage/chain/msg_waiter.hpp"
+#include "storage/ipfs/impl/in_memory_datastore.hpp"
+#include "vm/state/impl/state_tree_impl.hpp"
+
+namespace fc::api::rpc {
+  using primitives::block::MsgMeta;
+  using primitives::block::Ticket;
+  using primitives::jwt::kReadPermission;
+  using primitives::jwt::kWritePermission;
+  using primitives::tipset::Tipset;
+  using primitives::tipset::TsLoadIpld;
+  using std::chrono::milliseconds;
+  using storage::blockchain::MsgWaiter;
+
+  struct RpcExecutorTest : testing::Test {
+    /** method which responds after sleep */
+    void sleeping(const std::string &name,
+                  const Permission &perm,
+                  milliseconds sleep) {
+      rpc.setup(
+          name,
+          [this, sleep](auto &, auto respond, auto, auto, auto &) {
+            const auto now{++running};
+            auto max{max_running.load()};
+            while (now > max && !max_running.compare_exchange_weak(max, now)) {
+            }
+            std::this_thread::sleep_for(sleep);
+            --running;
+            respond(Document{});
+          },
+          perm);
+    }
+
+    /** calls method, future is set when it responds */
+    std::future<bool> call(const std::string &name, const Document &params) {
+      auto promise{std::make_shared<std::promise<bool>>()};
+      auto future{promise->get_future()};
+      rpc.ms.at(name)(
+          params,
+          [promise](auto result) {
+            promise->set_value(boost::get<Document>(&result) != nullptr);
+          },
+          {},
+          {},
+          kDefaultPermission);
+      return future;
+    }
+
+    std::future<bool> call(const std::string &name) {
+      return call(name, Document{});
+    }
+
+    Rpc rpc;
+    std::atomic_size_t running{};
+    std::atomic_size_t max_running{};
+    std::shared_ptr<io_context> serial{std::make_shared<io_context>()};
+  };
+
+  /**
+   * @given slow and fast read methods, slow method limited to one call
+   * @when slow method is called many times
+   * @then slow calls run one by one, fast call doesn't wait for them
+   */
+  TEST_F(RpcExecutorTest, MethodLimit) {
+    sleeping("Slow", kReadPermission, milliseconds{100});
+    rpc.setup(
+        "Fast",
+        [](auto &, auto respond, auto, auto, auto &) { respond(Document{}); },
+        kReadPermission);
+    Executor executor{4, kRpcQueueLimit, serial};
+    executor.limit("Slow", 1);
+    executor.parallel("Slow");
+    executor.parallel("Fast");
+    executor.wrap(rpc);
+
+    std::vector<std::future<bool>> slow;
+    for (auto i{0}; i < 3; ++i) {
+      slow.push_back(call("Slow"));
+    }
+    auto fast{call("Fast")};
+    EXPECT_EQ(fast.wait_for(milliseconds{50}), std::future_status::ready);
+    EXPECT_TRUE(fast.get());
+    for (auto &future : slow) {
+      EXPECT_TRUE(future.get());
+    }
+    EXPECT_EQ(max_running, 1);
+  }
+
+  /**
+   * @given write method and read method not allowed to run in parallel
+   * @when they are called
+   * @then they run on serial io_context
+   */
+  TEST_F(RpcExecutorTest, NotAllowedOnSerial) {
+    sleeping("Write", kWritePermission, milliseconds{0});
+    sleeping("Read", kReadPermission, milliseconds{0});
+    Executor executor{4, kRpcQueueLimit, serial};
+    executor.wrap(rpc);
+
+    auto write{call("Write")};
+    auto read{call("Read")};
+    EXPECT_EQ(write.wait_for(milliseconds{50}), std::future_status::timeout);
+    EXPECT_EQ(read.wait_for(milliseconds{0}), std::future_status::timeout);
+    serial->run();
+    EXPECT_TRUE(write.get());
+    EXPECT_TRUE(read.get());
+    EXPECT_EQ(parallelMethods().count("Filecoin.NetPeers"), 0);
+    EXPECT_EQ(parallelMethods().count("Filecoin.StateListMessages"), 1);
+  }
+
+  /**
+   * @given executor with small queue
+   * @when more calls than queue and workers can take are made
+   * @then calls above limit are rejected
+   */
+  TEST_F(RpcExecutorTest, QueueLimit) {
+    sleeping("Slow", kReadPermission, milliseconds{100});
+    Executor executor{1, 2, serial};
+    executor.parallel("Slow");
+    executor.wrap(rpc);
+
+    std::vector<std::future<bool>> calls;
+    calls.push_back(call("Slow"));
+    // wait until worker takes first call
+    while (executor.queued() != 0) {
+      std::this_thread::yield();
+    }
+    for (auto i{0}; i < 3; ++i) {
+      calls.push_back(call("Slow"));
+    }
+    EXPECT_FALSE(calls.back().get());
+    calls.pop_back();
+    for (auto &future : calls) {
+      EXPECT_TRUE(future.get());
+    }
+  }
+
+  /**
+   * Reports latency of ChainGetBlock mixed with StateListMessages walking
+   * chain, when methods run on serial io_context and on executor.
+   * Methods run on workers only if production allows them.
+   */
+  TEST_F(RpcExecutorTest, DISABLED_MixedLoad) {
+    struct ChainStore : storage::blockchain::ChainStore {
+      outcome::result<void> addBlock(const BlockHeader &) override {
+        throw "unused";
+      }
+      TipsetCPtr heaviestTipset() const override {
+        throw "unused";
+      }
+      connection_t subscribeHeadChanges(
+          const std::function<HeadChangeSignature> &subscriber) override {
+        return signal.connect(subscriber);
+      }
+      primitives::BigInt getHeaviestWeight() const override {
+        throw "unused";
+      }
+      boost::signals2::signal<HeadChangeSignature> signal;
+    };
+
+    // chain of tipsets with messages, waiter without index walks them
+    constexpr size_t kTipsets{200};
+    constexpr size_t kMessages{20};
+    IpldPtr ipld{std::make_shared<storage::ipfs::InMemoryDatastore>()};
+    const auto ts_load{std::make_shared<TsLoadIpld>(ipld)};
+    vm::state::StateTreeImpl tree{withVersion(ipld, ChainEpoch{0})};
+    const auto state_root{tree.flush().value()};
+    const auto receipts{
+        adt::Array<MessageReceipt>{ipld}.amt.flush().value()};
+    UnsignedMessage match;
+    match.from = Address::makeFromId(100);
+    match.to = Address::makeFromId(101);
+    TipsetCPtr head;
+    uint64_t nonce{};
+    for (size_t i{0}; i < kTipsets; ++i) {
+      MsgMeta meta;
+      cbor_blake::cbLoadT(ipld, meta);
+      for (size_t j{0}; j < kMessages; ++j) {
+        auto message{match};
+        message.nonce = nonce++;
+        ASSERT_TRUE(meta.bls_messages.append(setCbor(ipld, message).value()));
+      }
+      BlockHeader block;
+      block.miner = Address::makeFromId(0);
+      block.ticket = Ticket{Bytes(96, 0)};
+      if (head) {
+        block.parents.assign(head->key.cids().begin(),
+                             head->key.cids().end());
+        block.height = head->epoch() + 1;
+      }
+      block.parent_state_root = state_root;
+      block.parent_message_receipts = receipts;
+      block.messages = setCbor(ipld, meta).value();
+      ASSERT_TRUE(setCbor(ipld, block));
+      head = Tipset::create({block}).value();
+    }
+    const auto io{std::make_shared<io_context>()};
+    const auto chain_store{std::make_shared<ChainStore>()};
+    const auto waiter{MsgWaiter::create(ts_load, ipld, io, chain_store)};
+    vm::runtime::EnvironmentContext env_context;
+    env_context.ipld = ipld;
+    env_context.ts_load = ts_load;
+    const auto api{makeImpl(
+        std::make_shared<FullNodeApi>(),
+        nullptr,
+        nullptr,
+        "",
+        nullptr,
+        env_context,
+        nullptr,
+        nullptr,
+        waiter,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+        [&](const TipsetKey &tsk, bool) -> outcome::result<TipsetContext> {
+          OUTCOME_TRY(ts, ts_load->load(tsk));
+          return TipsetContext{
+              ts,
+              {withVersion(ipld, ts->epoch()), ts->getParentStateRoot()},
+              boost::none};
+        })};
+    const auto methods{makeRpc(*api)->ms};
+    const auto list_params{
+        codec::json::encode(std::make_tuple(match, head->key, 0))};
+    const auto block_params{
+        codec::json::encode(std::make_tuple(CID{head->key.cids()[0]}))};
+
+    for (const size_t threads : {0, 2, 4, 8}) {
+      rpc.ms = methods;
+      auto serial{std::make_shared<io_context>()};
+      auto work{boost::asio::make_work_guard(*serial)};
+      std::thread serial_thread{[&] { serial->run(); }};
+      Executor executor{threads, kRpcQueueLimit, serial};
+      executor.wrap(rpc);
+
+      constexpr size_t kFast{1000};
+      std::vector<double> latency;
+      std::vector<std::future<bool>> slow;
+      for (size_t i{0}; i < kFast; ++i) {
+        if (i % 50 == 0) {
+          slow.push_back(call("Filecoin.StateListMessages", list_params));
+        }
+        const auto start{std::chrono::steady_clock::now()};
+        EXPECT_TRUE(call("Filecoin.ChainGetBlock", block_params).get());
+        const std::chrono::duration<double, std::milli> ms{
+            std::chrono::steady_clock::now() - start};
+        latency.push_back(ms.count());
+      }
+      for (auto &future : slow) {
+        EXPECT_TRUE(future.get());
+      }
+      work.reset();
+      serial_thread.join();
+      std::sort(latency.begin(), latency.end());
+      fmt::print("threads={} fast p50={:.3f}ms p99={:.3f}ms max={:.3f}ms\n",
+                 threads,
+                 latency[kFast / 2],
+                 latency[kFast * 99 / 100],
+                 latency.back());
+    }
+  }
+}  // namespace fc::api::rpc
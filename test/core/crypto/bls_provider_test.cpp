@@ -82,3 +82,33 @@ TEST_F(BlsProviderTest, DifferentMessageVerificationFailure) {
                           different_message, signature, key_pair.public_key));
   ASSERT_FALSE(signature_status);
 }
+
+/**
+ * @given Messages signed by different keys
+ * @when Verifying aggregated signature
+ * @then Aggregate is valid for all messages, invalid if message is changed
+ */
+TEST_F(BlsProviderTest, VerifyAggregateSignature) {
+  std::vector<std::vector<uint8_t>> messages;
+  std::vector<PublicKey> keys;
+  std::vector<Signature> signatures;
+  for (uint8_t i{0}; i < 3; ++i) {
+    EXPECT_OUTCOME_TRUE(key_pair, provider_.generateKeyPair());
+    auto &message{messages.emplace_back(message_)};
+    message.push_back(i);
+    EXPECT_OUTCOME_TRUE(signature,
+                        provider_.sign(message, key_pair.private_key));
+    keys.push_back(key_pair.public_key);
+    signatures.push_back(signature);
+  }
+  EXPECT_OUTCOME_TRUE(aggregate, provider_.aggregateSignatures(signatures));
+  std::vector<fc::BytesIn> inputs{messages.begin(), messages.end()};
+  EXPECT_OUTCOME_TRUE(
+      valid, provider_.verifyAggregateSignature(inputs, aggregate, keys));
+  ASSERT_TRUE(valid);
+
+  messages[1].back() = 0xff;
+  EXPECT_OUTCOME_TRUE(
+      invalid, provider_.verifyAggregateSignature(inputs, aggregate, keys));
+  ASSERT_FALSE(invalid);
+}
@@ -0,0 +1,225 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "node/blocksync_server.hpp"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <chrono>
+
+#include "cbor_blake/ipld_any.hpp"
+#include "cbor_blake/ipld_cbor.hpp"
+#include "cbor_blake/memory.hpp"
+#include "testutil/literals.hpp"
+
+namespace fc::sync::blocksync {
+  using crypto::signature::Secp256k1Signature;
+  using primitives::ChainEpoch;
+  using primitives::address::Address;
+  using primitives::block::MsgMeta;
+  using primitives::block::Ticket;
+
+  struct BlocksyncServerTest : testing::Test {
+    static UnsignedMessage message(uint64_t nonce) {
+      return {Address::makeFromId(1),
+              Address::makeFromId(2),
+              nonce,
+              0,
+              0,
+              0,
+              0,
+              {}};
+    }
+
+    CbCid makeBlock(ChainEpoch height,
+                    uint64_t miner,
+                    const std::vector<CbCid> &parents,
+                    const std::vector<UnsignedMessage> &messages) {
+      MsgMeta meta;
+      cbor_blake::cbLoadT(ipld, meta);
+      for (const auto &message : messages) {
+        if (message.nonce % 2 == 0) {
+          EXPECT_TRUE(
+              meta.bls_messages.append(setCbor(ipld, message).value()));
+        } else {
+          EXPECT_TRUE(meta.secp_messages.append(
+              setCbor(ipld, SignedMessage{message, Secp256k1Signature{}})
+                  .value()));
+        }
+      }
+      BlockHeader block;
+      block.miner = Address::makeFromId(miner);
+      block.ticket = Ticket{Bytes(96, miner)};
+      block.parents.assign(parents.begin(), parents.end());
+      block.height = height;
+      block.parent_state_root = block.parent_message_receipts =
+          "010001020005"_cid;
+      block.messages = setCbor(ipld, meta).value();
+      return cbipld->put(codec::cbor::encode(block).value());
+    }
+
+    /** makes chain of tipsets, both blocks of tipset include same messages */
+    std::vector<CbCid> makeChain(ChainEpoch length, uint64_t messages) {
+      std::vector<CbCid> tsk;
+      for (ChainEpoch height{0}; height < length; ++height) {
+        std::vector<UnsignedMessage> msgs;
+        for (uint64_t i{0}; i < messages; ++i) {
+          msgs.push_back(message(height * messages + i));
+        }
+        std::vector<CbCid> next;
+        for (const auto miner : {0, 1}) {
+          next.push_back(makeBlock(height, miner, tsk, msgs));
+        }
+        tsk = std::move(next);
+      }
+      return tsk;
+    }
+
+    template <typename T>
+    void visitMessages(adt::Array<CID> &amt,
+                       std::vector<T> &messages,
+                       MsgIncudes &includes) {
+      std::map<CID, size_t> visited;
+      auto &indices{includes.emplace_back()};
+      EXPECT_TRUE(amt.visit([&](auto, const CID &cid) {
+        auto index{visited.find(cid)};
+        if (index == visited.end()) {
+          index = visited.emplace(cid, messages.size()).first;
+          messages.push_back(getCbor<T>(ipld, cid).value());
+        }
+        indices.push_back(index->second);
+        return outcome::success();
+      }));
+    }
+
+    /** response built by decoding blocks and messages */
+    Bytes encodeDecoded(const Request &request) {
+      Response response;
+      response.status = ResponseStatus::kResponseComplete;
+      std::vector<CbCid> tsk{request.block_cids};
+      while (response.chain.size() < request.depth) {
+        TipsetBundle bundle;
+        TipsetBundle::Messages msgs;
+        ChainEpoch height{};
+        for (const auto &cid : tsk) {
+          auto block{getCbor<BlockHeader>(ipld, CID{cid}).value()};
+          auto meta{getCbor<MsgMeta>(ipld, block.messages).value()};
+          visitMessages(
+              meta.bls_messages, msgs.bls_msgs, msgs.bls_msg_includes);
+          visitMessages(
+              meta.secp_messages, msgs.secp_msgs, msgs.secp_msg_includes);
+          height = block.height;
+          tsk = block.parents;
+          bundle.blocks.push_back(std::move(block));
+        }
+        if (!(request.options & kBlocksOnly)) {
+          bundle.blocks.clear();
+        }
+        if (request.options & kMessagesOnly) {
+          bundle.messages = std::move(msgs);
+        }
+        response.chain.push_back(std::move(bundle));
+        if (height == 0) {
+          break;
+        }
+      }
+      return codec::cbor::encode(response).value();
+    }
+
+    std::shared_ptr<MemoryCbIpld> cbipld{std::make_shared<MemoryCbIpld>()};
+    IpldPtr ipld{std::make_shared<CbAsAnyIpld>(cbipld)};
+  };
+
+  /**
+   * @given chain with messages
+   * @when response is encoded with different options
+   * @then spliced response is same as encoded from decoded objects
+   */
+  TEST_F(BlocksyncServerTest, Splice) {
+    const auto head{makeChain(5, 3)};
+    for (const auto options :
+         {kBlocksOnly, kMessagesOnly, kBlocksAndMessages}) {
+      const Request request{head, 3, options};
+      Bytes out;
+      EXPECT_TRUE(encodeResponse(cbipld, request, out));
+      EXPECT_EQ(out, encodeDecoded(request));
+      const auto response{codec::cbor::decode<Response>(out).value()};
+      EXPECT_EQ(response.status, ResponseStatus::kResponseComplete);
+      EXPECT_EQ(response.chain.size(), 3);
+    }
+  }
+
+  /**
+   * @given chain shorter than requested depth
+   * @when response is encoded
+   * @then response is complete and ends with genesis
+   */
+  TEST_F(BlocksyncServerTest, Genesis) {
+    const Request request{makeChain(5, 2), 10, kBlocksAndMessages};
+    Bytes out;
+    EXPECT_TRUE(encodeResponse(cbipld, request, out));
+    EXPECT_EQ(out, encodeDecoded(request));
+    const auto response{codec::cbor::decode<Response>(out).value()};
+    EXPECT_EQ(response.status, ResponseStatus::kResponseComplete);
+    EXPECT_EQ(response.chain.size(), 5);
+  }
+
+  /**
+   * @given chain with missing message and unknown tipset
+   * @when responses are encoded
+   * @then they are reported as not found, so they are not cached
+   */
+  TEST_F(BlocksyncServerTest, NotFound) {
+    const auto head{makeChain(3, 2)};
+    Bytes out;
+    EXPECT_FALSE(encodeResponse(
+        cbipld, {{CbCid::hash("00"_unhex)}, 1, kBlocksAndMessages}, out));
+    EXPECT_EQ(codec::cbor::decode<Response>(out).value().status,
+              ResponseStatus::kBlockNotFound);
+
+    cbipld->map.erase(*asBlake(setCbor(ipld, message(0)).value()));
+    EXPECT_FALSE(encodeResponse(cbipld, {head, 3, kBlocksAndMessages}, out));
+    EXPECT_EQ(codec::cbor::decode<Response>(out).value().chain.size(), 2);
+    EXPECT_TRUE(encodeResponse(cbipld, {head, 3, kBlocksOnly}, out));
+  }
+
+  /**
+   * Reports throughput of serving 100-tipset requests, when response is
+   * encoded from decoded objects, spliced from stored cbor and cached.
+   */
+  TEST_F(BlocksyncServerTest, DISABLED_Throughput) {
+    const Request request{makeChain(200, 20), 100, kBlocksAndMessages};
+    const auto report{[&](std::string_view name, auto &&f) {
+      constexpr size_t kRequests{20};
+      size_t bytes{};
+      const auto start{std::chrono::steady_clock::now()};
+      for (size_t i{0}; i < kRequests; ++i) {
+        bytes += f();
+      }
+      const std::chrono::duration<double> seconds{
+          std::chrono::steady_clock::now() - start};
+      fmt::print("{}: {:.1f}requests/s {:.1f}MB/s\n",
+                 name,
+                 kRequests / seconds.count(),
+                 bytes / seconds.count() / (1 << 20));
+    }};
+    report("decode", [&] { return encodeDecoded(request).size(); });
+    report("splice", [&] {
+      Bytes out;
+      encodeResponse(cbipld, request, out);
+      return out.size();
+    });
+    lru_cache<int, std::shared_ptr<Bytes>> cache{kResponseCacheSize};
+    report("cache", [&] {
+      if (auto cached{cache.get(0)}) {
+        return (*cached)->size();
+      }
+      auto out{std::make_shared<Bytes>()};
+      encodeResponse(cbipld, request, *out);
+      cache.insert(0, out);
+      return out->size();
+    });
+  }
+}  // namespace fc::sync::blocksync
@@ -0,0 +1,172 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "node/graphsync_server.hpp"
+
+#include <gtest/gtest.h>
+
+#include "codec/cbor/cbor_codec.hpp"
+#include "storage/ipfs/graphsync/graphsync.hpp"
+#include "storage/ipfs/impl/in_memory_datastore.hpp"
+#include "storage/ipld/traverser.hpp"
+
+namespace fc::sync {
+  namespace gs = storage::ipfs::graphsync;
+  using storage::ipfs::InMemoryDatastore;
+  using storage::ipld::kAllSelector;
+
+  /** node [data, links] */
+  struct Node {
+    Bytes data;
+    std::vector<CID> links;
+  };
+  CBOR_TUPLE(Node, data, links)
+
+  struct GraphsyncServerTest : testing::Test {
+    struct Graphsync : gs::Graphsync {
+      DataConnection subscribe(std::function<OnDataReceived>) override {
+        throw "unused";
+      }
+      void setDefaultRequestHandler(
+          std::function<RequestHandler> handler) override {
+        this->handler = std::move(handler);
+      }
+      void setRequestHandler(std::function<RequestHandler>,
+                             std::string) override {
+        throw "unused";
+      }
+      void postResponse(const gs::FullRequestId &,
+                        const gs::Response &response) override {
+        responses.push_back(response);
+      }
+      void postBlocks(const gs::FullRequestId &,
+                      gs::Responder responder) override {
+        // chunks are requested until terminal status
+        while (true) {
+          auto response{responder(true)};
+          if (!response) {
+            break;
+          }
+          responses.push_back(std::move(*response));
+          if (gs::isTerminal(responses.back().status)) {
+            break;
+          }
+        }
+      }
+      void start() override {}
+      void stop() override {}
+      gs::Subscription makeRequest(const libp2p::peer::PeerInfo &,
+                                   const CID &,
+                                   gsl::span<const uint8_t>,
+                                   const std::vector<gs::Extension> &,
+                                   RequestProgressCallback) override {
+        throw "unused";
+      }
+
+      std::function<RequestHandler> handler;
+      std::vector<gs::Response> responses;
+    };
+
+    CID put(const Node &node) {
+      auto bytes{codec::cbor::encode(node).value()};
+      auto cid{common::getCidOf(bytes).value()};
+      EXPECT_TRUE(ipld->set(cid, std::move(bytes)));
+      return cid;
+    }
+
+    /** makes server, sends request, returns responses */
+    std::vector<gs::Response> request(const CID &root,
+                                      BytesIn selector,
+                                      size_t max_visited_blocks =
+                                          GraphsyncServer::kMaxVisitedBlocks) {
+      auto graphsync{std::make_shared<Graphsync>()};
+      GraphsyncServer server{graphsync, ipld, max_visited_blocks};
+      server.start();
+      graphsync->handler({}, {root, copy(selector), {}, false});
+      return graphsync->responses;
+    }
+
+    static std::vector<CID> sent(const std::vector<gs::Response> &responses) {
+      std::vector<CID> cids;
+      for (const auto &response : responses) {
+        for (const auto &data : response.data) {
+          cids.push_back(data.cid);
+        }
+      }
+      return cids;
+    }
+
+    std::shared_ptr<InMemoryDatastore> ipld{
+        std::make_shared<InMemoryDatastore>()};
+  };
+
+  /**
+   * @given blocks larger than response chunk
+   * @when requested
+   * @then blocks are sent in several chunks, last chunk completes response
+   */
+  TEST_F(GraphsyncServerTest, Chunks) {
+    std::vector<CID> leaves;
+    for (uint8_t i{0}; i < 4; ++i) {
+      leaves.push_back(put({Bytes(100 << 10, i), {}}));
+    }
+    const auto root{put({{}, leaves})};
+    const auto responses{request(root, kAllSelector.b)};
+    ASSERT_EQ(responses.size(), 2);
+    EXPECT_EQ(responses[0].status, gs::RS_PARTIAL_RESPONSE);
+    EXPECT_EQ(responses[0].data.size(), 4);
+    EXPECT_EQ(responses[1].status, gs::RS_FULL_CONTENT);
+    leaves.insert(leaves.begin(), root);
+    EXPECT_EQ(sent(responses), leaves);
+  }
+
+  /**
+   * @given dag with shared and missing blocks
+   * @when requested
+   * @then shared blocks are sent once, missing blocks complete response with
+   * partial content
+   */
+  TEST_F(GraphsyncServerTest, DuplicatesMissing) {
+    const auto leaf{put({{1}, {}})};
+    const auto root{put({{}, {leaf, leaf}})};
+    auto responses{request(root, kAllSelector.b)};
+    EXPECT_EQ(responses.back().status, gs::RS_FULL_CONTENT);
+    EXPECT_EQ(sent(responses), (std::vector<CID>{root, leaf}));
+
+    const auto missing{common::getCidOf(Bytes{2}).value()};
+    const auto root2{put({{}, {missing, leaf}})};
+    responses = request(root2, kAllSelector.b);
+    EXPECT_EQ(responses.back().status, gs::RS_PARTIAL_CONTENT);
+    EXPECT_EQ(sent(responses), (std::vector<CID>{root2, leaf}));
+  }
+
+  /**
+   * @given dag where each node links twice to next node
+   * @when requested with budget lower than walk length
+   * @then request fails after budget is spent
+   */
+  TEST_F(GraphsyncServerTest, Budget) {
+    auto root{put({{}, {}})};
+    for (size_t i{0}; i < 20; ++i) {
+      root = put({{}, {root, root}});
+    }
+    const auto responses{request(root, kAllSelector.b, 100)};
+    EXPECT_EQ(responses.back().status, gs::RS_REQUEST_FAILED);
+    EXPECT_EQ(sent(responses).size(), 21);
+  }
+
+  /**
+   * @given invalid selector
+   * @when requested
+   * @then request fails without blocks
+   */
+  TEST_F(GraphsyncServerTest, InvalidSelector) {
+    const auto root{put({{}, {}})};
+    const auto responses{request(root, Bytes{0xff})};
+    ASSERT_EQ(responses.size(), 1);
+    EXPECT_EQ(responses[0].status, gs::RS_REQUEST_FAILED);
+    EXPECT_TRUE(responses[0].data.empty());
+  }
+}  // namespace fc::sync
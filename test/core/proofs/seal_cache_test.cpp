@@ -0,0 +1,75 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "proofs/seal_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include "storage/in_memory/in_memory_storage.hpp"
+#include "testutil/literals.hpp"
+
+namespace fc::proofs {
+  using primitives::sector::RegisteredSealProof;
+  using storage::InMemoryStorage;
+
+  SealVerifyInfo makeInfo(uint8_t proof) {
+    SealVerifyInfo info;
+    info.seal_proof = RegisteredSealProof::kStackedDrg2KiBV1_1;
+    info.sector = {1000, 1};
+    info.proof = {proof};
+    info.sealed_cid = "010001020001"_cid;
+    info.unsealed_cid = "010001020002"_cid;
+    return info;
+  }
+
+  /**
+   * @given seal cache
+   * @when results are put
+   * @then results are found for same info and proof only
+   */
+  TEST(SealCache, PutGet) {
+    SealVerifyInfo info;
+    info.seal_proof = RegisteredSealProof::kStackedDrg2KiBV1_1;
+    info.sector = {1000, 1};
+    info.proof = {1, 2, 3};
+    info.sealed_cid = "010001020001"_cid;
+    info.unsealed_cid = "010001020002"_cid;
+    auto other{info};
+    other.proof = {1, 2, 4};
+
+    SealCache cache{std::make_shared<InMemoryStorage>()};
+    EXPECT_EQ(cache.get(info), boost::none);
+    cache.put(info, true);
+    cache.put(other, false);
+    EXPECT_EQ(cache.get(info), true);
+    EXPECT_EQ(cache.get(other), false);
+  }
+
+  /**
+   * @given seal cache with max size 4 and keys of old format
+   * @when more results are put
+   * @then old format keys are removed, oldest results are evicted, results
+   * found in previous generation are kept
+   */
+  TEST(SealCache, Eviction) {
+    auto map{std::make_shared<InMemoryStorage>()};
+    const Bytes old_key(32, 1);
+    EXPECT_TRUE(map->put(old_key, Bytes{1}));
+    auto cache{std::make_unique<SealCache>(map, 4)};
+    EXPECT_FALSE(map->contains(old_key));
+    for (uint8_t i{0}; i < 4; ++i) {
+      cache->put(makeInfo(i), true);
+    }
+    // moves 0 to new generation, evicts 1
+    EXPECT_EQ(cache->get(makeInfo(0)), true);
+    EXPECT_EQ(cache->get(makeInfo(1)), boost::none);
+    EXPECT_EQ(cache->get(makeInfo(2)), true);
+    EXPECT_EQ(map->storage.size(), 5);
+
+    cache = std::make_unique<SealCache>(map, 4);
+    EXPECT_EQ(cache->get(makeInfo(0)), true);
+    EXPECT_EQ(cache->get(makeInfo(3)), true);
+  }
+}  // namespace fc::proofs
@@ -0,0 +1,54 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "proofs/seal_verifier.hpp"
+
+#include <gtest/gtest.h>
+
+#include "common/error_text.hpp"
+#include "storage/in_memory/in_memory_storage.hpp"
+#include "testutil/literals.hpp"
+#include "testutil/mocks/proofs/proof_engine_mock.hpp"
+
+namespace fc::proofs {
+  using primitives::sector::RegisteredSealProof;
+  using storage::InMemoryStorage;
+  using testing::_;
+
+  /**
+   * @given seal verifier with cache, one seal is cached, one fails to verify
+   * @when seals are verified twice
+   * @then cached seal is not verified, other results are cached except failed
+   */
+  TEST(SealVerifier, Verify) {
+    std::vector<SealVerifyInfo> infos;
+    for (uint8_t i{0}; i < 10; ++i) {
+      auto &info{infos.emplace_back()};
+      info.seal_proof = RegisteredSealProof::kStackedDrg2KiBV1_1;
+      info.sector = {1000, i};
+      info.proof = {i};
+      info.sealed_cid = "010001020001"_cid;
+      info.unsealed_cid = "010001020002"_cid;
+    }
+    auto proofs{std::make_shared<ProofEngineMock>()};
+    EXPECT_CALL(*proofs, verifySeal(_))
+        .Times(10)
+        .WillRepeatedly(testing::Invoke(
+            [](const SealVerifyInfo &info) -> outcome::result<bool> {
+              if (info.proof[0] == 1) {
+                return ERROR_TEXT("verifySeal: error");
+              }
+              return info.proof[0] % 2 == 0;
+            }));
+    auto cache{
+        std::make_shared<SealCache>(std::make_shared<InMemoryStorage>())};
+    cache->put(infos[0], false);
+    SealVerifier verifier{3, proofs, cache};
+    const std::vector<bool> expected{
+        false, false, true, false, true, false, true, false, true, false};
+    EXPECT_EQ(verifier.verify(infos), expected);
+    EXPECT_EQ(verifier.verify(infos), expected);
+  }
+}  // namespace fc::proofs
@@ -6,6 +6,7 @@
 #include "storage/amt/amt.hpp"
 
 #include <gtest/gtest.h>
+#include <thread>
 
 #include "cbor_blake/ipld_any.hpp"
 #include "codec/cbor/light_reader/amt_walk.hpp"
@@ -106,6 +107,83 @@ TEST_F(AmtTest, Flush) {
   EXPECT_OUTCOME_EQ(amt.get(key), value);
 }
 
+/**
+ * @given amts loaded from same root
+ * @when modify one of them
+ * @then shared cached nodes are not modified
+ */
+TEST_F(AmtTest, NodeCacheCopyOnWrite) {
+  auto value1 = Value{"07"_unhex};
+  auto value2 = Value{"08"_unhex};
+  EXPECT_OUTCOME_TRUE_1(amt.set(1, BytesIn{value1}));
+  EXPECT_OUTCOME_TRUE_1(amt.set(100, BytesIn{value1}));
+  EXPECT_OUTCOME_TRUE(cid, amt.flush());
+
+  const auto hits = fc::storage::amt::nodeCache().hits.load();
+  Amt amt1{store, cid};
+  Amt amt2{store, cid};
+  EXPECT_OUTCOME_EQ(amt2.get(1), value1);
+  EXPECT_OUTCOME_TRUE_1(amt1.set(1, BytesIn{value2}));
+  EXPECT_OUTCOME_TRUE_1(amt1.remove(100));
+  EXPECT_OUTCOME_EQ(amt1.get(1), value2);
+  EXPECT_OUTCOME_EQ(amt2.get(1), value1);
+  EXPECT_OUTCOME_EQ(amt2.get(100), value1);
+  EXPECT_GT(fc::storage::amt::nodeCache().hits, hits);
+
+  Amt amt3{store, cid};
+  EXPECT_OUTCOME_EQ(amt3.get(1), value1);
+}
+
+/**
+ * @given amt nodes shared by node cache
+ * @when several threads get and visit amt with same root at same time
+ * @then values are found and cached nodes keep links as cids
+ */
+TEST_F(AmtTest, NodeCacheConcurrentRead) {
+  constexpr uint64_t kKeys{1000};
+  const auto value = Value{"07"_unhex};
+  for (uint64_t key{0}; key < kKeys; ++key) {
+    EXPECT_OUTCOME_TRUE_1(amt.set(key, BytesIn{value}));
+  }
+  EXPECT_OUTCOME_TRUE(cid, amt.flush());
+
+  std::vector<std::thread> threads;
+  std::atomic_size_t found{};
+  for (auto t{0}; t < 8; ++t) {
+    threads.emplace_back([&] {
+      Amt amt{store, cid};
+      for (uint64_t key{0}; key < kKeys; ++key) {
+        const auto result = amt.get(key);
+        if (result && result.value() == value) {
+          ++found;
+        }
+      }
+      EXPECT_OUTCOME_TRUE_1(amt.visit([&](auto, auto) {
+        ++found;
+        return fc::outcome::success();
+      }));
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(found, 2 * 8 * kKeys);
+
+  const auto root = fc::getCbor<Root>(store, cid).value();
+  for (const auto &link : boost::get<Node::Links>(root.node.items)) {
+    EXPECT_OUTCOME_TRUE(
+        node,
+        fc::storage::amt::nodeCache().load(store,
+                                           boost::get<fc::CID>(link.second)));
+    EXPECT_TRUE(node->cached);
+    if (const auto *links = boost::get<Node::Links>(&node->items)) {
+      for (const auto &link2 : *links) {
+        EXPECT_FALSE(which<Node::Ptr>(link2.second));
+      }
+    }
+  }
+}
+
 class AmtVisitTest : public AmtTest {
  public:
   AmtVisitTest() : AmtTest{} {
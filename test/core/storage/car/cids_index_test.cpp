@@ -6,6 +6,8 @@
 #include "storage/car/cids_index/util.hpp"
 
 #include <future>
+#include <random>
+#include <thread>
 
 #include "common/io_thread.hpp"
 #include "primitives/cid/cid_of_cbor.hpp"
@@ -148,4 +150,538 @@ namespace fc::storage::cids_index {
     EXPECT_OUTCOME_EQ(getCbor<int>(ipld, c1), 1);
     EXPECT_OUTCOME_EQ(getCbor<int>(ipld, c2), 2);
   }
+
+  TEST_F(CidsIndexTest, ReadCarParallel) {
+    const auto car_path{resourcePath("compacter.car").string()};
+    const auto car_size{fs::file_size(car_path)};
+    std::ifstream car_file{car_path, std::ios::binary};
+    codec::uvarint::VarintDecoder header;
+    EXPECT_TRUE(read(car_file, header));
+    const auto header_end{header.length + header.value};
+
+    const auto rows_path{cids_path + ".rows"};
+    auto readRows{[&](auto &&read) {
+      std::fstream rows_file{
+          rows_path,
+          std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc};
+      std::vector<MergeRange> ranges;
+      const auto total{read(rows_file, ranges).value()};
+      std::ofstream out{cids_path, std::ios::binary | std::ios::trunc};
+      EXPECT_OUTCOME_TRUE_1(merge(out, std::move(ranges)));
+      out.close();
+      EXPECT_EQ(fs::file_size(cids_path), (total + 2) * sizeof(Row));
+      return common::readFile(cids_path).value();
+    }};
+    const auto expected{readRows([&](auto &rows_file, auto &ranges) {
+      return readCar(car_file,
+                     header_end,
+                     car_size,
+                     boost::none,
+                     nullptr,
+                     nullptr,
+                     rows_file,
+                     ranges);
+    })};
+    for (const size_t threads : {1, 4}) {
+      EXPECT_EQ(readRows([&](auto &rows_file, auto &ranges) {
+                  return readCarParallel(car_path,
+                                         header_end,
+                                         car_size,
+                                         boost::none,
+                                         nullptr,
+                                         nullptr,
+                                         rows_file,
+                                         rows_path,
+                                         ranges,
+                                         threads);
+                }),
+                expected);
+    }
+  }
+
+  /**
+   * Fills car with blocks of given size, returns their keys.
+   */
+  inline std::vector<CbCid> fillCar(CidsIpld &ipld, size_t count, size_t size) {
+    std::vector<CbCid> keys;
+    keys.reserve(count);
+    Bytes value(size);
+    for (size_t i{0}; i < count; ++i) {
+      memcpy(value.data(), &i, std::min(sizeof(i), value.size()));
+      keys.push_back(ipld.put(BytesCow{BytesIn{value}}));
+    }
+    ipld.doFlush().value();
+    ipld.carFlush();
+    return keys;
+  }
+
+  TEST_F(CidsIndexTest, ConcurrentGet) {
+    ipld = *load(true);
+    const auto keys{fillCar(*ipld, 1000, 100)};
+    ipld = *load(false);
+    std::vector<std::thread> threads;
+    std::atomic_size_t found{};
+    // each thread reads every key, starting from different offset
+    for (size_t t{0}; t < 4; ++t) {
+      threads.emplace_back([&, t] {
+        Bytes value;
+        for (size_t j{0}; j < keys.size(); ++j) {
+          const auto i{(j + t * keys.size() / 4) % keys.size()};
+          if (ipld->get(keys[i], value) && value.size() == 100
+              && CbCid::hash(value) == keys[i]) {
+            ++found;
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(found, keys.size() * 4);
+  }
+
+  TEST_F(CidsIndexTest, Bloom) {
+    ipld = *load(true);
+    EXPECT_TRUE(ipld->bloom);
+    ipld->flush_on = 100;
+    const auto keys{fillCar(*ipld, 300, 10)};
+    EXPECT_GE(ipld->bloom->capacity, keys.size());
+    for (const auto &key : keys) {
+      EXPECT_TRUE(ipld->has(key));
+    }
+    EXPECT_EQ(ipld->bloom_negatives, 0);
+    EXPECT_FALSE(ipld->has(CbCid::hash(Bytes{1, 2, 3})));
+    EXPECT_EQ(ipld->bloom_negatives + ipld->bloom_false_positives, 1);
+
+    // bloom persists
+    EXPECT_TRUE(fs::exists(cids_path + ".bloom"));
+    ipld = *load(true);
+    for (const auto &key : keys) {
+      EXPECT_TRUE(ipld->bloom->has(key));
+    }
+  }
+
+  TEST_F(CidsIndexTest, Runs) {
+    ipld = *load(true);
+    auto keys{fillCar(*ipld, 1000, 10)};
+    EXPECT_TRUE(ipld->runs.empty());
+    EXPECT_EQ(ipld->index->size(), keys.size());
+
+    // flush writes runs instead of rewriting index
+    ipld->flush_on = 10;
+    Bytes value(20);
+    for (size_t i{0}; i < 100; ++i) {
+      memcpy(value.data(), &i, sizeof(i));
+      keys.push_back(ipld->put(BytesCow{BytesIn{value}}));
+      EXPECT_LT(ipld->runs.size(), CidsIpld::kRunsPerTier * 2);
+    }
+    EXPECT_EQ(ipld->index->size(), 1000);
+    EXPECT_FALSE(ipld->runs.empty());
+    EXPECT_EQ(ipld->indexSize() + ipld->written.size(), keys.size());
+    EXPECT_EQ(CidsIpld::listRuns(cids_path).size(), ipld->runs.size());
+    // runs are mapped, not loaded into memory
+    for (const auto &run : ipld->runs) {
+      EXPECT_TRUE(std::dynamic_pointer_cast<MmapIndex>(run.index));
+    }
+    for (const auto &key : keys) {
+      EXPECT_TRUE(ipld->has(key));
+    }
+
+    // runs are merged into index on load
+    ipld->carFlush();
+    ipld = *load(true);
+    EXPECT_TRUE(ipld->runs.empty());
+    EXPECT_TRUE(CidsIpld::listRuns(cids_path).empty());
+    EXPECT_EQ(ipld->index->size(), keys.size());
+    for (const auto &key : keys) {
+      EXPECT_TRUE(ipld->has(key));
+    }
+  }
+
+  /**
+   * @given index with saved bloom
+   * @when runs are flushed and node stops before runs are merged into index
+   * @then flush doesn't rewrite bloom, bloom is recovered from runs on load
+   */
+  TEST_F(CidsIndexTest, BloomRecoveredFromRuns) {
+    const auto bloom_path{cids_path + ".bloom"};
+    ipld = *load(true);
+    auto keys{fillCar(*ipld, 1000, 10)};
+    // only saved bloom has marker, rebuilt bloom doesn't
+    const auto marker{CbCid::hash(Bytes{1, 2, 3})};
+    ipld->bloom->insert(marker);
+    EXPECT_OUTCOME_TRUE_1(ipld->saveBloom());
+    const auto saved{common::readFile(bloom_path).value()};
+
+    ipld->flush_on = 10;
+    Bytes value(20);
+    for (size_t i{0}; i < 100; ++i) {
+      memcpy(value.data(), &i, sizeof(i));
+      keys.push_back(ipld->put(BytesCow{BytesIn{value}}));
+    }
+    EXPECT_FALSE(ipld->runs.empty());
+    EXPECT_EQ(common::readFile(bloom_path).value(), saved);
+
+    // crash, bloom saved at shutdown is lost
+    ipld->carFlush();
+    ipld.reset();
+    EXPECT_OUTCOME_TRUE_1(common::writeFile(bloom_path, saved));
+    ipld = *load(true);
+    EXPECT_TRUE(ipld->runs.empty());
+    EXPECT_EQ(ipld->index->size(), keys.size());
+    EXPECT_TRUE(ipld->bloom->has(marker));
+    for (const auto &key : keys) {
+      EXPECT_TRUE(ipld->bloom->has(key));
+    }
+  }
+
+  /**
+   * Makes count distinct blocks of given size.
+   */
+  inline std::vector<Bytes> makeBlocks(size_t count, size_t size) {
+    std::vector<Bytes> values(count, Bytes(size));
+    for (size_t i{0}; i < count; ++i) {
+      memcpy(values[i].data(), &i, std::min(sizeof(i), size));
+    }
+    return values;
+  }
+
+  TEST_F(CidsIndexTest, PutMany) {
+    ipld = *load(true);
+    const auto header{*common::readFile(car_path)};
+    const auto values{makeBlocks(10, 20)};
+    std::vector<std::pair<CbCid, BytesIn>> items;
+    for (const auto &value : values) {
+      items.emplace_back(CbCid::hash(value), value);
+    }
+    // key present before batch
+    ipld->put(items[0].first, BytesCow{items[0].second});
+    // key repeated in batch
+    items.push_back(items[1]);
+
+    ipld->putMany(items);
+    ipld->carFlush();
+    EXPECT_EQ(ipld->written.size(), values.size());
+    EXPECT_EQ(fs::file_size(car_path), header.size() + values.size() * 59);
+    Bytes value;
+    for (const auto &[key, expected] : items) {
+      EXPECT_TRUE(ipld->get(key, value));
+      EXPECT_EQ(value, copy(expected));
+    }
+
+    // nothing is appended when all keys are present
+    ipld->putMany(items);
+    ipld->carFlush();
+    EXPECT_EQ(fs::file_size(car_path), header.size() + values.size() * 59);
+
+    // value persists
+    ipld = *load(true);
+    for (const auto &[key, expected] : items) {
+      EXPECT_TRUE(ipld->get(key, value));
+      EXPECT_EQ(value, copy(expected));
+    }
+  }
+
+  /**
+   * Benchmark of CidsIpld.putMany against put per block.
+   * Run with --gtest_also_run_disabled_tests.
+   */
+  TEST_F(CidsIndexTest, DISABLED_PutManyThroughput) {
+    constexpr size_t kCount{200000};
+    const auto values{makeBlocks(kCount, 256)};
+    std::vector<std::pair<CbCid, BytesIn>> items;
+    for (const auto &value : values) {
+      items.emplace_back(CbCid::hash(value), value);
+    }
+    for (const size_t batch : {1, 16, 64, 256, 1024}) {
+      fs::remove(car_path);
+      fs::remove(cids_path);
+      ipld = *load(true);
+      ipld->flush_on = 10000;
+      ipld->car_flush_on = 1000;
+      const auto begin{std::chrono::steady_clock::now()};
+      for (size_t i{0}; i < items.size(); i += batch) {
+        const auto span{gsl::make_span(items).subspan(
+            i, std::min(batch, items.size() - i))};
+        if (batch == 1) {
+          ipld->put(span[0].first, BytesCow{span[0].second});
+        } else {
+          ipld->putMany(span);
+        }
+      }
+      ipld->carFlush();
+      const std::chrono::duration<double> seconds{
+          std::chrono::steady_clock::now() - begin};
+      fmt::print("batch={} puts/s={:.0f}\n", batch, kCount / seconds.count());
+    }
+  }
+
+  /**
+   * Benchmark of CidsIpld.get throughput by number of reading threads.
+   * Run with --gtest_also_run_disabled_tests.
+   */
+  TEST_F(CidsIndexTest, DISABLED_ReadThroughput) {
+    constexpr size_t kCount{200000};
+    constexpr size_t kReads{1000000};
+    ipld = *load(true);
+    const auto keys{fillCar(*ipld, kCount, 256)};
+    ipld = *load(false);
+    for (const size_t n_threads : {1, 2, 4, 8, 16}) {
+      const auto begin{std::chrono::steady_clock::now()};
+      std::vector<std::thread> threads;
+      for (size_t t{0}; t < n_threads; ++t) {
+        threads.emplace_back([&, t] {
+          Bytes value;
+          for (auto i{t}; i < kReads; i += n_threads) {
+            EXPECT_TRUE(ipld->get(keys[(i * 7919) % keys.size()], value));
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      const std::chrono::duration<double> seconds{
+          std::chrono::steady_clock::now() - begin};
+      fmt::print("threads={} reads/s={:.0f}\n",
+                 n_threads,
+                 kReads / seconds.count());
+    }
+  }
+}  // namespace fc::storage::cids_index
+
+namespace fc::storage::cids_index {
+  /**
+   * Writes index of random rows, returns sorted rows.
+   */
+  inline std::vector<Row> writeRandomIndex(const std::string &path,
+                                           size_t count,
+                                           uint64_t seed = 0) {
+    std::mt19937_64 random{seed};
+    std::vector<Row> rows(count);
+    for (size_t i{0}; i < count; ++i) {
+      auto &row{rows[i]};
+      for (auto &byte : row.key) {
+        byte = random();
+      }
+      row.offset = i * 64;
+      row.max_size64 = 1;
+    }
+    std::sort(rows.begin(), rows.end());
+    std::ofstream file{path, std::ios::binary};
+    EXPECT_TRUE(common::writeStruct(file, kHeaderV0));
+    EXPECT_TRUE(common::write(file, gsl::make_span(rows)));
+    EXPECT_TRUE(common::writeStruct(file, kTrailerV0));
+    return rows;
+  }
+
+  struct IndexTest : test::BaseFS_Test {
+    std::string index_path;
+
+    IndexTest() : BaseFS_Test("cids_index_test") {
+      index_path = (getPathString() / "test.cids").string();
+    }
+  };
+
+  TEST_F(IndexTest, MergeParallel) {
+    std::vector<std::string> paths;
+    std::vector<MergeRange> ranges;
+    std::vector<std::ifstream> files(5);
+    for (size_t i{0}; i < files.size(); ++i) {
+      auto &path{paths.emplace_back(index_path + std::to_string(i))};
+      writeRandomIndex(path, 1000 * i, i);
+      files[i].open(path, std::ios::binary);
+      auto &range{ranges.emplace_back()};
+      range.file = &files[i];
+      range.path = path;
+      range.begin = 1;
+      range.end = 1 + 1000 * i;
+    }
+    {
+      std::ofstream out{index_path, std::ios::binary};
+      EXPECT_OUTCOME_TRUE_1(merge(out, std::vector<MergeRange>{ranges}));
+    }
+    const auto expected{common::readFile(index_path).value()};
+    for (const size_t threads : {1, 3, 8}) {
+      const auto path{index_path + ".parallel"};
+      EXPECT_OUTCOME_TRUE_1(
+          mergeParallel(path, std::vector<MergeRange>{ranges}, threads));
+      EXPECT_EQ(common::readFile(path).value(), expected);
+    }
+  }
+
+  /**
+   * @given overlapping runs left by interrupted compaction
+   * @when merged in parallel
+   * @then output is same as merge, duplicate rows are written once
+   */
+  TEST_F(IndexTest, MergeParallelDuplicates) {
+    std::vector<MergeRange> ranges;
+    std::vector<std::ifstream> files(3);
+    std::vector<Row> rows;
+    for (size_t i{0}; i < files.size(); ++i) {
+      const auto path{index_path + std::to_string(i)};
+      // same seed, each run is prefix of next
+      rows = writeRandomIndex(path, 1000 * (i + 1));
+      files[i].open(path, std::ios::binary);
+      auto &range{ranges.emplace_back()};
+      range.file = &files[i];
+      range.path = path;
+      range.begin = 1;
+      range.end = 1 + 1000 * (i + 1);
+    }
+    {
+      std::ofstream out{index_path, std::ios::binary};
+      EXPECT_OUTCOME_TRUE_1(merge(out, std::vector<MergeRange>{ranges}));
+    }
+    const auto expected{common::readFile(index_path).value()};
+    EXPECT_EQ(expected.size(), (rows.size() + 2) * sizeof(Row));
+    for (const size_t threads : {1, 3, 8}) {
+      const auto path{index_path + ".parallel"};
+      EXPECT_OUTCOME_TRUE_1(
+          mergeParallel(path, std::vector<MergeRange>{ranges}, threads));
+      EXPECT_EQ(common::readFile(path).value(), expected);
+    }
+  }
+
+  TEST(MemtableTest, FindSortedErase) {
+    std::mt19937_64 random{0};
+    Memtable memtable;
+    std::vector<Row> rows(1000);
+    for (size_t i{0}; i < rows.size(); ++i) {
+      std::generate(rows[i].key.begin(), rows[i].key.end(), std::ref(random));
+      rows[i].offset = i;
+      memtable.insert(rows[i]);
+    }
+    EXPECT_EQ(memtable.size(), rows.size());
+    for (const auto &row : rows) {
+      EXPECT_TRUE(memtable.find(row.key).value() == row);
+    }
+    EXPECT_FALSE(memtable.find(CbCid::hash(Bytes{1, 2, 3})));
+    auto sorted{rows};
+    std::sort(sorted.begin(), sorted.end());
+    EXPECT_TRUE(memtable.sorted() == sorted);
+
+    memtable.eraseUntil(499);
+    EXPECT_EQ(memtable.size(), 500);
+    for (const auto &row : rows) {
+      EXPECT_EQ(memtable.find(row.key).has_value(),
+                row.offset.value() > 499);
+    }
+    memtable.eraseUntil(rows.size());
+    EXPECT_TRUE(memtable.empty());
+  }
+
+  TEST(BloomTest, NoFalseNegatives) {
+    std::mt19937_64 random;
+    constexpr size_t kCount{10000};
+    Bloom bloom{kCount};
+    std::vector<CbCid> keys(kCount * 2);
+    for (auto &key : keys) {
+      for (auto &byte : key) {
+        byte = random();
+      }
+    }
+    for (size_t i{0}; i < kCount; ++i) {
+      bloom.insert(keys[i]);
+    }
+    size_t false_positives{};
+    for (size_t i{0}; i < keys.size(); ++i) {
+      if (i < kCount) {
+        EXPECT_TRUE(bloom.has(keys[i]));
+      } else if (bloom.has(keys[i])) {
+        ++false_positives;
+      }
+    }
+    EXPECT_LT(false_positives, kCount / 20);
+  }
+
+  TEST_F(IndexTest, Bloom) {
+    const auto rows{writeRandomIndex(index_path, 1000)};
+    const auto index{load(index_path, boost::none).value()};
+    const auto bloom_path{index_path + ".bloom"};
+    const auto bloom{
+        Bloom::loadOrCreate(bloom_path, index_path, *index).value()};
+    EXPECT_TRUE(fs::exists(bloom_path));
+    EXPECT_EQ(bloom->count, rows.size());
+    for (const auto &row : rows) {
+      EXPECT_TRUE(bloom->has(row.key));
+    }
+
+    // saved bloom is loaded
+    CbCid key;
+    key.fill(1);
+    bloom->insert(key);
+    EXPECT_OUTCOME_TRUE_1(bloom->save(bloom_path, *index));
+    const auto bloom2{
+        Bloom::loadOrCreate(bloom_path, index_path, *index).value()};
+    EXPECT_EQ(bloom2->count, rows.size() + 1);
+    EXPECT_TRUE(bloom2->has(key));
+
+    // bloom of other index is rebuilt
+    writeRandomIndex(index_path, 10);
+    const auto index3{load(index_path, boost::none).value()};
+    const auto bloom3{
+        Bloom::loadOrCreate(bloom_path, index_path, *index3).value()};
+    EXPECT_EQ(bloom3->count, 10);
+  }
+
+  TEST_F(IndexTest, Mmap) {
+    for (const size_t count : {0, 1, 2, 10, 1000}) {
+      const auto rows{writeRandomIndex(index_path, count)};
+      const auto index{MmapIndex::load(index_path, count).value()};
+      EXPECT_EQ(index->size(), count);
+      for (const auto &row : rows) {
+        EXPECT_TRUE(index->find(row.key).value() == row);
+      }
+      CbCid missing;
+      missing.fill(0xFF);
+      EXPECT_FALSE(index->find(missing).value());
+      missing.fill(0);
+      EXPECT_FALSE(index->find(missing).value());
+      for (auto row : rows) {
+        ++row.key[CbCid::size() - 1];
+        const auto it{std::lower_bound(rows.begin(), rows.end(), row.key)};
+        if (it == rows.end() || it->key != row.key) {
+          EXPECT_FALSE(index->find(row.key).value());
+        }
+      }
+    }
+  }
+
+  TEST_F(IndexTest, LoadMmapOverMaxMemory) {
+    writeRandomIndex(index_path, 100);
+    EXPECT_TRUE(std::dynamic_pointer_cast<MmapIndex>(
+        load(index_path, 10 * sizeof(Row)).value()));
+    EXPECT_TRUE(std::dynamic_pointer_cast<MemoryIndex>(
+        load(index_path, boost::none).value()));
+  }
+
+  /**
+   * Benchmark of Index.find latency by index implementation.
+   * Run with --gtest_also_run_disabled_tests.
+   */
+  TEST_F(IndexTest, DISABLED_FindLatency) {
+    constexpr size_t kCount{10000000};
+    constexpr size_t kFinds{1000000};
+    const auto rows{writeRandomIndex(index_path, kCount)};
+    std::ifstream file{index_path, std::ios::binary};
+    const auto count{checkIndex(file).value()};
+    std::vector<std::pair<std::string, std::shared_ptr<Index>>> indices;
+    indices.emplace_back("memory", MemoryIndex::load(file, count).value());
+    checkIndex(file).value();
+    indices.emplace_back(
+        "sparse",
+        SparseIndex::load(std::move(file), count, count / 64).value());
+    indices.emplace_back("mmap", MmapIndex::load(index_path, count).value());
+    for (const auto &[name, index] : indices) {
+      const auto begin{std::chrono::steady_clock::now()};
+      for (size_t i{0}; i < kFinds; ++i) {
+        const auto &row{rows[(i * 7919) % rows.size()]};
+        EXPECT_TRUE(index->find(row.key).value() == row);
+      }
+      const std::chrono::duration<double, std::nano> ns{
+          std::chrono::steady_clock::now() - begin};
+      fmt::print("{} ns/find={:.0f}\n", name, ns.count() / kFinds);
+    }
+  }
 }  // namespace fc::storage::cids_index
@@ -128,4 +128,155 @@ namespace fc::storage::compacter {
     EXPECT_FALSE(compacter->asyncStart());
     runOne();
   }
+
+  struct CompacterCopyTest : test::BaseFS_Test {
+    std::shared_ptr<CompacterIpld> compacter;
+    CbCid root;
+    size_t count{};
+
+    CompacterCopyTest() : BaseFS_Test("compacter_copy_test") {}
+
+    std::shared_ptr<CidsIpld> open(const std::string &name) {
+      return cids_index::loadOrCreateWithProgress(
+                 (getPathString() / name).string(),
+                 true,
+                 boost::none,
+                 nullptr,
+                 nullptr)
+          .value();
+    }
+
+    /** writes synthetic state tree with unique leaves */
+    CbCid writeTree(const std::shared_ptr<CidsIpld> &ipld,
+                    size_t fanout,
+                    size_t depth,
+                    std::vector<CbCid> *keys = nullptr) {
+      std::function<CID(size_t)> node{[&](size_t level) {
+        ++count;
+        CID cid;
+        if (level == depth) {
+          Bytes leaf(100);
+          memcpy(leaf.data(), &count, sizeof(count));
+          cid = setCbor(ipld, leaf).value();
+        } else {
+          std::vector<CID> children;
+          for (size_t i{0}; i < fanout; ++i) {
+            children.push_back(node(level + 1));
+          }
+          cid = setCbor(ipld, children).value();
+        }
+        if (keys) {
+          keys->push_back(*asBlake(cid));
+        }
+        return cid;
+      }};
+      return *asBlake(node(0));
+    }
+
+    /** writes synthetic state tree, copies it with given threads */
+    void copy(size_t fanout, size_t depth, size_t threads) {
+      auto old_ipld{open("old.car")};
+      count = 0;
+      root = writeTree(old_ipld, fanout, depth);
+      old_ipld->doFlush().value();
+
+      compacter = make((getPathString() / "new").string(),
+                       std::make_shared<InMemoryStorage>(),
+                       old_ipld,
+                       std::make_shared<std::shared_mutex>());
+      compacter->new_ipld = open("new.car");
+      compacter->copy_threads = threads;
+      compacter->queue->visited = compacter->new_ipld;
+      compacter->queue->open(true);
+      compacter->queue->push(root);
+      compacter->queueLoop();
+    }
+  };
+
+  /** parallel copy copies whole tree */
+  TEST_F(CompacterCopyTest, Parallel) {
+    copy(4, 4, 4);
+    EXPECT_EQ(compacter->copied_blocks, count);
+    EXPECT_TRUE(compacter->queue->empty());
+    compacter->new_ipld->doFlush().value();
+    EXPECT_EQ(compacter->new_ipld->indexSize(), count);
+    EXPECT_TRUE(compacter->new_ipld->has(root));
+  }
+
+  /** gc reclaims dead segments in place and keeps live blocks */
+  TEST_F(CompacterCopyTest, Gc) {
+    auto ipld{open("old.car")};
+    std::vector<CbCid> dead, live;
+    writeTree(ipld, 4, 4, &dead);
+    root = writeTree(ipld, 4, 4, &live);
+    ipld->doFlush().value();
+    ipld->carFlush();
+    const auto car_size{ipld->car_offset};
+
+    compacter = make((getPathString() / "compacter").string(),
+                     std::make_shared<InMemoryStorage>(),
+                     ipld,
+                     std::make_shared<std::shared_mutex>());
+    constexpr uint64_t kSegment{4096};
+    auto marks{GcMarks::make(ipld, kSegment).value()};
+    compacter->queue->visited = marks;
+    compacter->queue->open(true);
+    compacter->queue->push(root);
+    compacter->queueLoop();
+    for (const auto &key : live) {
+      EXPECT_TRUE(marks->has(key));
+    }
+    for (const auto &key : dead) {
+      EXPECT_FALSE(marks->has(key));
+    }
+
+    marks->sweeping = true;
+    const auto reclaimed{marks->sweep(0.25).value()};
+#ifdef __linux__
+    EXPECT_GE(reclaimed, kSegment);
+#endif
+    EXPECT_GT(ipld->car_offset, car_size);
+    auto check{[&] {
+      Bytes value;
+      for (const auto &key : live) {
+        EXPECT_TRUE(ipld->get(key, value));
+        EXPECT_EQ(CbCid::hash(value), key);
+      }
+      size_t found{};
+      for (const auto &key : dead) {
+        if (ipld->has(key)) {
+          ++found;
+        }
+      }
+      // dead blocks sharing segments with live ones are kept
+      EXPECT_LT(found, dead.size() / 2);
+    }};
+    check();
+
+    // reclaimed ranges are valid car items
+    ipld->carFlush();
+    ipld = open("old.car");
+    check();
+    boost::filesystem::remove(ipld->index_path);
+    ipld = open("old.car");
+    check();
+  }
+
+  /**
+   * Benchmark of compacter copy rate by number of threads.
+   * Run with --gtest_also_run_disabled_tests.
+   */
+  TEST_F(CompacterCopyTest, DISABLED_CopyRate) {
+    for (const size_t threads : {1, 2, 4, 8}) {
+      copy(8, 5, threads);
+      EXPECT_EQ(compacter->copied_blocks, count);
+      fmt::print("threads={} blocks={} rate={:.0f} blocks/s\n",
+                 threads,
+                 count,
+                 compacter->copy_rate.load());
+      compacter.reset();
+      boost::filesystem::remove_all(getPathString());
+      boost::filesystem::create_directory(getPathString());
+    }
+  }
 }  // namespace fc::storage::compacter
@@ -0,0 +1,339 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "storage/chain/msg_index.hpp"
+
+#include <gtest/gtest.h>
+#include <boost/asio/io_context.hpp>
+
+#include "adt/array.hpp"
+#include "api/full_node/make.hpp"
+#include "cbor_blake/ipld_cbor.hpp"
+#include "cbor_blake/ipld_version.hpp"
+#include "primitives/cid/cid_of_cbor.hpp"
+#include "primitives/tipset/load.hpp"
+#include "storage/chain/msg_waiter.hpp"
+#include "storage/in_memory/in_memory_storage.hpp"
+#include "storage/ipfs/impl/in_memory_datastore.hpp"
+#include "testutil/literals.hpp"
+#include "testutil/outcome.hpp"
+#include "vm/state/impl/state_tree_impl.hpp"
+
+namespace fc::storage::blockchain {
+  using primitives::block::MsgMeta;
+  using primitives::block::Ticket;
+  using primitives::tipset::Tipset;
+  using primitives::tipset::TsLoadIpld;
+  using vm::VMExitCode;
+  using vm::message::UnsignedMessage;
+
+  constexpr uint64_t kA{100};
+  constexpr uint64_t kB{101};
+  constexpr uint64_t kC{102};
+
+  inline UnsignedMessage message(uint64_t from, uint64_t to, uint64_t nonce) {
+    return {Address::makeFromId(to),
+            Address::makeFromId(from),
+            nonce,
+            0,
+            0,
+            0,
+            0,
+            {}};
+  }
+
+  inline std::vector<CID> cids(const std::vector<MsgIndex::Listed> &listed) {
+    std::vector<CID> cids;
+    for (const auto &item : listed) {
+      cids.push_back(item.cid);
+    }
+    return cids;
+  }
+
+  struct MsgIndexTest : testing::Test {
+    struct ChainStore : blockchain::ChainStore {
+      outcome::result<void> addBlock(const BlockHeader &) override {
+        throw "unused";
+      }
+      TipsetCPtr heaviestTipset() const override {
+        throw "unused";
+      }
+      boost::signals2::signal<HeadChangeSignature> signal;
+      connection_t subscribeHeadChanges(
+          const std::function<HeadChangeSignature> &subscriber) override {
+        return signal.connect(subscriber);
+      }
+      primitives::BigInt getHeaviestWeight() const override {
+        throw "unused";
+      }
+    };
+
+    /**
+     * Makes tipset of one block.
+     * Receipts of executed parent messages contain message cid.
+     */
+    TipsetCPtr makeTipset(const TipsetCPtr &parent,
+                          uint64_t miner,
+                          const std::vector<UnsignedMessage> &messages) {
+      MsgMeta meta;
+      cbor_blake::cbLoadT(ipld, meta);
+      for (const auto &message : messages) {
+        EXPECT_OUTCOME_TRUE_1(
+            meta.bls_messages.append(setCbor(ipld, message).value()));
+      }
+      adt::Array<MessageReceipt> receipts{ipld};
+      BlockHeader block;
+      block.miner = Address::makeFromId(miner);
+      block.ticket = Ticket{Bytes(96, miner)};
+      if (parent) {
+        block.parents.assign(parent->key.cids().begin(),
+                             parent->key.cids().end());
+        block.height = parent->epoch() + 1;
+        EXPECT_OUTCOME_TRUE_1(parent->visitMessages(
+            {ipld, true, false},
+            [&](auto, auto, auto &cid, auto, auto) {
+              return receipts.append(
+                  {VMExitCode::kOk, cid.toBytes().value(), 0});
+            }));
+      }
+      block.parent_state_root = state_root;
+      block.parent_message_receipts = receipts.amt.flush().value();
+      block.messages = setCbor(ipld, meta).value();
+      EXPECT_OUTCOME_TRUE_1(setCbor(ipld, block));
+      return Tipset::create({block}).value();
+    }
+
+    void SetUp() override {
+      vm::state::StateTreeImpl tree{withVersion(ipld, ChainEpoch{0})};
+      for (const auto id : {kA, kB, kC}) {
+        vm::actor::Actor actor;
+        actor.code = actor.head = "010001020001"_cid;
+        actor.nonce = 10;
+        EXPECT_OUTCOME_TRUE_1(tree.set(Address::makeFromId(id), actor));
+      }
+      state_root = tree.flush().value();
+
+      genesis = makeTipset(nullptr, 0, {});
+      ts1 = makeTipset(genesis, 0, {m1, m2, m3});
+      ts2 = makeTipset(ts1, 0, {m4});
+      ts3 = makeTipset(ts2, 0, {m6});
+      ts2b = makeTipset(ts1, 1, {m5});
+      ts3b = makeTipset(ts2b, 1, {});
+    }
+
+    /** receipt of executed message contains its cid */
+    static void expectFound(const boost::optional<MsgIndex::Found> &found,
+                            const CID &cid,
+                            const TipsetCPtr &ts,
+                            uint64_t index) {
+      ASSERT_TRUE(found);
+      EXPECT_EQ(found->tsk, ts->key);
+      EXPECT_EQ(found->height, ts->epoch());
+      EXPECT_EQ(found->index, index);
+      EXPECT_EQ(found->receipt.return_value, cid.toBytes().value());
+    }
+
+    IpldPtr ipld{std::make_shared<ipfs::InMemoryDatastore>()};
+    TsLoadPtr ts_load{std::make_shared<TsLoadIpld>(ipld)};
+    MapPtr map{std::make_shared<InMemoryStorage>()};
+    std::shared_ptr<ChainStore> chain_store{std::make_shared<ChainStore>()};
+    std::shared_ptr<boost::asio::io_context> io{
+        std::make_shared<boost::asio::io_context>()};
+    CID state_root;
+
+    UnsignedMessage m1{message(kA, kB, 0)};
+    /** invalid nonce, included but not executed */
+    UnsignedMessage m2{message(kA, kB, 2)};
+    UnsignedMessage m3{message(kC, kA, 0)};
+    UnsignedMessage m4{message(kA, kB, 1)};
+    UnsignedMessage m5{message(kA, kC, 1)};
+    /** included in head, not indexed */
+    UnsignedMessage m6{message(kA, kB, 3)};
+    CID cid1{primitives::cid::getCidOfCbor(m1).value()};
+    CID cid2{primitives::cid::getCidOfCbor(m2).value()};
+    CID cid3{primitives::cid::getCidOfCbor(m3).value()};
+    CID cid4{primitives::cid::getCidOfCbor(m4).value()};
+    CID cid5{primitives::cid::getCidOfCbor(m5).value()};
+    CID cid6{primitives::cid::getCidOfCbor(m6).value()};
+    Address a{Address::makeFromId(kA)};
+    Address b{Address::makeFromId(kB)};
+
+    /** genesis <- ts1 <- ts2 <- ts3, ts1 <- ts2b <- ts3b */
+    TipsetCPtr genesis, ts1, ts2, ts3, ts2b, ts3b;
+  };
+
+  /**
+   * @given chain with fork
+   * @when tipsets are applied, then index is moved to fork
+   * @then messages are found in tipsets where they were executed, address
+   * index lists all included messages, messages of reverted tipsets are
+   * removed
+   */
+  TEST_F(MsgIndexTest, ApplyRevert) {
+    MsgIndex index{map, ts_load, ipld};
+    EXPECT_OUTCOME_TRUE_1(index.update(genesis));
+    for (const auto &ts : {ts1, ts2, ts3}) {
+      EXPECT_OUTCOME_TRUE_1(index.apply(ts));
+    }
+    EXPECT_EQ(index.head()->key, ts3->key);
+    expectFound(index.find(cid1).value(), cid1, ts2, 0);
+    expectFound(index.find(cid3).value(), cid3, ts2, 1);
+    expectFound(index.find(cid4).value(), cid4, ts3, 0);
+    EXPECT_FALSE(index.find(cid2).value());
+    EXPECT_FALSE(index.find(cid6).value());
+    EXPECT_EQ(cids(index.list(a, 0).value()),
+              (std::vector<CID>{cid1, cid2, cid3, cid4}));
+    EXPECT_EQ(cids(index.list(b, 0).value()),
+              (std::vector<CID>{cid1, cid2, cid4}));
+    EXPECT_EQ(cids(index.list(a, 2).value()), (std::vector<CID>{cid4}));
+
+    // reorg
+    EXPECT_OUTCOME_TRUE_1(index.update(ts3b));
+    EXPECT_EQ(index.head()->key, ts3b->key);
+    expectFound(index.find(cid1).value(), cid1, ts2b, 0);
+    expectFound(index.find(cid5).value(), cid5, ts3b, 0);
+    EXPECT_FALSE(index.find(cid4).value());
+    EXPECT_EQ(cids(index.list(a, 0).value()),
+              (std::vector<CID>{cid1, cid2, cid3, cid5}));
+    EXPECT_EQ(cids(index.list(b, 0).value()),
+              (std::vector<CID>{cid1, cid2}));
+  }
+
+  /**
+   * @given fork including executed message again with invalid nonce
+   * @when index is moved from fork
+   * @then address keys of reverted inclusion are removed
+   */
+  TEST_F(MsgIndexTest, RevertIncludedAgain) {
+    const auto ts2c{makeTipset(ts1, 2, {m4, m1})};
+    const auto ts3c{makeTipset(ts2c, 2, {})};
+    MsgIndex index{map, ts_load, ipld};
+    EXPECT_OUTCOME_TRUE_1(index.update(ts3c));
+    EXPECT_OUTCOME_EQ(index.backfill(10), false);
+    EXPECT_EQ(cids(index.list(b, 0).value()),
+              (std::vector<CID>{cid1, cid2, cid4, cid1}));
+
+    EXPECT_OUTCOME_TRUE_1(index.update(ts3b));
+    expectFound(index.find(cid1).value(), cid1, ts2b, 0);
+    EXPECT_EQ(cids(index.list(b, 0).value()),
+              (std::vector<CID>{cid1, cid2}));
+  }
+
+  /**
+   * @given empty index
+   * @when index is moved to head and backfilled
+   * @then tipsets below head are indexed, index persists
+   */
+  TEST_F(MsgIndexTest, Backfill) {
+    MsgIndex index{map, ts_load, ipld};
+    EXPECT_OUTCOME_TRUE_1(index.update(ts3));
+    EXPECT_EQ(index.bottomHeight(), 3);
+    EXPECT_FALSE(index.find(cid4).value());
+
+    EXPECT_OUTCOME_EQ(index.backfill(1), true);
+    EXPECT_EQ(index.bottomHeight(), 2);
+    expectFound(index.find(cid4).value(), cid4, ts3, 0);
+    EXPECT_FALSE(index.find(cid1).value());
+
+    EXPECT_OUTCOME_EQ(index.backfill(10), false);
+    EXPECT_EQ(index.bottomHeight(), 0);
+    expectFound(index.find(cid1).value(), cid1, ts2, 0);
+    EXPECT_EQ(cids(index.list(a, 0).value()),
+              (std::vector<CID>{cid1, cid2, cid3, cid4}));
+
+    MsgIndex index2{map, ts_load, ipld};
+    EXPECT_OUTCOME_TRUE_1(index2.update(ts3));
+    EXPECT_EQ(index2.bottomHeight(), 0);
+    expectFound(index2.find(cid1).value(), cid1, ts2, 0);
+  }
+
+  /**
+   * @given waiter with index following head changes
+   * @when messages are searched and listed
+   * @then searches from head are answered from index without walking
+   * tipsets, list is sorted by descending height
+   */
+  TEST_F(MsgIndexTest, Waiter) {
+    auto waiter{MsgWaiter::create(ts_load, ipld, io, chain_store, map)};
+    chain_store->signal({{HeadChangeType::CURRENT, ts3}});
+    // backfill
+    io->run();
+
+    auto search{[&](const TipsetCPtr &ts, const CID &cid) {
+      boost::optional<TipsetCPtr> found;
+      waiter->search(ts, cid, -1, [&](auto found_ts, auto) {
+        found = std::move(found_ts);
+      });
+      // io is not run, so search didn't walk tipsets
+      EXPECT_TRUE(found);
+      return found ? *found : nullptr;
+    }};
+    EXPECT_EQ(search(ts3, cid1)->key, ts2->key);
+    EXPECT_EQ(search(ts3, cid4)->key, ts3->key);
+    EXPECT_FALSE(search(ts3, cid2));
+
+    EXPECT_EQ(cids(waiter->list(ts3, a, 0).value()),
+              (std::vector<CID>{cid4, cid1, cid2, cid3}));
+    EXPECT_FALSE(waiter->list(ts2, a, 0));
+
+    chain_store->signal({{HeadChangeType::REVERT, ts3},
+                         {HeadChangeType::REVERT, ts2},
+                         {HeadChangeType::APPLY, ts2b},
+                         {HeadChangeType::APPLY, ts3b}});
+    EXPECT_EQ(search(ts3b, cid5)->key, ts3b->key);
+    EXPECT_EQ(search(ts3b, cid1)->key, ts2b->key);
+    EXPECT_EQ(cids(waiter->list(ts3b, a, 0).value()),
+              (std::vector<CID>{cid5, cid1, cid2, cid3}));
+  }
+
+  /**
+   * @given waiters with and without index
+   * @when StateListMessages is called
+   * @then index returns same messages as walking tipsets
+   */
+  TEST_F(MsgIndexTest, StateListMessages) {
+    auto indexed{MsgWaiter::create(ts_load, ipld, io, chain_store, map)};
+    auto walking{MsgWaiter::create(ts_load, ipld, io, chain_store)};
+    chain_store->signal({{HeadChangeType::CURRENT, ts3}});
+    io->run();
+
+    vm::runtime::EnvironmentContext env_context;
+    env_context.ipld = ipld;
+    env_context.ts_load = ts_load;
+    auto tipset_context{[&](const TipsetKey &tsk, bool)
+                            -> outcome::result<api::TipsetContext> {
+      OUTCOME_TRY(ts, ts_load->load(tsk));
+      return api::TipsetContext{
+          ts,
+          {withVersion(ipld, ts->epoch()), ts->getParentStateRoot()},
+          boost::none};
+    }};
+    auto list{[&](const std::shared_ptr<MsgWaiter> &waiter) {
+      auto api{api::makeImpl(std::make_shared<api::FullNodeApi>(),
+                             nullptr,
+                             nullptr,
+                             "",
+                             nullptr,
+                             env_context,
+                             nullptr,
+                             nullptr,
+                             waiter,
+                             nullptr,
+                             nullptr,
+                             nullptr,
+                             nullptr,
+                             nullptr,
+                             nullptr,
+                             tipset_context)};
+      UnsignedMessage match;
+      match.from = a;
+      match.to = b;
+      return api->StateListMessages(match, ts3->key, 1).value();
+    }};
+    const std::vector<CID> expected{cid6, cid4, cid1, cid2};
+    EXPECT_EQ(list(walking), expected);
+    EXPECT_EQ(list(indexed), expected);
+  }
+}  // namespace fc::storage::blockchain
@@ -5,7 +5,10 @@
 
 #include "storage/hamt/hamt.hpp"
 
+#include <fmt/format.h>
 #include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
 
 #include "storage/ipfs/impl/in_memory_datastore.hpp"
 #include "testutil/cbor.hpp"
@@ -153,4 +156,114 @@ namespace fc::storage::hamt {
     EXPECT_OUTCOME_TRUE_1(set(hamt_, "element", "01"_unhex));
     EXPECT_OUTCOME_EQ(has(hamt_, "element"), true);
   }
+
+  /**
+   * @given hamts loaded from same root
+   * @when modify one of them
+   * @then shared cached nodes are not modified
+   */
+  TEST_F(HamtTest, NodeCacheCopyOnWrite) {
+    std::vector<std::string> keys;
+    for (auto i{0}; i < 100; ++i) {
+      keys.push_back(std::to_string(i));
+      EXPECT_OUTCOME_TRUE_1(set(hamt_, keys.back(), "01"_unhex));
+    }
+    EXPECT_OUTCOME_TRUE(cid, hamt_.flush());
+
+    const auto hits{nodeCache().hits.load()};
+    Hamt hamt1{store_, cid, 8};
+    Hamt hamt2{store_, cid, 8};
+    EXPECT_OUTCOME_EQ(get(hamt2, keys[0]), "01"_unhex);
+    for (const auto &key : keys) {
+      EXPECT_OUTCOME_TRUE_1(set(hamt1, key, "02"_unhex));
+    }
+    EXPECT_OUTCOME_TRUE_1(remove(hamt1, keys[1]));
+    for (const auto &key : keys) {
+      EXPECT_OUTCOME_EQ(get(hamt2, key), "01"_unhex);
+    }
+    EXPECT_OUTCOME_EQ(get(hamt1, keys[0]), "02"_unhex);
+    EXPECT_GT(nodeCache().hits, hits);
+
+    Hamt hamt3{store_, cid, 8};
+    EXPECT_OUTCOME_EQ(get(hamt3, keys[1]), "01"_unhex);
+  }
+
+  /**
+   * @given hamt root shared by node cache
+   * @when several threads get and visit it at same time
+   * @then values are found and cached nodes keep links as cids
+   */
+  TEST_F(HamtTest, NodeCacheConcurrentRead) {
+    std::vector<std::string> keys;
+    for (auto i{0}; i < 1000; ++i) {
+      keys.push_back(std::to_string(i));
+      EXPECT_OUTCOME_TRUE_1(set(hamt_, keys.back(), "01"_unhex));
+    }
+    EXPECT_OUTCOME_TRUE(cid, hamt_.flush());
+
+    std::vector<std::thread> threads;
+    std::atomic_size_t found{};
+    for (auto t{0}; t < 8; ++t) {
+      threads.emplace_back([&] {
+        Hamt hamt{store_, cid, 8};
+        for (const auto &key : keys) {
+          const auto result{get(hamt, key)};
+          if (result && result.value() == "01"_unhex) {
+            ++found;
+          }
+        }
+        EXPECT_OUTCOME_TRUE_1(hamt.visit([&](auto, auto) {
+          ++found;
+          return outcome::success();
+        }));
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(found, 2 * 8 * keys.size());
+
+    EXPECT_OUTCOME_TRUE(root, nodeCache().load(store_, cid));
+    EXPECT_TRUE(root->cached);
+    for (const auto &item : root->items.values) {
+      EXPECT_FALSE(common::which<Node::Ptr>(item));
+    }
+  }
+
+  /**
+   * Reports get, set and flush rates of hamt with state tree size.
+   */
+  TEST_F(HamtTest, DISABLED_Rate) {
+    // estimated, actors count of state tree
+    constexpr size_t kKeys{1 << 20};
+    std::vector<Bytes> keys;
+    for (size_t i{0}; i < kKeys; ++i) {
+      keys.push_back(Bytes(codec::cbor::encode(i).value()));
+    }
+    auto rate{[&](std::string_view name, auto &&f) {
+      const auto start{std::chrono::steady_clock::now()};
+      f();
+      const std::chrono::duration<double> seconds{
+          std::chrono::steady_clock::now() - start};
+      fmt::print("{} rate={:.0f} keys/s\n", name, kKeys / seconds.count());
+    }};
+    rate("set", [&] {
+      for (const auto &key : keys) {
+        EXPECT_OUTCOME_TRUE_1(hamt_.set(key, "01"_unhex));
+      }
+    });
+    rate("get", [&] {
+      for (const auto &key : keys) {
+        EXPECT_OUTCOME_TRUE_1(hamt_.get(key));
+      }
+    });
+    CID cid;
+    rate("flush", [&] { cid = hamt_.flush().value(); });
+    rate("get flushed", [&] {
+      Hamt hamt{store_, cid, 5};
+      for (const auto &key : keys) {
+        EXPECT_OUTCOME_TRUE_1(hamt.get(key));
+      }
+    });
+  }
 }  // namespace fc::storage::hamt
@@ -0,0 +1,119 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "storage/ipld/block_cache.hpp"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "cbor_blake/memory.hpp"
+
+namespace fc::storage::ipld {
+  /** counts reads of inner ipld */
+  struct CountingCbIpld : MemoryCbIpld {
+    bool get(const CbCid &key, Bytes *value) const override {
+      if (value != nullptr) {
+        ++reads;
+      }
+      return MemoryCbIpld::get(key, value);
+    }
+
+    mutable std::atomic_size_t reads{};
+  };
+
+  struct BlockCacheTest : testing::Test {
+    std::vector<CbCid> putBlocks(size_t count, size_t size) {
+      std::vector<CbCid> keys;
+      for (size_t i{0}; i < count; ++i) {
+        Bytes value(size);
+        std::memcpy(value.data(), &i, sizeof(i));
+        keys.push_back(inner->CbIpld::put(std::move(value)));
+      }
+      return keys;
+    }
+
+    std::shared_ptr<CountingCbIpld> inner{std::make_shared<CountingCbIpld>()};
+  };
+
+  /**
+   * @given cache over ipld
+   * @when get same block twice
+   * @then second get is served from cache without copy of shared value
+   */
+  TEST_F(BlockCacheTest, SharedHit) {
+    const auto keys{putBlocks(1, 100)};
+    CachedCbIpld cache{inner, 1 << 20};
+    const auto value1{cache.getShared(keys[0])};
+    const auto value2{cache.getShared(keys[0])};
+    ASSERT_TRUE(value1);
+    EXPECT_EQ(value1, value2);
+    EXPECT_EQ(*value1, inner->map.at(keys[0]));
+    Bytes value3;
+    EXPECT_TRUE(cache.get(keys[0], value3));
+    EXPECT_EQ(value3, *value1);
+    EXPECT_EQ(inner->reads, 1);
+    EXPECT_EQ(cache.hits, 2);
+    EXPECT_EQ(cache.misses, 1);
+    EXPECT_EQ(cache.bytes(), 100);
+
+    CbCid missing;
+    EXPECT_FALSE(cache.getShared(missing));
+    EXPECT_FALSE(cache.has(missing));
+  }
+
+  /**
+   * @given cache smaller than blocks
+   * @when get blocks repeatedly, one block is referenced between gets
+   * @then cache stays within limit and referenced block is not evicted
+   */
+  TEST_F(BlockCacheTest, Evict) {
+    const auto keys{putBlocks(1000, 100)};
+    CachedCbIpld cache{inner, CachedCbIpld::kShards * 1000};
+    for (const auto &key : keys) {
+      cache.getShared(key);
+      cache.getShared(keys[0]);
+      EXPECT_LE(cache.bytes(), CachedCbIpld::kShards * 1000);
+    }
+    const auto reads{inner->reads.load()};
+    cache.getShared(keys[0]);
+    EXPECT_EQ(inner->reads, reads);
+  }
+
+  /**
+   * Reports hit rate and get rate of cache shared by threads.
+   */
+  TEST_F(BlockCacheTest, DISABLED_GetRate) {
+    const auto keys{putBlocks(1 << 16, 256)};
+    for (const size_t threads : {1, 2, 4, 8}) {
+      // estimated, quarter of blocks fit
+      CachedCbIpld cache{inner, keys.size() * 256 / 4};
+      constexpr size_t kGets{1 << 20};
+      const auto start{std::chrono::steady_clock::now()};
+      std::vector<std::thread> workers;
+      for (size_t t{0}; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+          std::mt19937_64 random{t};
+          // skewed access, like recent state
+          std::geometric_distribution<size_t> index{8.0 / keys.size()};
+          for (size_t i{0}; i < kGets / threads; ++i) {
+            cache.getShared(keys[index(random) % keys.size()]);
+          }
+        });
+      }
+      for (auto &worker : workers) {
+        worker.join();
+      }
+      const std::chrono::duration<double> seconds{
+          std::chrono::steady_clock::now() - start};
+      fmt::print("threads={} hit_rate={:.3f} rate={:.0f} gets/s\n",
+                 threads,
+                 cache.hitRate(),
+                 kGets / seconds.count());
+    }
+  }
+}  // namespace fc::storage::ipld
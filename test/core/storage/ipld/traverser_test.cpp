@@ -0,0 +1,200 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "storage/ipld/traverser.hpp"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <chrono>
+
+#include "codec/cbor/cbor_codec.hpp"
+#include "storage/ipfs/impl/in_memory_datastore.hpp"
+
+namespace fc::storage::ipld::traverser {
+  using codec::cbor::CborEncodeStream;
+  using ipfs::InMemoryDatastore;
+
+  /** encodes map with single key, selectors are encoded as such maps */
+  CborEncodeStream one(const std::string &key, const CborEncodeStream &value) {
+    auto m{CborEncodeStream::map()};
+    m[key] << value;
+    CborEncodeStream s;
+    s << m;
+    return s;
+  }
+
+  CborEncodeStream empty() {
+    CborEncodeStream s;
+    s << CborEncodeStream::map();
+    return s;
+  }
+
+  CborEncodeStream matcher() {
+    return one(".", empty());
+  }
+
+  CborEncodeStream edge() {
+    return one("@", empty());
+  }
+
+  CborEncodeStream all(const CborEncodeStream &next) {
+    return one("a", one(">", next));
+  }
+
+  CborEncodeStream fields(const std::string &name,
+                          const CborEncodeStream &next) {
+    return one("f", one("f>", one(name, next)));
+  }
+
+  CborEncodeStream index(uint64_t i, const CborEncodeStream &next) {
+    auto m{CborEncodeStream::map()};
+    m["i"] << i;
+    m[">"] << next;
+    CborEncodeStream s;
+    s << m;
+    return one("i", s);
+  }
+
+  CborEncodeStream range(uint64_t start,
+                         uint64_t end,
+                         const CborEncodeStream &next) {
+    auto m{CborEncodeStream::map()};
+    m["^"] << start;
+    m["$"] << end;
+    m[">"] << next;
+    CborEncodeStream s;
+    s << m;
+    return one("r", s);
+  }
+
+  CborEncodeStream recursive(boost::optional<uint64_t> depth,
+                             const CborEncodeStream &sequence) {
+    auto limit{CborEncodeStream::map()};
+    if (depth) {
+      limit["depth"] << *depth;
+    } else {
+      limit["none"] << CborEncodeStream::map();
+    }
+    auto m{CborEncodeStream::map()};
+    m["l"] << limit;
+    m[":>"] << sequence;
+    CborEncodeStream s;
+    s << m;
+    return one("R", s);
+  }
+
+  struct TraverserTest : testing::Test {
+    /** puts node {"links": [...]} */
+    CID put(const std::vector<CID> &links) {
+      std::map<std::string, std::vector<CID>> node{{"links", links}};
+      auto bytes{codec::cbor::encode(node).value()};
+      auto cid{common::getCidOf(bytes).value()};
+      EXPECT_TRUE(ipld.set(cid, std::move(bytes)));
+      return cid;
+    }
+
+    /** puts tree of given depth and width, returns nodes in dfs order */
+    std::vector<CID> putTree(size_t depth, size_t width) {
+      std::vector<CID> order;
+      std::vector<CID> children;
+      if (depth != 0) {
+        for (size_t i{0}; i < width; ++i) {
+          auto subtree{putTree(depth - 1, width)};
+          children.push_back(subtree[0]);
+          order.insert(order.end(), subtree.begin(), subtree.end());
+        }
+      }
+      order.insert(order.begin(), put(children));
+      return order;
+    }
+
+    std::vector<CID> traverse(const CID &root,
+                              const CborEncodeStream &selector) {
+      Traverser traverser{ipld, root, Selector{selector.data()}, false};
+      return traverser.traverseAll().value();
+    }
+
+    InMemoryDatastore ipld;
+  };
+
+  /**
+   * @given tree of nodes
+   * @when traversed with explore all selector
+   * @then all nodes are visited in dfs order
+   */
+  TEST_F(TraverserTest, All) {
+    const auto tree{putTree(2, 3)};
+    EXPECT_EQ(traverse(tree[0], recursive({}, all(edge()))), tree);
+    Traverser traverser{ipld, tree[0], kAllSelector, true};
+    EXPECT_EQ(traverser.traverseAll().value(), tree);
+  }
+
+  /**
+   * @given tree of nodes
+   * @when traversed with fields, index, range and union selectors
+   * @then only selected children are visited
+   */
+  TEST_F(TraverserTest, FieldsIndexRange) {
+    const auto tree{putTree(1, 4)};
+    EXPECT_EQ(traverse(tree[0], fields("links", index(1, matcher()))),
+              (std::vector<CID>{tree[0], tree[2]}));
+    EXPECT_EQ(traverse(tree[0], fields("links", range(1, 3, matcher()))),
+              (std::vector<CID>{tree[0], tree[2], tree[3]}));
+    EXPECT_EQ(traverse(tree[0], fields("other", all(matcher()))),
+              (std::vector<CID>{tree[0]}));
+    auto members{CborEncodeStream::list()};
+    members << index(0, matcher()) << index(3, matcher());
+    EXPECT_EQ(traverse(tree[0], fields("links", one("|", members))),
+              (std::vector<CID>{tree[0], tree[1], tree[4]}));
+  }
+
+  /**
+   * @given tree of depth 3
+   * @when traversed with recursive selector limited by depth
+   * @then only nodes above depth are visited
+   */
+  TEST_F(TraverserTest, RecursiveDepth) {
+    const auto tree{putTree(3, 2)};
+    const auto sequence{fields("links", all(edge()))};
+    EXPECT_EQ(traverse(tree[0], recursive(1, sequence)),
+              (std::vector<CID>{tree[0]}));
+    EXPECT_EQ(traverse(tree[0], recursive(2, sequence)),
+              (std::vector<CID>{tree[0], tree[1], tree[8]}));
+    EXPECT_EQ(traverse(tree[0], recursive(3, sequence)).size(), 7);
+    EXPECT_EQ(traverse(tree[0], recursive({}, sequence)), tree);
+  }
+
+  /**
+   * @given invalid and unsupported selectors
+   * @when parsed
+   * @then errors are returned, traverser explores all
+   */
+  TEST_F(TraverserTest, InvalidSelector) {
+    EXPECT_EQ(parseSelector(edge().data()).error(), SelectorError::kInvalid);
+    EXPECT_EQ(parseSelector(one("~", empty()).data()).error(),
+              SelectorError::kUnsupported);
+    EXPECT_FALSE(parseSelector(Bytes{0xff}));
+    const auto tree{putTree(1, 2)};
+    EXPECT_EQ(traverse(tree[0], CborEncodeStream{}), tree);
+  }
+
+  /**
+   * Reports throughput of traversing large tree with explore all selector.
+   */
+  TEST_F(TraverserTest, DISABLED_Throughput) {
+    const auto tree{putTree(6, 8)};
+    const auto start{std::chrono::steady_clock::now()};
+    Traverser traverser{ipld, tree[0], kAllSelector, false};
+    size_t blocks{};
+    while (!traverser.isCompleted()) {
+      EXPECT_TRUE(traverser.advanceBlock());
+      ++blocks;
+    }
+    const std::chrono::duration<double> seconds{
+        std::chrono::steady_clock::now() - start};
+    EXPECT_EQ(blocks, tree.size());
+    fmt::print("{} blocks {:.0f}blocks/s\n", blocks, blocks / seconds.count());
+  }
+}  // namespace fc::storage::ipld::traverser
@@ -12,6 +12,7 @@
 #include "storage/mpool/mpool.hpp"
 #include "testutil/resources/resources.hpp"
 #include "vm/interpreter/interpreter.hpp"
+#include "vm/state/impl/state_tree_impl.hpp"
 
 #define AUTO(l, ...)        \
   decltype(__VA_ARGS__) l { \
@@ -137,4 +138,71 @@ namespace fc::storage::mpool {
   INSTANTIATE_TEST_SUITE_P(MpoolSelectQualityTest,
                            MpoolSelectQualityTest,
                            ::testing::Values(0.8, 0.9));
+
+  /**
+   * Adds count messages, copies of msgs0 with next nonces of their senders.
+   */
+  void addPending(Fixture &fix, size_t count) {
+    vm::state::StateTreeImpl state_tree{withVersion(ipld, ts1->height()),
+                                        ts0->getParentStateRoot()};
+    std::map<Address, SignedMessage> senders;
+    for (const auto &msg : msgs0) {
+      senders.emplace(msg.message.from, msg);
+    }
+    for (auto &[from, msg] : senders) {
+      msg.message.nonce = state_tree.get(from).value().nonce;
+    }
+    for (size_t i{0}; i < count;) {
+      for (auto &[from, msg] : senders) {
+        if (i++ == count) {
+          break;
+        }
+        fix.mpool->add(msg).value();
+        ++msg.message.nonce;
+      }
+    }
+  }
+
+  TEST(MpoolPrune, Limit) {
+    Fixture fix;
+    fix.setHead(ts1);
+    cacheParentState(ts0);
+    fix.mpool->size_limit_high = 20;
+    fix.mpool->size_limit_low = 10;
+    addPending(fix, 20);
+    EXPECT_EQ(fix.mpool->pendingCount(), 20);
+    fix.mpool->pruneMessages().value();
+    EXPECT_EQ(fix.mpool->pendingCount(), 20);
+
+    // next message is over limit
+    addPending(fix, 21);
+    EXPECT_LE(fix.mpool->pendingCount(), 10);
+    // cached chains are dropped with pruned messages
+    EXPECT_FALSE(fix.mpool->select(ts1, 0.9).value().empty());
+  }
+
+  /**
+   * Benchmark of select with 50k pending messages, cold and with cached
+   * chains.
+   * Run with --gtest_also_run_disabled_tests.
+   */
+  TEST(MpoolSelect, DISABLED_Pending50k) {
+    constexpr size_t kPending{50000};
+    Fixture fix;
+    fix.setHead(ts1);
+    cacheParentState(ts0);
+    fix.mpool->size_limit_high = 2 * kPending;
+    addPending(fix, kPending);
+    for (const auto *name : {"cold", "cached"}) {
+      const auto begin{std::chrono::steady_clock::now()};
+      const auto selected{fix.mpool->select(ts1, 0.5).value()};
+      const std::chrono::duration<double, std::milli> ms{
+          std::chrono::steady_clock::now() - begin};
+      fmt::print("{} select: {} of {} messages, {:.1f} ms\n",
+                 name,
+                 selected.size(),
+                 kPending,
+                 ms.count());
+    }
+  }
 }  // namespace fc::storage::mpool
@@ -272,7 +272,9 @@ struct TestVectors : testing::TestWithParam<MessageVector> {
   }
 };
 
-void testTipsets(const MessageVector &mv, const IpldPtr &ipld) {
+void testTipsets(const MessageVector &mv,
+                 const IpldPtr &ipld,
+                 size_t speculative_threads) {
   using namespace fc;
   for (const auto &precondition : mv.precondition_variants) {
     std::shared_ptr<Invoker> invoker = std::make_shared<InvokerImpl>();
@@ -282,6 +284,7 @@ void testTipsets(const MessageVector &mv, const IpldPtr &ipld) {
     fc::vm::runtime::EnvironmentContext env_context{
         ipld, invoker, randomness, ts_load};
     fc::vm::interpreter::InterpreterImpl vmi{env_context, nullptr, nullptr};
+    vmi.speculative_threads = speculative_threads;
     CID state{mv.state_before};
     BlockHeader parent;
     parent.ticket.emplace();
@@ -395,7 +398,9 @@ TEST_P(TestVectors, Vector) {
   OUTCOME_EXCEPT(fc::storage::car::loadCar(*ipld, mv.car));
 
   if (mv.type == "tipset") {
-    testTipsets(mv, ipld);
+    testTipsets(mv, ipld, 0);
+    // speculative execution must produce same state as serial
+    testTipsets(mv, ipld, 4);
   } else if (mv.type == "message") {
     testMessages(mv, ipld);
   } else {
@@ -0,0 +1,125 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "vm/actor/cgo/actors.hpp"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <chrono>
+
+#include "primitives/cid/cid.hpp"
+#include "storage/ipfs/impl/in_memory_datastore.hpp"
+#include "testutil/mocks/vm/runtime/runtime_mock.hpp"
+#include "vm/actor/cgo/c_actors.h"
+#include "vm/runtime/env.hpp"
+
+namespace fc::vm::actor::cgo {
+  using runtime::Execution;
+  using runtime::MockRuntime;
+  using storage::ipfs::InMemoryDatastore;
+
+  struct CgoActorsTest : testing::Test {
+    void SetUp() override {
+      execution = std::make_shared<Execution>();
+      execution->charging_ipld = std::make_shared<InMemoryDatastore>();
+      execution->gas_limit = 1000;
+      runtime = std::make_shared<MockRuntime>();
+      EXPECT_CALL(*runtime, execution())
+          .WillRepeatedly(testing::Return(execution));
+    }
+
+    std::shared_ptr<Execution> execution;
+    std::shared_ptr<MockRuntime> runtime;
+  };
+
+  constexpr auto kOk{static_cast<int64_t>(VMExitCode::kOk)};
+
+  /**
+   * @given runtime registered in slot table
+   * @when go calls binary abi callbacks
+   * @then gas is charged, blocks are put and borrowed back
+   */
+  TEST_F(CgoActorsTest, RawCallbacks) {
+    const std::shared_ptr<Runtime> rt{runtime};
+    const RuntimeHandle handle{rt};
+
+    EXPECT_EQ(gocRtChargeRaw(handle.id, 600), kOk);
+    EXPECT_EQ(execution->gas_used, 600);
+    EXPECT_EQ(gocRtChargeRaw(handle.id, 600),
+              static_cast<int64_t>(VMExitCode::kSysErrOutOfGas));
+
+    const Bytes value{1, 2, 3};
+    Raw key{};
+    EXPECT_EQ(gocRtIpldPutRaw(handle.id, cgoArg(value), &key), kOk);
+    const auto cid{CID::fromBytes(gocArg(key)).value()};
+    EXPECT_EQ(cid, common::getCidOf(value).value());
+
+    Raw got{};
+    EXPECT_EQ(gocRtIpldGetRaw(handle.id, cgoArg(cid.toBytes().value()), &got),
+              kOk);
+    EXPECT_EQ(copy(gocArg(got)), value);
+
+    const auto missing{common::getCidOf(Bytes{4}).value()};
+    EXPECT_EQ(
+        gocRtIpldGetRaw(handle.id, cgoArg(missing.toBytes().value()), &got),
+        static_cast<int64_t>(VMExitCode::kFatal));
+  }
+
+  /**
+   * @given nested runtimes
+   * @when they are registered
+   * @then each runtime gets own slot, slot is reused after handle is destroyed
+   */
+  TEST_F(CgoActorsTest, Slots) {
+    const std::shared_ptr<Runtime> rt{runtime};
+    const RuntimeHandle outer{rt};
+    {
+      const RuntimeHandle inner{rt};
+      EXPECT_NE(inner.id, outer.id);
+    }
+    for (size_t i{0}; i < 10000; ++i) {
+      const RuntimeHandle inner{rt};
+      EXPECT_NE(inner.id, outer.id);
+    }
+  }
+
+  /**
+   * Reports overhead of cbor and binary abi callbacks.
+   */
+  TEST_F(CgoActorsTest, DISABLED_CallbackOverhead) {
+    execution->gas_limit = std::numeric_limits<GasAmount>::max();
+    const std::shared_ptr<Runtime> rt{runtime};
+    const RuntimeHandle handle{rt};
+    const Bytes value(256, 1);
+    const auto cid{common::getCidOf(value).value()};
+    const auto key{cid.toBytes().value()};
+    execution->charging_ipld->set(cid, copy(value)).value();
+    constexpr size_t kCalls{1 << 20};
+    const auto report{[&](std::string_view name, auto &&call) {
+      const auto start{std::chrono::steady_clock::now()};
+      for (size_t i{0}; i < kCalls; ++i) {
+        call();
+      }
+      const std::chrono::duration<double, std::nano> ns{
+          std::chrono::steady_clock::now() - start};
+      fmt::print("{}: {:.0f} ns/call\n", name, ns.count() / kCalls);
+    }};
+    report("cbor charge", [&] {
+      CborEncodeStream arg;
+      arg << handle.id << GasAmount{1};
+      cgoRet(gocRtCharge(cgoArg(arg.data())));
+    });
+    report("raw charge", [&] { gocRtChargeRaw(handle.id, 1); });
+    report("cbor ipld get", [&] {
+      CborEncodeStream arg;
+      arg << handle.id << cid;
+      cgoRet(gocRtIpldGet(cgoArg(arg.data())));
+    });
+    report("raw ipld get", [&] {
+      Raw got{};
+      gocRtIpldGetRaw(handle.id, cgoArg(key), &got);
+    });
+  }
+}  // namespace fc::vm::actor::cgo
@@ -0,0 +1,134 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "vm/message/sig_verifier.hpp"
+
+#include <gtest/gtest.h>
+
+#include "crypto/bls/impl/bls_provider_impl.hpp"
+#include "crypto/secp256k1/impl/secp256k1_sha256_provider_impl.hpp"
+#include "storage/keystore/impl/in_memory/in_memory_keystore.hpp"
+#include "testutil/literals.hpp"
+#include "testutil/outcome.hpp"
+#include "vm/message/impl/message_signer_impl.hpp"
+
+namespace fc::vm::message {
+  using crypto::bls::BlsProviderImpl;
+  using crypto::secp256k1::Secp256k1Sha256ProviderImpl;
+  using storage::keystore::InMemoryKeyStore;
+
+  struct SigVerifierTest : testing::Test {
+    void SetUp() override {
+      auto bls{std::make_shared<BlsProviderImpl>()};
+      auto secp{std::make_shared<Secp256k1Sha256ProviderImpl>()};
+      auto keystore{std::make_shared<InMemoryKeyStore>(bls, secp)};
+      signer = std::make_shared<MessageSignerImpl>(keystore);
+      const auto bls_key{
+          "8e8c5263df0022d8e29cab943d57d851722c38ee1dbe7f8c29c0498156496f29"_blob32};
+      const auto secp_key{
+          "7008136b505aa01e406f72204668865852186756c95cd3a7e5184ef7b8f62058"_blob32};
+      bls_public = bls->derivePublicKey(bls_key).value();
+      bls_address = Address::makeBls(bls_public);
+      secp_address = Address::makeSecp256k1(secp->derive(secp_key).value());
+      keystore->put(bls_address, bls_key).value();
+      keystore->put(secp_address, secp_key).value();
+    }
+
+    SignedMessage sign(const Address &from, uint64_t nonce) {
+      UnsignedMessage msg{from, from, nonce, 1, 0, 1, {}, {}};
+      return signer->sign(from, msg).value();
+    }
+
+    std::shared_ptr<MessageSigner> signer;
+    Address bls_address;
+    crypto::bls::PublicKey bls_public{};
+    Address secp_address;
+  };
+
+  /**
+   * @given secp messages signed by sender
+   * @when verifying them in batch on worker threads
+   * @then batch is valid, signatures are cached, changed message is invalid
+   */
+  TEST_F(SigVerifierTest, Secp) {
+    SigVerifier verifier{2, kSigCacheSize, kSigRateLimit};
+    std::vector<SignedMessage> smsgs;
+    for (uint64_t nonce{0}; nonce < 100; ++nonce) {
+      smsgs.push_back(sign(secp_address, nonce));
+    }
+    std::vector<SigVerifier::Secp> items;
+    for (const auto &smsg : smsgs) {
+      items.push_back({smsg.getCid(), secp_address, &smsg});
+    }
+    EXPECT_OUTCOME_TRUE_1(verifier.verifySecp(items));
+    EXPECT_TRUE(verifier.verified(smsgs[0].getCid(), smsgs[0].signature));
+    EXPECT_FALSE(verifier.busy());
+
+    smsgs[50].message.nonce = 1000;
+    items[50].cid = smsgs[50].getCid();
+    EXPECT_OUTCOME_ERROR(MessageError::kVerificationFailure,
+                         verifier.verifySecp(items));
+  }
+
+  /**
+   * @given verifier with rate limit
+   * @when more messages than limit are verified
+   * @then verifier is busy, cached messages and blocks are not counted
+   */
+  TEST_F(SigVerifierTest, Busy) {
+    SigVerifier verifier{0, kSigCacheSize, 10};
+    std::vector<SignedMessage> smsgs;
+    for (uint64_t nonce{0}; nonce < 20; ++nonce) {
+      smsgs.push_back(sign(secp_address, nonce));
+    }
+    std::vector<SigVerifier::Secp> items;
+    for (const auto &smsg : smsgs) {
+      items.push_back({smsg.getCid(), secp_address, &smsg});
+    }
+    EXPECT_OUTCOME_TRUE_1(verifier.verifySecp(items));
+    for (const auto &smsg : smsgs) {
+      EXPECT_OUTCOME_TRUE_1(verifier.verify(secp_address, smsg));
+    }
+    EXPECT_FALSE(verifier.busy());
+
+    for (uint64_t nonce{20}; nonce < 40; ++nonce) {
+      EXPECT_OUTCOME_TRUE_1(
+          verifier.verify(secp_address, sign(secp_address, nonce)));
+    }
+    EXPECT_TRUE(verifier.busy());
+  }
+
+  /**
+   * @given bls messages signed by sender
+   * @when verifying aggregate of their signatures
+   * @then aggregate is valid with and without cached signatures, aggregate
+   * missing signature is invalid
+   */
+  TEST_F(SigVerifierTest, BlsAggregate) {
+    BlsProviderImpl bls;
+    std::vector<CID> cids;
+    std::vector<crypto::bls::PublicKey> keys;
+    std::vector<BlsSignature> signatures;
+    std::vector<SignedMessage> smsgs;
+    for (uint64_t nonce{0}; nonce < 3; ++nonce) {
+      const auto &smsg{smsgs.emplace_back(sign(bls_address, nonce))};
+      cids.push_back(smsg.getCid());
+      keys.push_back(bls_public);
+      signatures.push_back(boost::get<BlsSignature>(smsg.signature));
+    }
+    const Signature aggregate{bls.aggregateSignatures(signatures).value()};
+
+    SigVerifier verifier{0, kSigCacheSize, kSigRateLimit};
+    EXPECT_OUTCOME_TRUE_1(verifier.verifyBls(cids, keys, aggregate));
+    for (const auto &smsg : smsgs) {
+      EXPECT_OUTCOME_TRUE_1(verifier.verify(bls_address, smsg));
+    }
+    EXPECT_OUTCOME_TRUE_1(verifier.verifyBls(cids, keys, aggregate));
+
+    signatures.pop_back();
+    const Signature partial{bls.aggregateSignatures(signatures).value()};
+    EXPECT_OUTCOME_FALSE_1(verifier.verifyBls(cids, keys, partial));
+  }
+}  // namespace fc::vm::message
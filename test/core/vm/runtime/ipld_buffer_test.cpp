@@ -0,0 +1,90 @@
+/**
+ * Copyright Soramitsu Co., Ltd. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "vm/runtime/ipld_buffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include "codec/cbor/cbor_codec.hpp"
+
+namespace fc::vm::runtime {
+  /** encodes node linking to children */
+  Bytes node(size_t i, const std::vector<CbCid> &children = {}) {
+    std::vector<CID> cids;
+    for (const auto &child : children) {
+      cids.emplace_back(child);
+    }
+    codec::cbor::CborEncodeStream s;
+    auto l{s.list()};
+    l << i << cids;
+    s << l;
+    return s.data();
+  }
+
+  TEST(IpldBuffer, PutFind) {
+    IpldBuffer buffer;
+    std::vector<std::pair<CbCid, Bytes>> blocks;
+    // enough to grow table several times
+    for (size_t i{0}; i < 10000; ++i) {
+      auto value{node(i)};
+      blocks.emplace_back(CbCid::hash(value), std::move(value));
+    }
+    for (const auto &[key, value] : blocks) {
+      EXPECT_TRUE(buffer.put(key, value));
+    }
+    EXPECT_FALSE(buffer.put(blocks[0].first, blocks[1].second));
+    EXPECT_EQ(buffer.size(), blocks.size());
+    for (const auto &[key, value] : blocks) {
+      const auto *entry{buffer.find(key)};
+      ASSERT_TRUE(entry);
+      EXPECT_EQ(entry->key, key);
+      EXPECT_EQ(copy(entry->value), value);
+    }
+    EXPECT_FALSE(buffer.find(CbCid::hash(node(10000))));
+
+    buffer.clear();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_FALSE(buffer.find(blocks[0].first));
+  }
+
+  /**
+   * @given root linking to buffered and not buffered blocks
+   * @when reachable
+   * @then returns buffered blocks reachable from root, parents before children
+   */
+  TEST(IpldBuffer, Reachable) {
+    IpldBuffer buffer;
+    auto put{[&](Bytes value) {
+      const auto key{CbCid::hash(value)};
+      buffer.put(key, value);
+      return key;
+    }};
+    const auto missing{CbCid::hash(node(0))};
+    const auto unreachable{put(node(1))};
+    const auto leaf{put(node(2))};
+    const auto middle{put(node(3, {leaf, missing}))};
+    const auto root{put(node(4, {middle, leaf}))};
+
+    const auto *entry{buffer.find(middle)};
+    ASSERT_TRUE(entry);
+    const auto children{buffer.children(*entry)};
+    ASSERT_EQ(children.size(), 2);
+    EXPECT_EQ(*children[0], leaf);
+    EXPECT_EQ(*children[1], missing);
+
+    std::vector<CbCid> keys;
+    for (const auto *entry : buffer.reachable(root)) {
+      keys.push_back(entry->key);
+    }
+    EXPECT_EQ(keys, (std::vector<CbCid>{root, middle, leaf}));
+    EXPECT_TRUE(buffer.reachable(missing).empty());
+    EXPECT_TRUE(buffer.find(unreachable));
+
+    IpldBuffer other;
+    other.putAll(buffer);
+    EXPECT_EQ(other.size(), buffer.size());
+    EXPECT_EQ(other.reachable(root).size(), 3);
+  }
+}  // namespace fc::vm::runtime